@@ -24,6 +24,10 @@ DEBUG_VIA_SERIAL=
 #STACK_CHECK="--check-stack"
 STACK_CHECK=
 
+# text primitive benchmark: ALT-P races textfast.asm against the C it replaced (see textbench.c)
+#BENCHMARK_DEF="-DTEXTFAST_BENCHMARK"
+BENCHMARK_DEF=
+
 #optimization
 #OPTI=-Oirs
 OPTI=-Os
@@ -51,16 +55,23 @@ rm -r $BUILD_DIR/*.s
 rm -r $BUILD_DIR/*.o
 
 # compile
-cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T app.c -o $BUILD_DIR/app.s
+cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK $BENCHMARK_DEF -T app.c -o $BUILD_DIR/app.s
 cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T comm_buffer.c -o $BUILD_DIR/comm_buffer.s
 cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T debug.c -o $BUILD_DIR/debug.s
 cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T general.c -o $BUILD_DIR/general.s
 cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T keyboard.c -o $BUILD_DIR/keyboard.s
 cc65 -g --cpu $CC65CPU -t $CC65TGT --code-name OVERLAY_STARTUP $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T overlay_startup.c -o $BUILD_DIR/overlay_startup.s
+cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T scrollback.c -o $BUILD_DIR/scrollback.s
 cc65 -g --cpu $CC65CPU -t $CC65TGT --code-name OVERLAY_SCREEN $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T screen.c -o $BUILD_DIR/screen.s
 cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T serial.c -o $BUILD_DIR/serial.s
+cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T shadow.c -o $BUILD_DIR/shadow.s
+cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T staging.c -o $BUILD_DIR/staging.s
 cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T sys.c -o $BUILD_DIR/sys.s
 cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T text.c -o $BUILD_DIR/text.s
+cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK $BENCHMARK_DEF -T textbench.c -o $BUILD_DIR/textbench.s
+cc65 -g --cpu $CC65CPU -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T xmodem.c -o $BUILD_DIR/xmodem.s
+cc65 -g --cpu $CC65CPU -t $CC65TGT --code-name OVERLAY_ZMODEM $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T zmodem.c -o $BUILD_DIR/zmodem.s
+cc65 -g --cpu $CC65CPU -t $CC65TGT --code-name OVERLAY_ZMODEM_SEND $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS $DEBUG_DEF_1 $DEBUG_DEF_2 $DEBUG_DEF_3 $DEBUG_DEF_4 $DEBUG_DEF_5 $DEBUG_VIA_SERIAL $STACK_CHECK -T zmodem_send.c -o $BUILD_DIR/zmodem_send.s
 
 # Kernel access
 cc65 -g --cpu 65C02 -t $CC65TGT $OPTI -I $CONFIG_DIR $TARGET_DEFS $PLATFORM_DEFS -T kernel.c -o $BUILD_DIR/kernel.s
@@ -79,10 +90,17 @@ ca65 -t $CC65TGT debug.s
 ca65 -t $CC65TGT general.s
 ca65 -t $CC65TGT keyboard.s
 ca65 -t $CC65TGT overlay_startup.s
+ca65 -t $CC65TGT scrollback.s
 ca65 -t $CC65TGT screen.s
 ca65 -t $CC65TGT serial.s
+ca65 -t $CC65TGT shadow.s
+ca65 -t $CC65TGT staging.s
 ca65 -t $CC65TGT sys.s
 ca65 -t $CC65TGT text.s
+ca65 -t $CC65TGT textbench.s
+ca65 -t $CC65TGT xmodem.s
+ca65 -t $CC65TGT zmodem.s
+ca65 -t $CC65TGT zmodem_send.s
 
 # Kernel access
 ca65 -t $CC65TGT kernel.s -o kernel.o
@@ -90,14 +108,21 @@ ca65 -t $CC65TGT kernel.s -o kernel.o
 # name 'header'
 #ca65 -t $CC65TGT ../name.s -o name.o
 ca65 -t $CC65TGT ../memory.asm -o memory.o
+ca65 -t $CC65TGT ../interrupt.asm -o interrupt.o
+ca65 -t $CC65TGT ../textfast.asm -o textfast.o
+ca65 -t $CC65TGT ../crc16.asm -o crc16.o
+ca65 -t $CC65TGT ../crc32.asm -o crc32.o
 
 
 echo "\n**************************\nLD65 link start...\n**************************\n"
 
 # link files into an executable
-ld65 -C $CONFIG_DIR/$OVERLAY_CONFIG -o fterm.rom kernel.o app.o comm_buffer.o debug.o general.o keyboard.o memory.o overlay_startup.o screen.o serial.o sys.o text.o $CC65LIB -m fterm_$CC65TGT.map -Ln labels.lbl
+ld65 -C $CONFIG_DIR/$OVERLAY_CONFIG -o fterm.rom kernel.o app.o comm_buffer.o crc16.o crc32.o debug.o general.o interrupt.o keyboard.o memory.o overlay_startup.o scrollback.o screen.o serial.o shadow.o staging.o sys.o text.o textbench.o textfast.o xmodem.o zmodem.o zmodem_send.o $CC65LIB -m fterm_$CC65TGT.map -Ln labels.lbl
 # $PROJECT/cc65/lib/common.lib
 
+# overlay sizes from the map: name, start, end, size (hex). each has $2000 (8K) at most; ld65 stops with a memory area overflow if one is bigger.
+grep -E "^OVERLAY_" fterm_$CC65TGT.map
+
 #noTE: 2024-02-12: removed name.o as it was incompatible with the lichking-style memory map I want to use to get more memory
 
 echo "\n**************************\nCC65 tasks complete\n**************************\n"
@@ -106,8 +131,8 @@ echo "\n**************************\nCC65 tasks complete\n***********************
 cp ../strings/strings.bin .
 
 #build pgZ for disk
-fname=("fterm.rom" "fterm.rom.1" "fterm.rom.2" "strings.bin")
-addr=("990700" "000001" "002001" "004002")
+fname=("fterm.rom" "fterm.rom.1" "fterm.rom.2" "fterm.rom.3" "fterm.rom.4" "strings.bin")
+addr=("990700" "000001" "002001" "004001" "006001" "004002")
 
 
 for ((i = 1; i <= $#fname; i++)); do
@@ -120,7 +145,7 @@ done
 echo -n 'Z' >> pgZ_start.hdr
 echo -n '\x99\x07\x00\x00\x00\x00' >> pgZ_end.hdr
 
-cat pgZ_start.hdr fterm.rom.hdr fterm.rom fterm.rom.1.hdr fterm.rom.1 fterm.rom.2.hdr fterm.rom.2 strings.bin.hdr strings.bin pgZ_end.hdr > fterm.pgZ 
+cat pgZ_start.hdr fterm.rom.hdr fterm.rom fterm.rom.1.hdr fterm.rom.1 fterm.rom.2.hdr fterm.rom.2 fterm.rom.3.hdr fterm.rom.3 fterm.rom.4.hdr fterm.rom.4 strings.bin.hdr strings.bin pgZ_end.hdr > fterm.pgZ 
 
 rm *.hdr
 
@@ -148,6 +148,7 @@ struct fs_open_t {
 enum fs_open_mode {
     READ,
     WRITE,
+    END,        // append
 };
 
 struct fs_read_t {
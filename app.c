@@ -25,9 +25,15 @@
 #include "overlay_startup.h"
 #include "text.h"
 #include "screen.h"
+#include "scrollback.h"
 #include "serial.h"
+#include "shadow.h"
 #include "strings.h"
 #include "sys.h"
+#include "textbench.h"
+#include "xmodem.h"
+#include "zmodem.h"
+#include "zmodem_send.h"
 
 // C includes
 #include <stdbool.h>
@@ -65,7 +71,10 @@
 #define ACTION_SELECT_FONT_ANSI	(CH_LC_A + CH_ALT_OFFSET)	// alt-a
 #define ACTION_SELECT_FONT_IBM	(CH_LC_I + CH_ALT_OFFSET)	// alt-i
 #define ACTION_SET_TIME			(CH_LC_T + CH_ALT_OFFSET)	// alt-t
-//#define ACTION_RECEIVE_YMODEM	(CH_LC_Y + CH_ALT_OFFSET)	// alt-y
+#define ACTION_RECEIVE_YMODEM	(CH_LC_Y + CH_ALT_OFFSET)	// alt-y
+#define ACTION_RECEIVE_XMODEM	(CH_LC_X + CH_ALT_OFFSET)	// alt-x
+#define ACTION_RECEIVE_ZMODEM	(CH_LC_Z + CH_ALT_OFFSET)	// alt-z
+#define ACTION_SEND_FILE		(CH_LC_U + CH_ALT_OFFSET)	// alt-u
 //#define ACTION_ABORT_SESSION	(CH_ESC + CH_ALT_OFFSET)	// alt-ESC
 #define ACTION_SET_BAUD_300		(CH_1 + CH_ALT_OFFSET)	// alt-1
 #define ACTION_SET_BAUD_1200	(CH_2 + CH_ALT_OFFSET)	// alt-2
@@ -79,8 +88,11 @@
 #define ACTION_SET_BAUD_115200	(CH_0 + CH_ALT_OFFSET)	// alt-10
 
 #define ACTION_RESET_UART		(CH_LC_R + CH_ALT_OFFSET)	// alt-r
+#define ACTION_CYCLE_FLOW_CTRL	(CH_LC_H + CH_ALT_OFFSET)	// alt-h
+#define ACTION_SCROLLBACK		(CH_LC_B + CH_ALT_OFFSET)	// alt-b
 
 #define ACTION_DEBUG_DUMP		(CH_LC_D + CH_ALT_OFFSET)	// alt-d
+#define ACTION_TEXT_BENCHMARK	(CH_LC_P + CH_ALT_OFFSET)	// alt-p. only in builds with TEXTFAST_BENCHMARK defined
 
 #define ACTION_TEST_CONNECTWIFI	(CH_LC_W + CH_ALT_OFFSET)	// alt-w
 #define ACTION_TEST_CONNECTTFNS	(CH_UC_W + CH_ALT_OFFSET)	// alt-W
@@ -110,25 +122,29 @@ static uint8_t				app_progress_bar_char[8] =
 /*                             Global Variables                              */
 /*****************************************************************************/
 
-extern uint8_t*				global_uart_in_buffer;
 extern uint16_t				global_uart_write_idx;
+extern uint8_t				global_uart_flow_control;
 
 extern System*			global_system;
 
 uint8_t						global_current_baud_config;		// index to global_baud_config[]
 
+// FIFO trigger levels: at slow speeds, interrupt on every byte so characters show up without waiting on the
+//   UART's 4-character timeout. from 3600 up, let a few bytes collect so each IRQ moves a burst. the trigger
+//   stays at 8 at the top end so there are still 8 byte-times (~700us at 115200) for the IRQ to get serviced
+//   before the FIFO overruns, even if the kernel has IRQs held off for a bit.
 const baud_config	global_baud_config[10] = 
 {
-	{ACTION_SET_BAUD_115200,	UART_BAUD_DIV_115200,	ID_STR_MSG_SET_BAUD_115200,	ID_STR_BAUD_115200},
-	{ACTION_SET_BAUD_300,		UART_BAUD_DIV_300,		ID_STR_MSG_SET_BAUD_300,	ID_STR_BAUD_300},
-	{ACTION_SET_BAUD_1200,		UART_BAUD_DIV_1200,		ID_STR_MSG_SET_BAUD_1200,	ID_STR_BAUD_1200},
-	{ACTION_SET_BAUD_2400,		UART_BAUD_DIV_2400,		ID_STR_MSG_SET_BAUD_2400,	ID_STR_BAUD_2400},
-	{ACTION_SET_BAUD_3600,		UART_BAUD_DIV_3600,		ID_STR_MSG_SET_BAUD_3600,	ID_STR_BAUD_3600},
-	{ACTION_SET_BAUD_4800,		UART_BAUD_DIV_4800, 	ID_STR_MSG_SET_BAUD_4800,	ID_STR_BAUD_4800},
-	{ACTION_SET_BAUD_9600,		UART_BAUD_DIV_9600,		ID_STR_MSG_SET_BAUD_9600,	ID_STR_BAUD_9600},
-	{ACTION_SET_BAUD_19200,		UART_BAUD_DIV_19200,	ID_STR_MSG_SET_BAUD_19200,	ID_STR_BAUD_19200},
-	{ACTION_SET_BAUD_38400,		UART_BAUD_DIV_38400,	ID_STR_MSG_SET_BAUD_38400,	ID_STR_BAUD_38400},
-	{ACTION_SET_BAUD_57600,		UART_BAUD_DIV_57600,	ID_STR_MSG_SET_BAUD_57600,	ID_STR_BAUD_57600},
+	{ACTION_SET_BAUD_115200,	UART_BAUD_DIV_115200,	UART_FCR_TRIGGER_8,		ID_STR_MSG_SET_BAUD_115200,	ID_STR_BAUD_115200},
+	{ACTION_SET_BAUD_300,		UART_BAUD_DIV_300,		UART_FCR_TRIGGER_1,		ID_STR_MSG_SET_BAUD_300,	ID_STR_BAUD_300},
+	{ACTION_SET_BAUD_1200,		UART_BAUD_DIV_1200,		UART_FCR_TRIGGER_1,		ID_STR_MSG_SET_BAUD_1200,	ID_STR_BAUD_1200},
+	{ACTION_SET_BAUD_2400,		UART_BAUD_DIV_2400,		UART_FCR_TRIGGER_1,		ID_STR_MSG_SET_BAUD_2400,	ID_STR_BAUD_2400},
+	{ACTION_SET_BAUD_3600,		UART_BAUD_DIV_3600,		UART_FCR_TRIGGER_4,		ID_STR_MSG_SET_BAUD_3600,	ID_STR_BAUD_3600},
+	{ACTION_SET_BAUD_4800,		UART_BAUD_DIV_4800, 	UART_FCR_TRIGGER_4,		ID_STR_MSG_SET_BAUD_4800,	ID_STR_BAUD_4800},
+	{ACTION_SET_BAUD_9600,		UART_BAUD_DIV_9600,		UART_FCR_TRIGGER_4,		ID_STR_MSG_SET_BAUD_9600,	ID_STR_BAUD_9600},
+	{ACTION_SET_BAUD_19200,		UART_BAUD_DIV_19200,	UART_FCR_TRIGGER_8,		ID_STR_MSG_SET_BAUD_19200,	ID_STR_BAUD_19200},
+	{ACTION_SET_BAUD_38400,		UART_BAUD_DIV_38400,	UART_FCR_TRIGGER_8,		ID_STR_MSG_SET_BAUD_38400,	ID_STR_BAUD_38400},
+	{ACTION_SET_BAUD_57600,		UART_BAUD_DIV_57600,	UART_FCR_TRIGGER_8,		ID_STR_MSG_SET_BAUD_57600,	ID_STR_BAUD_57600},
 };
 
 bool					global_clock_is_visible;		// tracks whether or not the clock should be drawn. set to false when not showing main 2-panel screen.
@@ -186,6 +202,15 @@ void App_MainLoop(void);
 // have serial change baud rate and show msg and label
 void App_ChangeBaudRate(uint8_t new_config_index);
 
+// switch serial to the next flow control mode and show msg
+void App_CycleFlowControl(void);
+
+// swap in the ZMODEM overlay, receive files until the sender is done, then put the screen overlay back
+void App_ReceiveZModem(void);
+
+// ask the user for a file on drive 0 and a protocol (X/Y/ZMODEM), then upload it
+void App_SendFile(void);
+
 		
 
 /*****************************************************************************/
@@ -205,8 +230,10 @@ void App_Initialize(void)
 	App_ChangeUIFont(FONT_IBM_ANSI);
 
 	// initialize serial port for terminal comms
-	Serial_InitUART(ACTION_SET_BAUD_4800 - ACTION_SET_BAUD_115200);
+	Serial_InitUART(global_baud_config[ACTION_SET_BAUD_4800 - ACTION_SET_BAUD_115200].divisor_, global_baud_config[ACTION_SET_BAUD_4800 - ACTION_SET_BAUD_115200].fifo_trigger_);
 	Serial_InitANSIColors();
+	Shadow_Init();
+	Shadow_SetEnabled(true);
 	App_ChangeBaudRate(ACTION_SET_BAUD_4800 - ACTION_SET_BAUD_115200);	// ACTION_SET_BAUD_9600 - ACTION_SET_BAUD_115200
 	
 	Buffer_Clear();
@@ -238,6 +265,7 @@ void App_MainLoop(void)
 
 		// clear terminal area in middle of screen
 		Text_FillBox(TERM_BODY_X1, TERM_BODY_Y1, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, COLOR_ORANGE, COLOR_BLACK);
+		Shadow_Invalidate();
 
 		// prep for re-outputting serial to top part of serial panel area
 		Text_SetXY(TERM_BODY_X1, TERM_BODY_Y1);	
@@ -249,7 +277,16 @@ void App_MainLoop(void)
 		do
 		{
 			Serial_ReadUART();
-			Serial_ProcessAvailableData();
+			
+			if (Serial_ProcessAvailableData() == false)
+			{
+				Scrollback_IndexIdle();
+			}
+			else if (Serial_ZModemStartRequested())
+			{
+				// the BBS started a ZMODEM download: no need for the user to pick a protocol
+				App_ReceiveZModem();
+			}
 
 			user_input = Keyboard_GetKeyIfPressed();
 // Text_SetXY(0,0);
@@ -283,11 +320,32 @@ void App_MainLoop(void)
 				{
 					Serial_CycleForegroundColor();
 				}
-// 				else if (user_input == ACTION_RECEIVE_YMODEM)
-// 				{
-// 					Buffer_NewMessage("Starting YModem receive...");
-// 					Serial_StartYModemReceive();
-// 				}
+				else if (user_input == ACTION_RECEIVE_ZMODEM)
+				{
+					App_ReceiveZModem();
+				}
+				else if (user_input == ACTION_SEND_FILE)
+				{
+					App_SendFile();
+				}
+				else if (user_input == ACTION_RECEIVE_YMODEM)
+				{
+					XModem_ReceiveBatch();
+				}
+				else if (user_input == ACTION_RECEIVE_XMODEM)
+				{
+					General_Strlcpy((char*)&global_dlg_title, General_GetString(ID_STR_DLG_XMODEM_RECEIVE_TITLE), COMM_BUFFER_MAX_STRING_LEN);
+					General_Strlcpy((char*)&global_dlg_body_msg, General_GetString(ID_STR_DLG_RECEIVE_FILE_BODY), APP_DIALOG_WIDTH);
+					global_string_buff2[0] = 0;	// clear whatever string had been in this buffer before
+					
+					success = Text_DisplayTextEntryDialog(&global_dlg, (char*)&temp_screen_buffer_char, (char*)&temp_screen_buffer_attr, global_string_buff2, FILE_MAX_FILENAME_SIZE - 1, APP_ACCENT_COLOR, APP_FOREGROUND_COLOR, APP_BACKGROUND_COLOR);
+					
+					if (success && global_string_buff2[0] != 0)
+					{
+						General_CreateFilePathFromFolderAndFile(global_temp_path_1_buffer, "0:", global_string_buff2);
+						XModem_Receive(global_temp_path_1_buffer);
+					}
+				}
 				else if (user_input == ACTION_SET_TIME)
 				{
 					General_Strlcpy((char*)&global_dlg_title, General_GetString(ID_STR_DLG_SET_CLOCK_TITLE), COMM_BUFFER_MAX_STRING_LEN);
@@ -305,8 +363,22 @@ void App_MainLoop(void)
 				}
 				else if (user_input == ACTION_RESET_UART)
 				{
-					Serial_InitUART(global_baud_config[global_current_baud_config].divisor_);
+					Serial_InitUART(global_baud_config[global_current_baud_config].divisor_, global_baud_config[global_current_baud_config].fifo_trigger_);
+				}
+				else if (user_input == ACTION_CYCLE_FLOW_CTRL)
+				{
+					App_CycleFlowControl();
+				}
+				else if (user_input == ACTION_SCROLLBACK)
+				{
+					Scrollback_View();
 				}
+#ifdef TEXTFAST_BENCHMARK
+				else if (user_input == ACTION_TEXT_BENCHMARK)
+				{
+					TextBench_Run();
+				}
+#endif
 
 // 2024/12/11 MB: need to make version of serial debug dump that works with microkernel. trivial, but work. 
 
@@ -375,6 +447,7 @@ void App_MainLoop(void)
 				}
 				else
 				{
+					// wait for room if the queue is full (eg, the host sent XOFF during a paste), rather than drop the key
 					Serial_SendByte(user_input);
 					
 					//sprintf(global_string_buff1, "key typed='%c', %x, %u", user_input, user_input, user_input);
@@ -398,6 +471,7 @@ void App_ChangeBaudRate(uint8_t new_config_index)
 	global_current_baud_config = new_config_index;
 	
 	Serial_SetBaud(global_baud_config[global_current_baud_config].divisor_);
+	Serial_SetFIFO(global_baud_config[global_current_baud_config].fifo_trigger_);
 
 	App_EnterStealthTextUpdateMode();
 	Buffer_NewMessage(General_GetString(global_baud_config[global_current_baud_config].msg_string_id_));	
@@ -406,6 +480,82 @@ void App_ChangeBaudRate(uint8_t new_config_index)
 }
 
 
+// switch serial to the next flow control mode and show msg
+void App_CycleFlowControl(void)
+{
+	if (global_uart_flow_control == UART_FLOW_CONTROL_NONE)
+	{
+		Serial_SetFlowControl(UART_FLOW_CONTROL_RTS_CTS);
+		Buffer_NewMessage(General_GetString(ID_STR_MSG_FLOW_CONTROL_RTS_CTS));
+	}
+	else if (global_uart_flow_control == UART_FLOW_CONTROL_RTS_CTS)
+	{
+		Serial_SetFlowControl(UART_FLOW_CONTROL_XON_XOFF);
+		Buffer_NewMessage(General_GetString(ID_STR_MSG_FLOW_CONTROL_XON_XOFF));
+	}
+	else
+	{
+		Serial_SetFlowControl(UART_FLOW_CONTROL_NONE);
+		Buffer_NewMessage(General_GetString(ID_STR_MSG_FLOW_CONTROL_NONE));
+	}
+}
+
+
+// swap in the ZMODEM overlay, receive files until the sender is done, then put the screen overlay back
+void App_ReceiveZModem(void)
+{
+	App_LoadOverlay(OVERLAY_ZMODEM);
+	ZModem_Receive();
+	App_LoadOverlay(OVERLAY_SCREEN);
+}
+
+
+// ask the user for a file on drive 0 and a protocol (X/Y/ZMODEM), then upload it
+void App_SendFile(void)
+{
+	bool		success;
+	
+	General_Strlcpy((char*)&global_dlg_title, General_GetString(ID_STR_DLG_SEND_TITLE), COMM_BUFFER_MAX_STRING_LEN);
+	General_Strlcpy((char*)&global_dlg_body_msg, General_GetString(ID_STR_DLG_SEND_FILE_BODY), APP_DIALOG_WIDTH);
+	global_string_buff2[0] = 0;	// clear whatever string had been in this buffer before
+	
+	success = Text_DisplayTextEntryDialog(&global_dlg, (char*)&temp_screen_buffer_char, (char*)&temp_screen_buffer_attr, global_string_buff2, FILE_MAX_FILENAME_SIZE - 1, APP_ACCENT_COLOR, APP_FOREGROUND_COLOR, APP_BACKGROUND_COLOR);
+	
+	if (!success || global_string_buff2[0] == 0)
+	{
+		return;
+	}
+	
+	General_CreateFilePathFromFolderAndFile(global_temp_path_1_buffer, "0:", global_string_buff2);
+	
+	General_Strlcpy((char*)&global_dlg_body_msg, General_GetString(ID_STR_DLG_SEND_PROTOCOL_BODY), APP_DIALOG_WIDTH);
+	global_string_buff2[0] = 0;
+	
+	success = Text_DisplayTextEntryDialog(&global_dlg, (char*)&temp_screen_buffer_char, (char*)&temp_screen_buffer_attr, global_string_buff2, 1, APP_ACCENT_COLOR, APP_FOREGROUND_COLOR, APP_BACKGROUND_COLOR);
+	
+	if (!success)
+	{
+		return;
+	}
+	
+	// LOGIC: ZMODEM is the default: it streams, so it is much the fastest, and the receiver can resume a partial copy
+	if (global_string_buff2[0] == CH_LC_X || global_string_buff2[0] == CH_UC_X)
+	{
+		XModem_Send(global_temp_path_1_buffer);
+	}
+	else if (global_string_buff2[0] == CH_LC_Y || global_string_buff2[0] == CH_UC_Y)
+	{
+		XModem_SendBatch(global_temp_path_1_buffer);
+	}
+	else
+	{
+		App_LoadOverlay(OVERLAY_ZMODEM_SEND);
+		ZModemSend_SendFile(global_temp_path_1_buffer);
+		App_LoadOverlay(OVERLAY_SCREEN);
+	}
+}
+
+
 // saves current cursor position and turns off visible cursor during non-serial UI updates
 // call this when redrawing UI, updating baud display, etc, where you don't want cursor to leave terminal area
 void App_EnterStealthTextUpdateMode(void)
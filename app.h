@@ -206,8 +206,8 @@
 // overlays defs are just the physical bank num the overlay code is stored in
 #define OVERLAY_SCREEN			0x08
 #define OVERLAY_STARTUP			0x09
-//#define OVERLAY_3				0x0A
-//#define OVERLAY_4			0x0B
+#define OVERLAY_ZMODEM			0x0A
+#define OVERLAY_ZMODEM_SEND		0x0B
 //#define OVERLAY_5		0x0C
 //#define OVERLAY_6					0x0D
 //#define OVERLAY_7					0x0E
@@ -248,6 +248,7 @@ typedef struct baud_config
 {
 	uint8_t		key_;
 	uint16_t	divisor_;
+	uint8_t		fifo_trigger_;		// UART_FCR_TRIGGER_x: receive FIFO level that raises the UART's IRQ
 	uint8_t		msg_string_id_;
 	uint8_t		lbl_string_id_;
 }  baud_config;
@@ -0,0 +1,62 @@
+/*
+ * crc16.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+#ifndef CRC16_H_
+#define CRC16_H_
+
+
+
+
+/* about this class
+ *
+ * this header represents a set of assembly functions in crc16.asm
+ * CRC-16/XMODEM (poly 0x1021, init 0) over a run of memory, driven by a pair of 256 byte lookup tables
+ * used by the XMODEM/YMODEM code to check (and, when sending, to build) each block
+ * these functions need to be in the MAIN segment so they are always available
+ *
+ */
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+#include <stdint.h>
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+#define CRC16_INITIAL_VALUE		0x0000	// pass to CRC16_Update() to start a new CRC
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// call to a routine in crc16.asm that continues the_crc over zp_copy_len bytes (0+) starting at zp_from_addr
+// returns the new CRC. start a new CRC with CRC16_INITIAL_VALUE.
+// running it over a block plus the block's (big-endian) CRC returns 0 if the block is intact
+uint16_t __fastcall__ CRC16_Update(uint16_t the_crc);
+
+
+#endif /* CRC16_H_ */
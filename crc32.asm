@@ -0,0 +1,139 @@
+; native assembly code. see crc32.h for the C interface.
+;
+; table-driven CRC-32 (the reflected $EDB88320 polynomial used by ZMODEM, zip, ethernet, etc.)
+;   four 256 byte tables, one per byte of the 32 bit table entry, are generated by the assembler below
+;   one set of table lookups per byte: ~45 cycles per byte vs. ~700+ for a bitwise C loop on 32 bit longs
+;
+; only the ZMODEM receiver uses it, so the code and the 1K of tables live in its overlay, not in MAIN.
+;   the data to check must be in MAIN (it is: the overlay slot is where this code runs from)
+;
+; ZMODEM starts the CRC at $FFFFFFFF and sends its complement (low byte first).
+;   running the CRC over a subpacket AND its 4 CRC bytes then gives the fixed residue CRC32_GOOD_RESIDUE ($DEBB20E3)
+
+
+	.setcpu	"65C02"
+	.smart	on
+	.autoimport	on
+	.case	on
+	.debuginfo	off
+	.importzp	sreg, tmp1, tmp2, tmp3, tmp4, ptr1, ptr2
+
+; import from memory.asm
+	.importzp	_zp_from_addr
+	.importzp	_zp_copy_len
+
+; export to f/term .c
+	.export		_CRC32_Update
+
+
+
+CRC32_POLYNOMIAL = $EDB88320
+
+
+
+.segment	"OVERLAY_ZMODEM"
+
+; crc32_table_0..3[n] = byte 0..3 (low to high) of the CRC of the byte n shifted into an all-zero CRC
+; built with the same bitwise algorithm the tables replace, so there are no hand-typed constants to get wrong
+; (the & $7FFFFFFF keeps the assembler's signed 32 bit shift from dragging the top bit down)
+
+.macro	crc32_table which_byte
+	.repeat 256, byte_value
+	crc_value .set byte_value
+	.repeat 8
+	.if crc_value & 1
+	crc_value .set ((crc_value >> 1) & $7FFFFFFF) ^ CRC32_POLYNOMIAL
+	.else
+	crc_value .set (crc_value >> 1) & $7FFFFFFF
+	.endif
+	.endrepeat
+	.byte	(crc_value >> (which_byte * 8)) & $FF
+	.endrepeat
+.endmacro
+
+crc32_table_0:
+	crc32_table 0
+crc32_table_1:
+	crc32_table 1
+crc32_table_2:
+	crc32_table 2
+crc32_table_3:
+	crc32_table 3
+
+
+
+; one byte of CRC: the byte at (ptr1),y goes in, tmp1-tmp4 = CRC, low to high. uses A and X.
+.macro	crc32_step
+	LDA (ptr1),y
+	EOR tmp1				; index = low byte of CRC ^ data byte
+	TAX
+	LDA tmp2				; CRC = (CRC >> 8) ^ table entry
+	EOR crc32_table_0,x
+	STA tmp1
+	LDA tmp3
+	EOR crc32_table_1,x
+	STA tmp2
+	LDA tmp4
+	EOR crc32_table_2,x
+	STA tmp3
+	LDA crc32_table_3,x
+	STA tmp4
+.endmacro
+
+
+
+; ---------------------------------------------------------------
+; uint32_t __fastcall__ CRC32_Update(uint32_t the_crc)
+; ---------------------------------------------------------------
+;// continues the_crc over zp_copy_len bytes (0+) starting at zp_from_addr, and returns the new CRC
+;// start a new CRC by passing CRC32_INITIAL_VALUE. the CRC is not complemented on the way out.
+;// the ZMODEM overlay must be loaded, and the data must be outside the overlay slot
+
+.proc	_CRC32_Update: near
+
+	STA tmp1				; fastcall 32 bit: A/X = low word, sreg = high word
+	STX tmp2
+	LDA sreg
+	STA tmp3
+	LDA sreg+1
+	STA tmp4
+
+	LDA _zp_from_addr
+	STA ptr1
+	LDA _zp_from_addr+1
+	STA ptr1+1
+
+	LDY #0
+	LDA _zp_copy_len+1		; whole pages first
+	BEQ last_page
+	STA ptr2				; page count (ptr2 lo is free scratch here)
+
+whole_page:
+	crc32_step
+	INY
+	BNE whole_page
+	INC ptr1+1
+	DEC ptr2
+	BNE whole_page
+
+last_page:
+	LDA _zp_copy_len		; then whatever is left (Y is 0 here)
+	BEQ done
+	STA ptr2
+
+partial:
+	crc32_step
+	INY
+	CPY ptr2
+	BNE partial
+
+done:
+	LDA tmp3
+	STA sreg
+	LDA tmp4
+	STA sreg+1
+	LDA tmp1
+	LDX tmp2
+	RTS
+
+.endproc
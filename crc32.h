@@ -0,0 +1,63 @@
+/*
+ * crc32.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+#ifndef CRC32_H_
+#define CRC32_H_
+
+
+
+
+/* about this class
+ *
+ * this header represents a set of assembly functions in crc32.asm
+ * CRC-32 (reflected poly 0xEDB88320) over a run of memory, driven by four 256 byte lookup tables
+ * used by the ZMODEM receiver for its 32 bit CRC headers and subpackets
+ * these functions are in the ZMODEM overlay: only call them with that overlay loaded
+ *
+ */
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+#include <stdint.h>
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+#define CRC32_INITIAL_VALUE		0xFFFFFFFF	// pass to CRC32_Update() to start a new CRC
+#define CRC32_GOOD_RESIDUE		0xDEBB20E3	// CRC32_Update() over data + its (complemented, low byte first) CRC gives this if intact
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// call to a routine in crc32.asm that continues the_crc over zp_copy_len bytes (0+) starting at zp_from_addr
+// returns the new CRC (not complemented). start a new CRC with CRC32_INITIAL_VALUE.
+// running it over a block plus the block's CRC returns CRC32_GOOD_RESIDUE if the block is intact
+uint32_t __fastcall__ CRC32_Update(uint32_t the_crc);
+
+
+#endif /* CRC32_H_ */
@@ -160,6 +160,9 @@
 	#define FLAG_UART_IER_STAT			0b00001000		// RS-232 line state change will trigger interrupt if set
 	
 #define UART_IIR						(UART_BASE + 2)
+	#define UART_IIR_ID_MASK			0b00001111		// interrupt ID bits (bit 0 is 1 when no interrupt is pending)
+	#define UART_IIR_ID_RX_DATA			0b00000100		// receive FIFO has reached its trigger level
+	#define UART_IIR_ID_RX_TIMEOUT		0b00001100		// data has been sitting in the receive FIFO below the trigger level
 #define UART_LCR						(UART_BASE + 3)
 	#define FLAG_UART_LSR_DR			0b00000001		// data is ready for reading
 	#define FLAG_UART_LSR_OE			0b00000010		// overrun error
@@ -179,10 +182,30 @@
 	#define FLAG_UART_MCR_LOOP			0b00010000		// Echo (loop back) test.  All characters sent will be echoed if set.	
 #define UART_LSR						(UART_BASE + 5)
 #define UART_MSR						(UART_BASE + 6)
+	// flags for UART modem status register
+	#define FLAG_UART_MSR_DCTS			0b00000001		// CTS has changed since MSR was last read
+	#define FLAG_UART_MSR_DDSR			0b00000010		// DSR has changed since MSR was last read
+	#define FLAG_UART_MSR_TERI			0b00000100		// RI has gone from on to off since MSR was last read
+	#define FLAG_UART_MSR_DDCD			0b00001000		// DCD has changed since MSR was last read
+	#define FLAG_UART_MSR_CTS			0b00010000		// Clear To Send. in hardware flow control, the other side drops this when it can't take more data
+	#define FLAG_UART_MSR_DSR			0b00100000		// Data Set Ready
+	#define FLAG_UART_MSR_RI			0b01000000		// Ring Indicator
+	#define FLAG_UART_MSR_DCD			0b10000000		// Data Carrier Detect
 #define UART_SCR						(UART_BASE + 7)
 
 #define UART_THR						(UART_BASE + 0)	// write register when DLAB=0
 #define UART_FCR						(UART_BASE + 2)	// write register when DLAB=0
+	// flags for UART FIFO control register
+	#define FLAG_UART_FCR_ENABLE		0b00000001		// turn on the 16-byte receive and transmit FIFOs
+	#define FLAG_UART_FCR_RX_RESET		0b00000010		// empty the receive FIFO (self-clearing)
+	#define FLAG_UART_FCR_TX_RESET		0b00000100		// empty the transmit FIFO (self-clearing)
+	#define FLAG_UART_FCR_DMA_MODE		0b00001000
+	#define UART_FCR_TRIGGER_MASK		0b11000000		// receive FIFO level at which the UART raises its data available interrupt:
+	#define UART_FCR_TRIGGER_1			0b00000000		//   after 1 byte
+	#define UART_FCR_TRIGGER_4			0b01000000		//   after 4 bytes
+	#define UART_FCR_TRIGGER_8			0b10000000		//   after 8 bytes
+	#define UART_FCR_TRIGGER_14			0b11000000		//   after 14 bytes
+#define UART_FIFO_DEPTH					16			// bytes the receive FIFO can hold before it overruns
 #define UART_DLL						(UART_BASE + 0)	// read/write register when DLAB=1
 #define UART_DLM						(UART_BASE + 1)	// read/write register when DLAB=1
 
@@ -231,6 +254,32 @@
 #define VICKY_PS2_STATUS_FLAG_K_NK		0b01000000		// when 1, the code sent to the keyboard has resulted in an error
 #define VICKY_PS2_STATUS_FLAG_K_AK		0b10000000		// when 1, the code sent to the keyboard has been acknowledged
 
+
+// ** interrupt controller
+
+#define INT_PENDING_REG0				0xd660		// pending interrupts, group 0. write a 1 to a bit to clear (ack) it
+#define INT_PENDING_REG1				0xd661		// pending interrupts, group 1. write a 1 to a bit to clear (ack) it
+#define INT_POLARITY_REG0				0xd664
+#define INT_POLARITY_REG1				0xd665
+#define INT_EDGE_REG0					0xd668
+#define INT_EDGE_REG1					0xd669
+#define INT_MASK_REG0					0xd66c		// 1 = interrupt source is masked (ignored), 0 = it can raise an IRQ
+#define INT_MASK_REG1					0xd66d		// 1 = interrupt source is masked (ignored), 0 = it can raise an IRQ
+	// group 0 sources
+	#define FLAG_INT0_VKY_SOF			0b00000001		// Vicky start of frame
+	#define FLAG_INT0_VKY_SOL			0b00000010		// Vicky start of line
+	#define FLAG_INT0_PS2_KBD			0b00000100
+	#define FLAG_INT0_PS2_MOUSE			0b00001000
+	#define FLAG_INT0_TIMER_0			0b00010000
+	#define FLAG_INT0_TIMER_1			0b00100000
+	#define FLAG_INT0_CARTRIDGE			0b10000000
+	// group 1 sources
+	#define FLAG_INT1_UART				0b00000001		// 16550 UART (serial port)
+	#define FLAG_INT1_RTC				0b00010000
+	#define FLAG_INT1_VIA0				0b00100000
+	#define FLAG_INT1_VIA1				0b01000000
+	#define FLAG_INT1_SDC_INSERT		0b10000000
+
 #define RTC_SECONDS						0xd690		//  654: second digit, 3210: 1st digit
 #define RTC_SECONDS_ALARM				0xd691		//  654: second digit, 3210: 1st digit
 #define RTC_MINUTES						0xd692		//  654: second digit, 3210: 1st digit
@@ -678,6 +727,8 @@ typedef uint8_t	ColorIdx;
 
 #define CH_LF			0x0a
 #define CH_FF			0x0c
+#define CH_XON			0x11	// DC1: software flow control "resume sending"
+#define CH_XOFF			0x13	// DC3: software flow control "stop sending"
 
 #define CH_F1      		0x81	
 #define CH_F2      		0x82	
@@ -0,0 +1,616 @@
+; native assembly code. see interrupt.h for the C interface.
+;
+; IRQ plumbing for f/term. The microkernel owns the IRQ vector at $FFFE, and that page lives in flash, so at startup
+;   we copy the kernel's $E000-$FFFF bank into a spare RAM bank, point the copy's IRQ vector at irq_dispatch, and map
+;   the copy into slot 7. irq_dispatch runs the cc65 interruptor table (see fterm_overlay_f256.cfg) and then chains
+;   to the kernel's own handler for anything we did not service.
+
+
+	.setcpu	"65C02"
+	.smart	on
+	.autoimport	on
+	.case	on
+	.debuginfo	off
+	.importzp	ptr1, ptr2
+	.macpack	longbranch
+
+; import from serial.c
+	.import		_global_uart_write_idx
+	.import		_global_uart_read_idx
+	.import		_global_uart_line_status
+	.import		_global_uart_flow_control
+	.import		_global_uart_rx_throttled
+	.import		_global_uart_tx_paused
+	.import		_global_uart_tx_control_byte
+	.import		_global_uart_fifo_burst
+	.import		_global_uart_tx_buffer
+	.import		_global_uart_tx_head
+	.import		_global_uart_tx_tail
+
+; import from cc65 runtime
+	.import		callirq
+
+; import from memory.asm
+	.importzp	_zp_irq_ptr
+	.importzp	_zp_irq_temp
+
+; export to cc65 runtime (callirq's constructor/destructor)
+	.export		initirq
+	.export		doneirq
+
+; export to f/term .c
+	.export		_Interrupt_ServiceUART
+
+	.interruptor	_Interrupt_HandleUART
+
+
+; MMU registers
+
+MMU_MEM_CTRL = $0000			; LUT edit/active selection
+MMU_SLOT_5 = $000D				; $A000-$BFFF (overlay slot) when in edit mode
+MMU_SLOT_7 = $000F				; $E000-$FFFF (kernel slot) when in edit mode
+IO_CTRL = $0001					; IO page selection
+
+KERNEL_SHADOW_BANK = $1C		; must match KERNEL_SHADOW_PHYS_BANK_NUM in memory.h
+
+; interrupt controller
+
+INT_PENDING_REG1 = $D661
+FLAG_INT1_UART = $01
+
+; UART (IO page 0)
+
+UART_RBR = $D630
+UART_THR = $D630
+UART_IIR = $D632
+UART_IIR_ID_MASK = %00001111
+UART_IIR_ID_RX_DATA = %00000100		; RX FIFO at trigger level: at least global_uart_fifo_burst bytes are waiting
+UART_IER = $D631
+FLAG_UART_IER_TXA = %00000010
+UART_MSR = $D636
+FLAG_UART_MSR_CTS = %00010000
+UART_FIFO_DEPTH = 16
+UART_MCR = $D634
+UART_LSR = $D635
+FLAG_UART_MCR_RTS = %00000010
+FLAG_UART_LSR_THRE = %00100000
+UART_ERROR_MASK = %10011110
+FLAG_UART_LSR_OE = %00000010
+
+; RX ring buffer in extended memory. must match the UART_RING_* defines in memory.h
+
+UART_RING_NUM_BANKS = 8			; 1, 2, 4, or 8 banks of 8K
+UART_RING_FIRST_BANK = $20
+UART_RING_MASK = UART_RING_NUM_BANKS * $2000 - 1
+UART_RING_WINDOW = $A0			; hi byte of the CPU address the ring banks are mapped to (slot 5)
+UART_RING_HIGH_WATER = UART_RING_NUM_BANKS * $2000 - (UART_RING_NUM_BANKS * $2000 / 4)
+
+; flow control modes. must match serial.h
+
+UART_FLOW_CONTROL_NONE = 0
+UART_FLOW_CONTROL_RTS_CTS = 1
+UART_FLOW_CONTROL_XON_XOFF = 2
+
+CH_XON = $11
+CH_XOFF = $13
+
+
+.macro	MMU_EDIT_ON
+.ifdef _SIMULATOR_				; emulator seems to start with LUT0, but kernel on machine with lut3. see memory.asm
+	LDA #$80
+.else
+	LDA #$B3
+.endif
+	STA MMU_MEM_CTRL
+.endmacro
+
+.macro	MMU_EDIT_OFF
+.ifdef _SIMULATOR_
+	LDA #$00
+.else
+	LDA #$33
+.endif
+	STA MMU_MEM_CTRL
+.endmacro
+
+
+
+.segment	"BSS"
+
+kernel_irq_vector:		.res 2	; the kernel's original IRQ handler, which we chain to
+kernel_orig_bank:		.res 1	; what was mapped into slot 7 before we installed the shadow
+burst_count:			.res 1	; bytes left that drain_uart knows are in the RX FIFO without asking LSR
+
+
+
+; ---------------------------------------------------------------
+; initirq (called automatically by the cc65 startup code via callirq's constructor)
+; ---------------------------------------------------------------
+;// copies the kernel bank into KERNEL_SHADOW_BANK, points the copy's IRQ vector at irq_dispatch, and maps it into slot 7
+
+.segment	"ONCE"
+
+.proc	initirq: near
+
+	PHP
+	SEI						; no IRQs while the vector is half-installed
+
+	MMU_EDIT_ON
+	LDA MMU_SLOT_7
+	STA kernel_orig_bank
+	LDA MMU_SLOT_5			; borrow the overlay slot as our window onto the shadow bank
+	PHA
+	LDA #KERNEL_SHADOW_BANK
+	STA MMU_SLOT_5
+	MMU_EDIT_OFF
+
+	; copy $E000-$FFFF -> $A000-$BFFF (shadow bank)
+	STZ ptr1
+	STZ ptr2
+	LDA #$E0
+	STA ptr1+1
+	LDA #$A0
+	STA ptr2+1
+	LDY #0
+@copy:
+	LDA (ptr1),y
+	STA (ptr2),y
+	INY
+	BNE @copy
+	INC ptr2+1
+	INC ptr1+1				; wraps to $00 after the $FF page
+	BNE @copy
+
+	; remember the kernel's handler, then point the shadow's vector at ours
+	LDA $FFFE
+	STA kernel_irq_vector
+	LDA $FFFF
+	STA kernel_irq_vector+1
+	LDA #<irq_dispatch
+	STA $BFFE
+	LDA #>irq_dispatch
+	STA $BFFF
+
+	MMU_EDIT_ON
+	PLA
+	STA MMU_SLOT_5			; put the overlay back
+	LDA #KERNEL_SHADOW_BANK
+	STA MMU_SLOT_7			; and swap the shadow in under the kernel
+	MMU_EDIT_OFF
+
+	PLP
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; doneirq (called automatically by the cc65 exit code via callirq's destructor)
+; ---------------------------------------------------------------
+;// maps the original kernel bank back into slot 7
+
+.segment	"CODE"
+
+.proc	doneirq: near
+
+	PHP
+	SEI
+
+	MMU_EDIT_ON
+	LDA kernel_orig_bank
+	STA MMU_SLOT_7
+	MMU_EDIT_OFF
+
+	PLP
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; irq_dispatch (IRQ/BRK vector of the shadow kernel bank)
+; ---------------------------------------------------------------
+;// runs our interruptors. if one of them serviced the IRQ, return straight to the interrupted code;
+;// otherwise (or on BRK) hand off to the kernel's handler with registers and stack untouched
+
+.segment	"CODE"
+
+.proc	irq_dispatch: near
+
+	PHA
+	PHX
+	PHY
+
+	TSX
+	LDA $0104,x				; status register pushed by the CPU
+	AND #$10				; B flag: BRK always belongs to the kernel
+	BNE @chain
+
+	JSR callirq				; carry set if an interruptor serviced the IRQ
+	BCC @chain
+
+	PLY
+	PLX
+	PLA
+	RTI
+
+@chain:
+	PLY
+	PLX
+	PLA
+	JMP (kernel_irq_vector)
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; _Interrupt_HandleUART (interruptor)
+; ---------------------------------------------------------------
+;// services the UART interrupt: acks it, drains the UART's receive FIFO into the RX ring, then refills the
+;//   transmit FIFO from the TX queue
+;// returns with carry set if the IRQ was ours
+
+.segment	"CODE"
+
+.proc	_Interrupt_HandleUART: near
+
+	LDA IO_CTRL				; mainline code may have any IO page in
+	PHA
+	STZ IO_CTRL
+
+	LDA INT_PENDING_REG1
+	AND #FLAG_INT1_UART
+	BEQ @not_ours
+	STA INT_PENDING_REG1	; ack first, so a byte arriving mid-drain raises a fresh IRQ
+
+	LDA UART_IIR			; if the FIFO hit its trigger level, we know how many bytes we can pull blind
+	AND #UART_IIR_ID_MASK
+	CMP #UART_IIR_ID_RX_DATA
+	BNE @unknown
+	LDA _global_uart_fifo_burst
+	BRA @drain
+
+@unknown:
+	LDA #0					; timeout or line status: check LSR before every byte
+
+@drain:
+	JSR drain_uart
+	JSR fill_tx
+
+	PLA
+	STA IO_CTRL
+	SEC
+	RTS
+
+@not_ours:
+	PLA
+	STA IO_CTRL
+	CLC
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; void __fastcall__ Interrupt_ServiceUART(void)
+; ---------------------------------------------------------------
+;// drains whatever is sitting in the UART receive FIFO into the RX ring and tops up the transmit FIFO,
+;//   exactly as the IRQ handler would
+;// safe to call from mainline code at any time. used to sweep up bytes when the kernel held IRQs off,
+;//   and to restart the TX queue after fill_tx stopped it to wait on CTS
+
+.segment	"CODE"
+
+.proc	_Interrupt_ServiceUART: near
+
+	PHP
+	SEI
+
+	LDA IO_CTRL
+	PHA
+	STZ IO_CTRL
+
+	LDA #0					; no idea how many bytes are waiting: check LSR before every byte
+	JSR drain_uart
+	JSR fill_tx
+
+	PLA
+	STA IO_CTRL
+
+	PLP
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; fill_tx (internal)
+; ---------------------------------------------------------------
+;// if the transmit FIFO is empty, refill it: a pending XON/XOFF first, then up to a FIFO's worth from the TX queue
+;// when the queue is empty, or flow control says the other side can't take more, the TX IRQ is turned off
+;//   so an empty THR doesn't keep re-raising it. Serial_StartTransmit() / an XON / the mainline sweep turn it back on.
+;// expects IO page 0 to be mapped in and IRQs to be off
+
+.segment	"CODE"
+
+.proc	fill_tx: near
+
+	LDA UART_LSR
+	AND #FLAG_UART_LSR_THRE
+	BEQ @exit				; still sending what we gave it last time
+
+	LDY #UART_FIFO_DEPTH
+
+	LDA _global_uart_tx_control_byte
+	BEQ @check_flow
+	STA UART_THR			; XON/XOFF jump the queue, and ignore XOFF from the other side
+	STZ _global_uart_tx_control_byte
+	DEY
+
+@check_flow:
+	LDA _global_uart_flow_control
+	CMP #UART_FLOW_CONTROL_XON_XOFF
+	BNE @check_cts
+	LDA _global_uart_tx_paused
+	BNE @stop
+	BRA @fill
+
+@check_cts:
+	CMP #UART_FLOW_CONTROL_RTS_CTS
+	BNE @fill
+	LDA UART_MSR
+	AND #FLAG_UART_MSR_CTS
+	BEQ @stop
+
+@fill:
+	LDX _global_uart_tx_tail
+
+@next:
+	CPX _global_uart_tx_head
+	BEQ @empty
+	LDA _global_uart_tx_buffer,x
+	STA UART_THR
+	INX						; queue is 256 bytes: tail wraps on its own
+	DEY
+	BNE @next
+
+	STX _global_uart_tx_tail
+	LDA #FLAG_UART_IER_TXA	; more to send (maybe): make sure we hear about it when the FIFO is empty again
+	TSB UART_IER
+
+@exit:
+	RTS
+
+@empty:
+	STX _global_uart_tx_tail
+
+@stop:
+	LDA #FLAG_UART_IER_TXA
+	TRB UART_IER
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; drain_uart (internal)
+; ---------------------------------------------------------------
+;// copy bytes from the UART into the RX ring until LSR says no more are ready
+;// pass in A the number of bytes the caller knows are waiting in the FIFO (0 if unknown). that many are read
+;//   back to back with no LSR check in between (a burst), saving ~25 cycles a byte, before going back to
+;//   checking LSR for each byte. the first LSR check is always made, so errors are latched at least once per
+;//   burst, and the FIFO error bit keeps any error inside a burst visible until the next check.
+;// the ring bank for the current write position is mapped into slot 5 once per call (and again only when a
+;//   write crosses into the next bank), then slot 5 is put back the way the interrupted code had it
+;// if the ring is full, the byte is dropped and reported as an overrun
+;// in XON/XOFF mode, XON and XOFF are consumed here (pausing/resuming transmit) and never reach the ring
+;// line errors seen along the way are OR'd into global_uart_line_status for Serial_ReadUART to report
+;// expects IO page 0 to be mapped in and IRQs to be off
+
+.segment	"CODE"
+
+.proc	drain_uart: near
+
+	BNE @set_burst
+	INC A					; unknown: the LSR check below vouches for exactly 1
+
+@set_burst:
+	STA burst_count
+
+	LDA UART_LSR
+	TAX
+	AND #UART_ERROR_MASK	; reading LSR clears the error bits, so latch them every time
+	TSB _global_uart_line_status
+	TXA
+	LSR A					; data ready bit into carry
+	BCS @have_data
+	RTS						; nothing to read: don't bother touching the MMU
+
+@have_data:
+	MMU_EDIT_ON
+	LDA MMU_SLOT_5
+	PHA
+	JSR map_write_bank
+	MMU_EDIT_OFF
+	BRA @store
+
+@next:
+	DEC burst_count			; still inside a burst: the byte is there, skip LSR
+	BNE @store
+
+	LDA UART_LSR
+	TAX
+	AND #UART_ERROR_MASK
+	TSB _global_uart_line_status
+	TXA
+	LSR A					; data ready bit into carry
+	BCC @done
+	INC burst_count			; vouches for 1 more
+
+@store:
+	; next write position = (write + 1) & mask. if that's the read position, the ring is full
+	LDA _global_uart_write_idx
+	CLC
+	ADC #1
+	STA _zp_irq_temp
+	LDA _global_uart_write_idx+1
+	ADC #0
+	AND #>UART_RING_MASK
+	STA _zp_irq_temp+1
+	CMP _global_uart_read_idx+1
+	BNE @room
+	LDA _zp_irq_temp
+	CMP _global_uart_read_idx
+	BNE @room
+
+	LDA UART_RBR			; ring full: throw the byte away and flag it like a FIFO overrun
+	LDA #FLAG_UART_LSR_OE
+	TSB _global_uart_line_status
+	BRA @next
+
+@room:
+	; CPU address = window + (write & $1FFF)
+	LDA _global_uart_write_idx
+	STA _zp_irq_ptr
+	LDA _global_uart_write_idx+1
+	AND #$1F
+	ORA #UART_RING_WINDOW
+	STA _zp_irq_ptr+1
+
+	LDA UART_RBR
+	LDX _global_uart_flow_control
+	CPX #UART_FLOW_CONTROL_XON_XOFF
+	BEQ @check_xon_xoff
+
+@keep:
+	STA (_zp_irq_ptr)
+
+	LDX _zp_irq_temp+1
+	STX _global_uart_write_idx+1
+	LDA _zp_irq_temp
+	STA _global_uart_write_idx
+	BNE @next				; still inside the same 256b page, so same bank
+	TXA
+	AND #$1F
+	BNE @next				; new page, same bank
+
+	MMU_EDIT_ON				; crossed into the next bank (or wrapped to the first)
+	JSR map_write_bank
+	MMU_EDIT_OFF
+	BRA @next
+
+@check_xon_xoff:
+	CMP #CH_XOFF
+	BEQ @pause_tx
+	CMP #CH_XON
+	BNE @keep
+	STZ _global_uart_tx_paused
+	LDA #FLAG_UART_IER_TXA	; fill_tx stopped the TX IRQ while paused: restart it
+	TSB UART_IER
+	BRA @next
+
+@pause_tx:
+	LDA #1					; C side compares against true
+	STA _global_uart_tx_paused
+	BRA @next
+
+@done:
+	MMU_EDIT_ON
+	PLA
+	STA MMU_SLOT_5
+	MMU_EDIT_OFF
+	JMP check_high_water	; (tail call)
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; check_high_water (internal)
+; ---------------------------------------------------------------
+;// if flow control is on and the RX ring has filled to UART_RING_HIGH_WATER, tell the other side to stop sending
+;// Serial_RingRead() lets it resume once the main loop has drained the ring down to the low water mark
+;// expects IO page 0 to be mapped in and IRQs to be off
+
+.segment	"CODE"
+
+.proc	check_high_water: near
+
+	LDA _global_uart_flow_control
+	BEQ @exit				; UART_FLOW_CONTROL_NONE
+	LDA _global_uart_rx_throttled
+	BNE @exit				; already asked
+
+	; fill level = (write - read) & mask
+	SEC
+	LDA _global_uart_write_idx
+	SBC _global_uart_read_idx
+	TAX
+	LDA _global_uart_write_idx+1
+	SBC _global_uart_read_idx+1
+	AND #>UART_RING_MASK
+	CMP #>UART_RING_HIGH_WATER
+	BCC @exit
+	BNE @throttle
+	CPX #<UART_RING_HIGH_WATER
+	BCC @exit
+
+@throttle:
+	LDA #1
+	STA _global_uart_rx_throttled
+	LDA _global_uart_flow_control
+	CMP #UART_FLOW_CONTROL_RTS_CTS
+	BNE @send_xoff
+	LDA #FLAG_UART_MCR_RTS	; drop RTS
+	TRB UART_MCR
+
+@exit:
+	RTS
+
+@send_xoff:
+	LDA #CH_XOFF
+	TAX
+	LDA UART_LSR
+	AND #FLAG_UART_LSR_THRE
+	BEQ @defer_xoff
+	STX UART_THR
+	RTS
+
+@defer_xoff:
+	STX _global_uart_tx_control_byte	; transmitter busy: fill_tx sends it as soon as THR empties
+	LDA #FLAG_UART_IER_TXA
+	TSB UART_IER
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; map_write_bank (internal)
+; ---------------------------------------------------------------
+;// maps the ring bank holding global_uart_write_idx into slot 5. bank = first bank + (write_idx >> 13)
+;// expects MMU edit mode to be on
+
+.segment	"CODE"
+
+.proc	map_write_bank: near
+
+	LDA _global_uart_write_idx+1
+	LSR A
+	LSR A
+	LSR A
+	LSR A
+	LSR A
+	CLC
+	ADC #UART_RING_FIRST_BANK
+	STA MMU_SLOT_5
+	RTS
+
+.endproc
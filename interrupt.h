@@ -0,0 +1,64 @@
+/*
+ * interrupt.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+#ifndef INTERRUPT_H_
+#define INTERRUPT_H_
+
+
+
+
+/* about this class
+ *
+ * this header represents a set of assembly functions in interrupt.asm
+ * at startup, interrupt.asm installs a RAM copy of the kernel bank whose IRQ vector points at our own dispatcher
+ * the dispatcher runs the cc65 interruptor table (currently just the UART receive handler) and chains to the kernel for everything else
+ * the UART handler drains the UART into the RX buffer independent of the main loop, so rendering stalls don't cause overruns
+ * it also feeds the UART from the TX queue, so sending never makes the main loop wait on the serial line
+ * these functions need to be in the MAIN segment so they are always available
+ *
+ */
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+#include "app.h"
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// call to a routine in interrupt.asm that drains whatever is in the UART receive FIFO into the RX buffer,
+// and refills the transmit FIFO from the TX queue, exactly as the IRQ handler would
+// safe to call from mainline code at any time; used to sweep up anything that arrived while the kernel was holding IRQs off,
+// and to restart transmit after the handler paused it waiting on CTS
+// line errors seen while draining are OR'd into global_uart_line_status
+void __fastcall__ Interrupt_ServiceUART(void);
+
+
+#endif /* INTERRUPT_H_ */
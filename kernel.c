@@ -13,6 +13,9 @@
 #include "app.h"	// need for FILE_MAX_PATHNAME_SIZE
 #include "dirent.h"  // Users are expected to "-I ." to get the local copy.
 #include "general.h" // need for strnlen
+#include "interrupt.h" // need for Interrupt_ServiceUART
+#include "kernel.h"
+#include "keyboard.h" // need for Keyboard_ProcessEvents
 #include "f256.h" // need for F1 key values
 
 #define VECTOR(member) (size_t) (&((struct call*) 0xff00)->member)
@@ -137,6 +140,7 @@ GETIN()
         }
         
         if (event.type != EVENT(key.PRESSED)) {
+            Kernel_DispatchEvent();
             continue;
         }
         
@@ -171,6 +175,7 @@ bool Kernal_AnyKeyEvent()
             return true;
         }
         
+        Kernel_DispatchEvent();
         return false;
     }
 }
@@ -195,41 +200,300 @@ path_without_drive(const char *path, char *drive)
     return (path + 2);
 }
 
+////////////////////////////////////////
+// asynchronous file I/O
+//
+// every file and directory call comes in two halves: start it (which returns a
+// handle straight away), then collect the result once the kernel's completion
+// event has come in. Keyboard_ProcessEvents() is the one loop that takes
+// events from the kernel: it keeps key presses and timers for itself, and hands
+// file and directory events to Kernel_DispatchEvent() here. the blocking calls
+// further down (open, read, write, close, Kernel_OpenDir, etc.) are the same two
+// halves with a wait in between, so keys pressed and timers that fire while the
+// disk is busy end up in the keyboard queue, not thrown away.
+
+#define KERNEL_IO_FREE 0
+#define KERNEL_IO_BUSY 1    // waiting on the kernel's event
+#define KERNEL_IO_DONE 2    // result is in. handle is freed when it's collected
+
+struct io_request {
+    uint8_t  state;
+    uint8_t  stream;
+    void    *buf;           // read: where the data goes. dir read: the dirent.
+    int      result;
+};
+
+static struct io_request io_request[KERNEL_IO_MAX_REQUESTS];
+static struct dirent dir_entry;
+
+static int
+io_free_handle(void)
+{
+    int handle;
+    
+    for (handle = 0; handle < KERNEL_IO_MAX_REQUESTS; handle++) {
+        if (io_request[handle].state == KERNEL_IO_FREE) {
+            return handle;
+        }
+    }
+    
+    return KERNEL_IO_NO_HANDLE;
+}
+
+// call right after the kernel call that starts the request, with error still set from it
+static int
+io_start(int handle, uint8_t stream, void *buf)
+{
+    if (handle < 0 || error) {
+        return KERNEL_IO_NO_HANDLE;
+    }
+    
+    io_request[handle].state = KERNEL_IO_BUSY;
+    io_request[handle].stream = stream;
+    io_request[handle].buf = buf;
+    
+    return handle;
+}
+
+static int
+io_wait(int handle)
+{
+    int result;
+    
+    if (handle < 0) {
+        return -1;
+    }
+    
+    // an SD access can take a while. keep the UART FIFO swept into the RX ring
+    // meanwhile, in case the kernel holds IRQs off, so a file transfer in
+    // progress loses nothing while it waits on the card.
+    while ((result = Kernel_IOResult(handle)) == KERNEL_IO_PENDING) {
+        Interrupt_ServiceUART();
+        Keyboard_ProcessEvents();
+    }
+    
+    return result;
+}
+
+static void
+io_read_dir_entry(struct dirent *dirent)
+{
+    unsigned len;
+    
+    if (event.type == EVENT(directory.VOLUME)) {
+        dirent->d_blocks = 0;
+        dirent->d_type = 2;
+    } else {
+        // common.ext isn't returning expected values. i think it's not meant to be used for reading like this. 
+        // common.buf returns blocks, 2 bytes of 0s, then a filename, looks like maybe the last-read file's filename. probably just junk from previous event. 
+        args.common.buf = &dirent->d_blocks;
+        args.common.buflen = sizeof(dirent->d_blocks) + 6; // 6 to pick up the 6 bytes of date info
+        CALL(ReadExt);
+        dirent->d_type = (dirent->d_blocks == 0);
+    }
+    
+    // Copy the name.
+    len = event.directory.file.len;
+    if (len >= sizeof(dirent->d_name)) {
+        len = sizeof(dirent->d_name) - 1;
+    }
+        
+    if (len > 0) {
+        args.common.buf = &dirent->d_name;
+        args.common.buflen = len;
+        CALL(ReadData);
+    }
+    dirent->d_name[len] = '\0';
+}
+
+bool
+Kernel_DispatchEvent(void)
+{
+    struct io_request *request;
+    uint8_t i;
+    int result;
+    
+    if (event.type < EVENT(file.NOT_FOUND) || event.type > EVENT(directory.DELETED)) {
+        return false;
+    }
+    
+    // file and directory events both start with the stream they're for
+    for (i = 0; i < KERNEL_IO_MAX_REQUESTS; i++) {
+        request = &io_request[i];
+        if (request->state == KERNEL_IO_BUSY && request->stream == event.file.stream) {
+            break;
+        }
+    }
+    
+    if (i == KERNEL_IO_MAX_REQUESTS) {
+        return true;    // nobody waiting on it
+    }
+    
+    switch (event.type) {
+    case EVENT(file.OPENED):
+    case EVENT(directory.OPENED):
+        result = request->stream;
+        break;
+    case EVENT(file.DATA):
+        // the data has to be fetched while this is still the current event
+        args.common.buf = request->buf;
+        args.common.buflen = event.file.data.delivered;
+        asm("jsr %w", VECTOR(ReadData));
+        result = event.file.data.delivered ? event.file.data.delivered : 256;
+        break;
+    case EVENT(file.WROTE):
+        result = event.file.wrote.delivered;
+        break;
+    case EVENT(file.SEEK):
+        result = 0;
+        break;
+    case EVENT(file.EOFx):
+    case EVENT(file.CLOSED):
+    case EVENT(directory.EOFx):
+    case EVENT(directory.CLOSED):
+        result = 0;
+        break;
+    case EVENT(directory.VOLUME):
+    case EVENT(directory.FILE):
+        io_read_dir_entry(request->buf);
+        result = 1;
+        break;
+    case EVENT(directory.FREE):
+        // dirent doesn't care about these types of records: ask for the next one.
+        args.directory.read.stream = request->stream;
+        CALL(Directory.Read);
+        if (!error) {
+            return true;
+        }
+        result = -1;
+        break;
+    default:
+        // NOT_FOUND, ERROR, and anything we didn't ask for
+        result = -1;
+        break;
+    }
+    
+    request->result = result;
+    request->state = KERNEL_IO_DONE;
+    
+    return true;
+}
+
 int
-open(const char *fname, int mode, ...)
+Kernel_IOResult(int handle)
+{
+    if (io_request[handle].state == KERNEL_IO_BUSY) {
+        return KERNEL_IO_PENDING;
+    }
+    
+    io_request[handle].state = KERNEL_IO_FREE;
+    
+    return io_request[handle].result;
+}
+
+int
+Kernel_OpenAsync(const char *fname, int mode)
 {
-    int ret = 0;
+    int handle = io_free_handle();
+    uint8_t stream;
     char drive;
     
+    if (handle < 0) {
+        return KERNEL_IO_NO_HANDLE;
+    }
+    
     fname = path_without_drive(fname, &drive);
     
     args.common.buf = (uint8_t*) fname;
     args.common.buflen = strlen(fname);
     args.file.open.drive = drive;
-    if (mode == 1) {
-        mode = 0;
+    // O_RDONLY reads, O_APPEND adds to the end of the file, anything else creates/replaces it
+    if (mode == O_RDONLY) {
+        mode = READ;
+    } else if (mode & O_APPEND) {
+        mode = END;
     } else {
-        mode = 1;
+        mode = WRITE;
     }
     args.file.open.mode = mode;
-    ret = CALL(File.Open);
-    if (error) {
-        return -1;
+    stream = CALL(File.Open);
+    
+    return io_start(handle, stream, NULL);
+}
+
+int
+Kernel_ReadAsync(int fd, void *buf, uint8_t nbytes)
+{
+    int handle = io_free_handle();
+    
+    if (handle < 0) {
+        return KERNEL_IO_NO_HANDLE;
     }
     
-    for(;;) {
-        event.type = 0;
-        asm("jsr %w", VECTOR(NextEvent));
-        switch (event.type) {
-        case EVENT(file.OPENED):
-            return ret;
-        case EVENT(file.NOT_FOUND):
-        case EVENT(file.ERROR):
-            return -1;
-        default:
-        	continue;
-        }
+    args.file.read.stream = fd;
+    args.file.read.buflen = nbytes;
+    CALL(File.Read);
+    
+    return io_start(handle, fd, buf);
+}
+
+int
+Kernel_WriteAsync(int fd, const void *buf, uint8_t nbytes)
+{
+    int handle = io_free_handle();
+    
+    if (handle < 0) {
+        return KERNEL_IO_NO_HANDLE;
+    }
+    
+    args.file.read.stream = fd;
+    args.common.buf = (void*) buf;
+    args.common.buflen = nbytes;
+    CALL(File.Write);
+    
+    return io_start(handle, fd, NULL);
+}
+
+int
+Kernel_CloseAsync(int fd)
+{
+    int handle = io_free_handle();
+    
+    if (handle < 0) {
+        return KERNEL_IO_NO_HANDLE;
     }
+    
+    args.file.close.stream = fd;
+    CALL(File.Close);
+    
+    return io_start(handle, fd, NULL);
+}
+
+
+int
+Kernel_SeekAsync(int fd, uint32_t position)
+{
+    int handle = io_free_handle();
+    
+    if (handle < 0) {
+        return KERNEL_IO_NO_HANDLE;
+    }
+    
+    args.file.seek.streak = fd;
+    args.file.seek.position = position;
+    CALL(File.Seek);
+    
+    return io_start(handle, fd, NULL);
+}
+
+
+////////////////////////////////////////
+// blocking file I/O: the async calls, and a wait
+
+int
+open(const char *fname, int mode, ...)
+{
+    return io_wait(Kernel_OpenAsync(fname, mode));
 }
 
 static int 
@@ -246,33 +510,7 @@ Kernel_Read(int fd, void *buf, uint16_t nbytes)
         nbytes = 255;
     }
     
-    args.file.read.stream = fd;
-    args.file.read.buflen = nbytes;
-    CALL(File.Read);
-    if (error) {
-        return -1;
-    }
-
-    for(;;) {
-        event.type = 0;
-        asm("jsr %w", VECTOR(NextEvent));
-        switch (event.type) {
-        case EVENT(file.DATA):
-            args.common.buf = buf;
-            args.common.buflen = event.file.data.delivered;
-            asm("jsr %w", VECTOR(ReadData));
-            if (!event.file.data.delivered) {
-                return 256;
-            }
-            return event.file.data.delivered;
-        case EVENT(file.EOFx):
-            return 0;
-        case EVENT(file.ERROR):
-            return -1;
-        default: 
-        	continue;
-        }
-    }
+    return io_wait(Kernel_ReadAsync(fd, buf, nbytes));
 }
 
 int 
@@ -296,24 +534,7 @@ read(int fd, void *buf, uint16_t nbytes)
 static int
 kernel_write(uint8_t fd, void *buf, uint8_t nbytes)
 {
-    args.file.read.stream = fd;
-    args.common.buf = buf;
-    args.common.buflen = nbytes;
-    CALL(File.Write);
-    if (error) {
-        return -1;
-    }
-
-    for(;;) {
-        event.type = 0;
-        asm("jsr %w", VECTOR(NextEvent));
-        if (event.type == EVENT(file.WROTE)) {
-            return event.file.data.delivered;
-        }
-        if (event.type == EVENT(file.ERROR)) {
-            return -1;
-        }
-    }
+    return io_wait(Kernel_WriteAsync(fd, buf, nbytes));
 }
 
 int 
@@ -354,25 +575,18 @@ write(int fd, const void *buf, uint16_t nbytes)
     return total;
 }
 
+// move the next read/write of fd to position bytes from the start of the file
+// returns 0, or -1 if the kernel can't (older kernels don't do File.Seek)
+int
+Kernel_Seek(int fd, uint32_t position)
+{
+    return (io_wait(Kernel_SeekAsync(fd, position)) < 0 ? -1 : 0);
+}
 
 int
 close(int fd)
 {
-    args.file.close.stream = fd;
-    asm("jsr %w", VECTOR(File.Close));
-    for(;;) {
-        event.type = 0;
-        asm("jsr %w", VECTOR(NextEvent));
-        switch (event.type) {
-        case EVENT(file.CLOSED):
-                return 0;
-        case EVENT(file.ERROR):
-                return -1;
-        default: continue;
-        }
-    }
-    
-    return 0;
+    return (io_wait(Kernel_CloseAsync(fd)) < 0 ? -1 : 0);
 }
 
 
@@ -386,147 +600,79 @@ DIR* __fastcall__
 Kernel_OpenDir(const char* name)
 {
     char drive, stream;
-
-// out(name[0]);
-// out(name[1]);
-// out(name[2]);
+    int handle;
     
     name = path_without_drive(name, &drive);
-//out(48+drive);
-// out(48+(uint8_t)strlen(name));
    
     if (dir_stream[drive]) {
-//out(64);
         return NULL;  // Only one at a time.
     }
     
+    handle = io_free_handle();
+    if (handle < 0) {
+        return NULL;
+    }
+    
     args.directory.open.drive = drive;
     args.common.buf = name;
     args.common.buflen = strlen(name);
-//out(48+(uint8_t)args.common.buflen);
     stream = CALL(Directory.Open);
-    if (error) {
-//out(66); // B
-        return NULL;
-    }
-//out(67); // C
     
-    for(;;) {
-        event.type = 0;
-        asm("jsr %w", VECTOR(NextEvent));
-        if (event.type == EVENT(directory.OPENED)) {
-//out(68); // D
-            break;
-        }
-        if (event.type == EVENT(directory.ERROR)) {
-//out(69); // E
-            return NULL;
-        }
+    if (io_wait(io_start(handle, stream, NULL)) < 0) {
+        return NULL;
     }
     
     dir_stream[drive] = stream;
-//out(70); // F
     return (DIR*) &dir_stream[drive];
 }
 
 struct dirent* __fastcall__ 
 Kernel_ReadDir(DIR* dir)
 {
-    static struct dirent dirent;
+    int handle;
     
     if (!dir) {
         return NULL;
     }
     
+    handle = io_free_handle();
+    if (handle < 0) {
+        return NULL;
+    }
+    
     args.directory.read.stream = *(char*)dir;
     CALL(Directory.Read);
-    if (error) {
+    
+    if (io_wait(io_start(handle, *(char*)dir, &dir_entry)) <= 0) {
         return NULL;
     }
     
-    for(;;) {
-        
-        unsigned len;
-        
-        event.type = 0;
-        asm("jsr %w", VECTOR(NextEvent));
-        
-        switch (event.type) {
-        
-        case EVENT(directory.VOLUME):
-            
-            dirent.d_blocks = 0;
-            dirent.d_type = 2;
-            break;
-            
-        case EVENT(directory.FILE): 
-            
-            // common.ext isn't returning expected values. i think it's not meant to be used for reading like this. 
-           	 	//args.common.ext = &dirent.d_blocks;
-				// args.common.extlen = sizeof(dirent.d_blocks) + 6; // 6 to pick up the 6 bytes of date info
-			// common.buf returns blocks, 2 bytes of 0s, then a filename, looks like maybe the last-read file's filename. probably just junk from previous event. 
-			args.common.buf = &dirent.d_blocks;
-			args.common.buflen = sizeof(dirent.d_blocks) + 6; // 6 to pick up the 6 bytes of date info
-			CALL(ReadExt);
-			dirent.d_type = (dirent.d_blocks == 0);
-            break;
-                
-        case EVENT(directory.FREE):
-            // dirent doesn't care about these types of records.
-            args.directory.read.stream = *(char*)dir;
-            CALL(Directory.Read);
-            if (!error) {
-                continue;
-            }
-            // Fall through.
-        
-        case EVENT(directory.EOFx):
-        case EVENT(directory.ERROR):
-            return NULL;
-            
-        default: continue;
-        }
-        
-        // Copy the name.
-        len = event.directory.file.len;
-        if (len >= sizeof(dirent.d_name)) {
-            len = sizeof(dirent.d_name) - 1;
-        }
-            
-        if (len > 0) {
-            args.common.buf = &dirent.d_name;
-            args.common.buflen = len;
-            CALL(ReadData);
-        }
-        dirent.d_name[len] = '\0';
-                
-        return &dirent;
-    }
+    return &dir_entry;
 }
     
     
 int __fastcall__ 
 Kernel_CloseDir (DIR* dir)
 {
-    if (!dir) {
+    int handle;
+    char stream;
+    
+    if (!dir || !*(char*)dir) {
         return -1;
     }
     
-    for(;;) {
-        if (*(char*)dir) {
-            args.directory.close.stream = *(char*)dir;
-            CALL(Directory.Close);
-            if (!error) {
-                *(char*)dir = 0;
-            }
-        }
-        event.type = 0;
-        asm("jsr %w", VECTOR(NextEvent));
-        if (event.type == EVENT(directory.CLOSED)) {
-            *(char*)dir = 0;
-            return 0;
-        }
+    handle = io_free_handle();
+    if (handle < 0) {
+        return -1;
     }
+    
+    stream = *(char*)dir;
+    args.directory.close.stream = stream;
+    CALL(Directory.Close);
+    handle = io_start(handle, stream, NULL);
+    *(char*)dir = 0;
+    
+    return (io_wait(handle) < 0 ? -1 : 0);
 }
 
 
@@ -24,4 +24,31 @@ bool Kernal_AnyKeyEvent();
 
 void out(char c);
 
+// asynchronous file I/O
+//   each Kernel_xxxAsync() call starts a request and returns a handle (or KERNEL_IO_NO_HANDLE if it couldn't be started)
+//   the completion comes in as a kernel event: Keyboard_ProcessEvents() passes those to Kernel_DispatchEvent()
+//   poll Kernel_IOResult() until it stops returning KERNEL_IO_PENDING. that collects the result, and frees the handle.
+//   results are as for open()/read()/write()/close()/Kernel_Seek(): stream, bytes read (0 = end of file), bytes written, 0, 0; -1 on error
+//   only one request at a time per stream (the kernel's rule); KERNEL_IO_MAX_REQUESTS in all
+//   a read's buffer must stay mapped in until the result is collected: the data is copied in when the event arrives
+#define KERNEL_IO_MAX_REQUESTS	4
+#define KERNEL_IO_NO_HANDLE		-1
+#define KERNEL_IO_PENDING		-2
+
+int Kernel_OpenAsync(const char* fname, int mode);
+int Kernel_ReadAsync(int fd, void* buf, uint8_t nbytes);	// nbytes: 255 max
+int Kernel_WriteAsync(int fd, const void* buf, uint8_t nbytes);	// nbytes: 254 max
+int Kernel_CloseAsync(int fd);
+int Kernel_SeekAsync(int fd, uint32_t position);	// next read/write is from position bytes into the file
+
+// blocking seek: returns 0, or -1 if it failed (or the kernel doesn't do File.Seek)
+int Kernel_Seek(int fd, uint32_t position);
+
+// returns KERNEL_IO_PENDING while the request is still with the kernel, otherwise its result (and the handle is freed)
+int Kernel_IOResult(int handle);
+
+// pass the current event (from NextEvent) here if it's not one the caller handles itself
+// returns true if it was a file or directory event, and has been taken care of
+bool Kernel_DispatchEvent(void);
+
 #endif /* KERNEL_H_ */
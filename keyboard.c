@@ -21,6 +21,7 @@
 #include "f256.h"
 // #include "comm_buffer.h"	// just need for debugging
 #include "general.h"
+#include "kernel.h"
 #include "memory.h"
 
 // C includes
@@ -59,6 +60,7 @@
 static uint8_t			keyboard_queue_entries;
 static uint8_t			keyboard_queue[KEYBOARD_QUEUE_SIZE];
 static KeyRepeater		keyboard_repeater;
+static bool				keyboard_clock_due;		// the minute timer fired: redraw the clock at the next safe moment
 
 
 /*****************************************************************************/
@@ -89,6 +91,8 @@ extern uint8_t	zp_temp_4;
 uint8_t Keyboard_PopQueue(void);
 
 // Calls kernel.nextEvent but also updates keyboard state events.
+// returns 0 if no event was waiting, 1 for a key event, 255 for a timer, 2 for anything else
+// file and directory events are passed on to kernel.c, which matches them to the request waiting on them
 uint8_t Keyboard_GetNextEvent(void);
 
 // Process a key PRESSED/RELEASED, updating key status bit array
@@ -137,6 +141,8 @@ uint8_t Keyboard_PopQueue(void)
 
 
 // Calls kernel.nextEvent but also updates keyboard state events.
+// returns 0 if no event was waiting, 1 for a key event, 255 for a timer, 2 for anything else
+// file and directory events are passed on to kernel.c, which matches them to the request waiting on them
 uint8_t Keyboard_GetNextEvent(void)
 {
 	CALL(NextEvent);
@@ -153,7 +159,10 @@ uint8_t Keyboard_GetNextEvent(void)
 	}
 	else if (event.type != EVENT(key.PRESSED) && event.type != EVENT(key.RELEASED))
 	{
-		return 0;
+		// LOGIC: this is the one place events are taken from the kernel, so a disk request's completion
+		//   has to be handed on from here, and the loop has to keep going: there may be more events queued up
+		Kernel_DispatchEvent();
+		return 2;
 	}
 
 	// We have a keyboard event. (which includes possibility of joystick event, on F256)
@@ -282,7 +291,9 @@ uint8_t Keyboard_HandleRepeatTimerEvent(void)
 	// before checking for keyboard repeats, check if this is our minute-timer cookie
 	if (event.timer.cookie == MINUTE_TIMER_COOKIE)
 	{
-		App_DisplayTime();
+		// LOGIC: events are also processed while kernel.c waits on the disk, in the middle of whatever called it.
+		//   drawing the clock then could clobber global_string_buff1 or the I/O page, so it waits for Keyboard_GetKeyIfPressed()
+		keyboard_clock_due = true;
 		Keyboard_ScheduleMinuteHandRepeatEvent();	// schedule the next one
 		return 0;
 	}
@@ -377,6 +388,12 @@ char Keyboard_GetChar(void)
 // Check to see if keystroke events pending - does not wait for a key
 uint8_t Keyboard_GetKeyIfPressed(void)
 {
+	if (keyboard_clock_due)
+	{
+		keyboard_clock_due = false;
+		App_DisplayTime();
+	}
+	
 	// if there is anything in the queue, pop it and return it.
 	if (keyboard_queue_entries > 0)
 	{
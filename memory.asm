@@ -48,6 +48,8 @@
 
 	.exportzp	_global_string_buffer
 	.exportzp	_global_string_buffer2
+	.exportzp	_zp_irq_ptr
+	.exportzp	_zp_irq_temp
 	
 
 ; F256 DMA addresses and bit values
@@ -95,6 +97,8 @@ _zp_old_io_page:		.res 1	;-- $26
 
 _global_string_buffer:			.res 2;
 _global_string_buffer2:			.res 2;
+_zp_irq_ptr:			.res 2	;-- $2B. reserved for the IRQ handler in interrupt.asm. never touch from mainline code.
+_zp_irq_temp:			.res 2	;-- $2D. reserved for the IRQ handler in interrupt.asm. never touch from mainline code.
 	
 	
 ; ---------------------------------------------------------------
@@ -303,6 +307,8 @@ _global_string_buffer2:			.res 2;
 ;// in other words, no need to page either dst or src into CPU space
 
 ; status - 2024-03-17: DMA works (1 out of 5 or so times), but very unstable. others report same instability. commenting out until a more stable way can be identified. 
+; note: even when stable, DMA only reaches system bus RAM. text char/attr RAM is only visible through IO pages 2/3, so
+;   DMA can't scroll or fill the text screen. Text_ScrollTextAndAttrRowsUp() and the box fills use block moves instead.
 
 
 ;.segment	"CODE"
@@ -48,6 +48,8 @@
 #define ZP_TEMP_1			0x24	// zero-page address we will use for temp variable storage in assembly routines
 #define ZP_OTHER_PARAM		0x25	// zero-page address we will use for communicating 1 byte to/from assembly routines
 #define ZP_OLD_IO_PAGE		0x26	// zero-page address holding the original IO page # before being changed
+#define ZP_IRQ_PTR			0x2B	// zero-page address of a 2-byte pointer owned by the IRQ handler (interrupt.asm). not for mainline use.
+#define ZP_IRQ_TEMP			0x2D	// zero-page address of 2 bytes of scratch owned by the IRQ handler (interrupt.asm). not for mainline use.
 //#define ZP_X				0x13	// zero-page address we will use for passing X coordinate to assembly routines
 //#define ZP_Y				0x14	// zero-page address we will use for passing Y coordinate to assembly routines
 //#define ZP_SCREEN_ID		0x15	// zero-page address we will use for passing the screen ID to assembly routines
@@ -59,14 +61,56 @@
 //#define EM_STORAGE_START_SLOT				0x06		// the 0-7 local CPU slot to map it into - i/o + kernel#2 slot
 #define EM_STORAGE_START_SLOT				0x05		// the 0-7 local CPU slot to map it into - overlay slot
 #define EM_STORAGE_START_PHYS_BANK_NUM		0x14		// the system physical bank number/slot where EM storage starts for us.
+#define KERNEL_SHADOW_PHYS_BANK_NUM		0x1C		// RAM copy of the kernel's $E000-$FFFF bank, with the IRQ vector pointed at us. see interrupt.asm
+
+// shadow copy of the terminal body (see shadow.c). mapped into the overlay slot only while a chunk of received data is rendered
+#define SHADOW_PHYS_BANK_NUM			0x1E
+#define SHADOW_SLOT						EM_STORAGE_START_SLOT
+#define SHADOW_CPU_ADDR					EM_STORAGE_START_CPU_ADDR
+
+// scrollback history (see scrollback.c): fixed 160 byte lines (80 chars, then 80 attrs), 46 to a bank, in banks 0x28-0x3F
+//   each bank ends with the 16 byte search signatures of its own 46 lines, so a search maps each bank once
+#define SCROLLBACK_FIRST_PHYS_BANK_NUM	0x28
+#define SCROLLBACK_NUM_BANKS			24
+#define SCROLLBACK_LINE_SIZE			160
+#define SCROLLBACK_LINES_PER_BANK		46			// 46 x 160 = 7360, + 46 x 16 = 736 of signatures = 8096 of 8192 bytes
+#define SCROLLBACK_MAX_LINES			((uint16_t)SCROLLBACK_NUM_BANKS * SCROLLBACK_LINES_PER_BANK)	// 1104
+#define SCROLLBACK_SIG_SIZE				16			// 128 bit bigram bitset per line
+#define SCROLLBACK_SIG_SHIFT			4			// line # << this = offset of its signature
+#define SCROLLBACK_SIG_OFFSET			((uint16_t)SCROLLBACK_LINES_PER_BANK * SCROLLBACK_LINE_SIZE)	// 7360
+#define SCROLLBACK_SLOT					EM_STORAGE_START_SLOT
+#define SCROLLBACK_CPU_ADDR				EM_STORAGE_START_CPU_ADDR
+#define SCROLLBACK_SIG_CPU_ADDR			(SCROLLBACK_CPU_ADDR + SCROLLBACK_SIG_OFFSET)
+
+// file transfer staging buffer (see staging.c): a ring of file data in banks 0x14-0x17, between the disk and the serial port
+//   mapped into the overlay slot only while data is copied in or out of it
+#define STAGING_START_PHYS_BANK_NUM		EM_STORAGE_START_PHYS_BANK_NUM	// 0x14
+#define STAGING_NUM_BANKS				4			// 4 x 8K = 32K: ~2.8 seconds of sending at 115200
+#define STAGING_SLOT					EM_STORAGE_START_SLOT
+#define STAGING_CPU_ADDR				EM_STORAGE_START_CPU_ADDR
+#define STAGING_BANK_SIZE				0x2000
+#define STAGING_BANK_SHIFT				13			// ring position >> this = bank offset from STAGING_START_PHYS_BANK_NUM
+#define STAGING_SIZE					((uint16_t)STAGING_NUM_BANKS * STAGING_BANK_SIZE)
+#define STAGING_MASK					((uint16_t)(STAGING_SIZE - 1))
 
 #define STORAGE_INTERBANK_BUFFER		0x0400	// 1-page buffer. see cc65 memory config file. this is outside cc65 space.
 #define STORAGE_INTERBANK_BUFFER_LEN	0x0100	// 1-page buffer. see cc65 memory config file. this is outside cc65 space.
-#define STORAGE_UART_BUFFER				0x0500	// outside of cc65 memory space. see config file. 
-#define STORAGE_UART_BUFFER_LEN			0x299	// = 665. purely based on memory map config so that startup is at 799. just because that matches f/manager jr. all changeable. 
 
-#define UART_BUFFER_START_ADDR			STORAGE_UART_BUFFER
-#define UART_BUFFER_SIZE				STORAGE_UART_BUFFER_LEN
+// UART receive ring buffer. lives in extended memory and is fed by the IRQ handler in interrupt.asm (keep its constants in sync!)
+// size is set at build time: a power-of-two number of 8K banks (1, 2, 4, or 8). 64K is the max, as ring positions are 16 bit.
+// the ring is only ever mapped in (to the overlay slot) by the IRQ handler, or by Serial_RingRead() while it copies out a run of bytes
+#define UART_RING_NUM_BANKS				8			// 8 x 8K = 64K = ~5.7 seconds of data at 115200
+#define UART_RING_START_PHYS_BANK_NUM	0x20		// banks 0x20-0x27 (0x40000-0x4FFFF)
+#define UART_RING_SLOT					EM_STORAGE_START_SLOT
+#define UART_RING_START_CPU_ADDR		EM_STORAGE_START_CPU_ADDR
+#define UART_RING_BANK_SIZE				0x2000
+#define UART_RING_BANK_SHIFT			13			// ring position >> this = bank offset from UART_RING_START_PHYS_BANK_NUM
+#define UART_RING_SIZE					((uint32_t)UART_RING_NUM_BANKS * UART_RING_BANK_SIZE)
+#define UART_RING_MASK					((uint16_t)(UART_RING_SIZE - 1))
+#define UART_RING_HIGH_WATER			((uint16_t)(UART_RING_SIZE - UART_RING_SIZE / 4))	// at/above this fill level, ask the other side to stop sending (if flow control is on)
+#define UART_RING_LOW_WATER				((uint16_t)(UART_RING_SIZE / 4))					// at/below this fill level, let the other side resume
+
+#define UART_RX_CHUNK_SIZE				256			// max bytes Serial_ProcessAvailableData() pulls out of the ring per call
 
 /*****************************************************************************/
 /*                               Enumerations                                */
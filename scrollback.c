@@ -0,0 +1,698 @@
+/*
+ * scrollback.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+// history of lines scrolled off the top of the terminal body, kept in extended memory
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "scrollback.h"
+#include "app.h"
+#include "comm_buffer.h"
+#include "general.h"
+#include "keyboard.h"
+#include "memory.h"
+#include "screen.h"
+#include "serial.h"
+#include "shadow.h"
+#include "strings.h"
+#include "text.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// F256 includes
+#include "f256.h"
+
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define SCROLLBACK_ACTION_SEARCH	CH_FSLASH	// in the history view, starts a search
+
+#define SCROLLBACK_MAX_QUERY_LEN	32
+#define SCROLLBACK_NOT_FOUND		0xFFFF
+#define SCROLLBACK_NO_MATCH_COL		0xFF
+#define SCROLLBACK_INDEX_BATCH		4			// lines signed per Scrollback_IndexIdle() call
+#define SCROLLBACK_SIG_INDEXED		0x01		// always set in byte 0 of a computed signature. all-zero signature = not signed yet
+
+
+/*****************************************************************************/
+/*                           File-scoped Variables                           */
+/*****************************************************************************/
+
+static uint16_t		scrollback_count;			// lines currently held
+static uint16_t		scrollback_next;			// ring slot the next line goes into (0 to SCROLLBACK_MAX_LINES - 1)
+static uint8_t		scrollback_next_bank;		// bank (relative to SCROLLBACK_FIRST_PHYS_BANK_NUM) of scrollback_next
+static uint8_t		scrollback_next_bank_line;	// line within that bank of scrollback_next
+static uint8_t*		scrollback_next_loc = (uint8_t*)SCROLLBACK_CPU_ADDR;	// CPU address of scrollback_next, when its bank is mapped
+static uint16_t		scrollback_unindexed;		// newest lines whose signature may not be computed yet
+
+static uint8_t		scrollback_loc_bank;		// set by Scrollback_LocateLine()
+static uint8_t		scrollback_loc_line;		// set by Scrollback_LocateLine()
+
+static char			scrollback_query[SCROLLBACK_MAX_QUERY_LEN + 1];	// search text, lower case
+static uint8_t		scrollback_query_len;
+static uint8_t		scrollback_query_sig[SCROLLBACK_SIG_SIZE];
+static uint16_t		scrollback_search_start;	// line the search began from (newest line it looks at)
+static uint16_t		scrollback_match;			// line of the current match, or SCROLLBACK_NOT_FOUND
+static uint8_t		scrollback_match_col;		// column of the current match
+
+static const uint8_t	scrollback_bit[8] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+extern uint8_t			zp_bank_num;
+#pragma zpsym ("zp_bank_num");
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// work out which history bank, and which line within that bank, holds the_index (0 = oldest line)
+// sets scrollback_loc_bank and scrollback_loc_line
+void Scrollback_LocateLine(uint16_t the_index);
+
+// build the bigram signature of the_len chars (1+) into the_sig (SCROLLBACK_SIG_SIZE bytes)
+void Scrollback_MakeSignature(uint8_t* the_chars, uint8_t the_len, uint8_t* the_sig);
+
+// returns the column of the first match of scrollback_query in the chars of the_line, or SCROLLBACK_NO_MATCH_COL
+uint8_t Scrollback_MatchInLine(uint8_t* the_line);
+
+// search the history for scrollback_query, from the_index (inclusive) back toward the oldest line
+// returns the index of the first matching line found, with the column in scrollback_match_col, or SCROLLBACK_NOT_FOUND
+uint16_t Scrollback_FindOlder(uint16_t the_index);
+
+// handle a key typed while searching, and move scrollback_match accordingly
+// returns false if the key isn't a search key (so cursor keys etc. still move the view)
+bool Scrollback_SearchKey(uint8_t the_key);
+
+// highlight the current match, if it is in view, and draw the search text on the bottom row of the history view
+void Scrollback_DrawSearch(uint16_t the_top);
+
+// draw a page of the history view into the terminal body
+// the_top is the line shown in the top row: 0 to scrollback_count-1 are history lines, and the live terminal rows follow on
+void Scrollback_DrawPage(uint16_t the_top);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// work out which history bank, and which line within that bank, holds the_index (0 = oldest line)
+// sets scrollback_loc_bank and scrollback_loc_line
+void Scrollback_LocateLine(uint16_t the_index)
+{
+	uint16_t	the_slot;
+	
+	// LOGIC:
+	//   oldest line is scrollback_count slots behind scrollback_next, wrapping around the ring
+	
+	the_slot = scrollback_next + the_index;
+	
+	if (the_slot < scrollback_count)
+	{
+		the_slot += SCROLLBACK_MAX_LINES;
+	}
+	
+	the_slot -= scrollback_count;
+	
+	if (the_slot >= SCROLLBACK_MAX_LINES)
+	{
+		the_slot -= SCROLLBACK_MAX_LINES;
+	}
+	
+	scrollback_loc_bank = the_slot / SCROLLBACK_LINES_PER_BANK;
+	scrollback_loc_line = the_slot - (uint16_t)scrollback_loc_bank * SCROLLBACK_LINES_PER_BANK;
+}
+
+
+// build the bigram signature of the_len chars (1+) into the_sig (SCROLLBACK_SIG_SIZE bytes)
+void Scrollback_MakeSignature(uint8_t* the_chars, uint8_t the_len, uint8_t* the_sig)
+{
+	uint8_t		i;
+	uint8_t		the_char;
+	uint8_t		prev_char;
+	uint8_t		the_hash;
+	
+	// LOGIC:
+	//   the signature is a 128 bit set: each pair of neighbouring chars hashes to one bit. a line can only contain the
+	//   search text if its set has every bit the search text's set has, so most lines are ruled out by 16 byte compares
+	//   without looking at their 80 chars. "| 0x20" folds case (and a few punctuation pairs, which is harmless: it only
+	//   lets a line through to the real compare, never keeps a matching line out).
+	//   bit 0 is also always set, so a line with a signature is never all zero, which is how unsigned lines are marked.
+	//   prev << 3 moves the first char's bits clear of most of the second's; "<< 1" overlapped them almost bit for bit.
+	//   searching for a 3-8 letter word, ~7% of full 80 column lines without it still get through to the compare
+	//   (~22% at 64 bits), and ~3% of the lines of a typical screen, short ones included (~10% at 64 bits).
+	
+	memset(the_sig, 0, SCROLLBACK_SIG_SIZE);
+	the_sig[0] = SCROLLBACK_SIG_INDEXED;
+	
+	prev_char = the_chars[0] | 0x20;
+	
+	for (i = 1; i < the_len; i++)
+	{
+		the_char = the_chars[i] | 0x20;
+		the_hash = ((prev_char << 3) ^ the_char) & 0x7F;
+		the_sig[the_hash >> 3] |= scrollback_bit[the_hash & 0x07];
+		prev_char = the_char;
+	}
+}
+
+
+// returns the column of the first match of scrollback_query in the chars of the_line, or SCROLLBACK_NO_MATCH_COL
+uint8_t Scrollback_MatchInLine(uint8_t* the_line)
+{
+	uint8_t		the_col;
+	uint8_t		last_col;
+	uint8_t		i;
+	uint8_t		the_char;
+	
+	last_col = TERM_BODY_WIDTH - scrollback_query_len;
+	
+	for (the_col = 0; the_col <= last_col; the_col++)
+	{
+		for (i = 0; i < scrollback_query_len; i++)
+		{
+			the_char = the_line[the_col + i];
+			
+			if (the_char >= 'A' && the_char <= 'Z')
+			{
+				the_char += ('a' - 'A');
+			}
+			
+			if (the_char != (uint8_t)scrollback_query[i])
+			{
+				break;
+			}
+		}
+		
+		if (i == scrollback_query_len)
+		{
+			return the_col;
+		}
+	}
+	
+	return SCROLLBACK_NO_MATCH_COL;
+}
+
+
+// search the history for scrollback_query, from the_index (inclusive) back toward the oldest line
+// returns the index of the first matching line found, with the column in scrollback_match_col, or SCROLLBACK_NOT_FOUND
+uint16_t Scrollback_FindOlder(uint16_t the_index)
+{
+	uint8_t*	the_line;
+	uint8_t*	the_sig;
+	uint8_t		i;
+	uint8_t		the_col;
+	uint8_t		mapped_bank;
+	uint8_t		previous_bank;
+	uint16_t	result = SCROLLBACK_NOT_FOUND;
+	
+	// LOGIC:
+	//   walk the ring backwards one line at a time, stepping bank/line directly (no division per line), and only
+	//   remapping the overlay slot when the walk crosses into another bank. the signatures of a bank's lines are in the
+	//   same bank, so a line that is ruled out by its signature costs at most 16 byte compares. lines the idle indexer hasn't
+	//   got to yet are signed here on the way past, which makes them cheap for the next search.
+	
+	Scrollback_LocateLine(the_index);
+	
+	mapped_bank = scrollback_loc_bank;
+	zp_bank_num = SCROLLBACK_FIRST_PHYS_BANK_NUM + mapped_bank;
+	previous_bank = Memory_SwapInNewBank(SCROLLBACK_SLOT);
+	
+	while (true)
+	{
+		if (scrollback_loc_bank != mapped_bank)
+		{
+			mapped_bank = scrollback_loc_bank;
+			zp_bank_num = SCROLLBACK_FIRST_PHYS_BANK_NUM + mapped_bank;
+			Memory_SwapInNewBank(SCROLLBACK_SLOT);
+		}
+		
+		the_line = (uint8_t*)SCROLLBACK_CPU_ADDR + (uint16_t)scrollback_loc_line * SCROLLBACK_LINE_SIZE;
+		the_sig = (uint8_t*)SCROLLBACK_SIG_CPU_ADDR + ((uint16_t)scrollback_loc_line << SCROLLBACK_SIG_SHIFT);
+		
+		if (the_sig[0] == 0)
+		{
+			Scrollback_MakeSignature(the_line, TERM_BODY_WIDTH, the_sig);
+		}
+		
+		for (i = 0; i < SCROLLBACK_SIG_SIZE; i++)
+		{
+			if ((the_sig[i] & scrollback_query_sig[i]) != scrollback_query_sig[i])
+			{
+				break;
+			}
+		}
+		
+		if (i == SCROLLBACK_SIG_SIZE)
+		{
+			the_col = Scrollback_MatchInLine(the_line);
+			
+			if (the_col != SCROLLBACK_NO_MATCH_COL)
+			{
+				scrollback_match_col = the_col;
+				result = the_index;
+				break;
+			}
+		}
+		
+		if (the_index == 0)
+		{
+			break;
+		}
+		
+		--the_index;
+		
+		if (scrollback_loc_line == 0)
+		{
+			scrollback_loc_line = SCROLLBACK_LINES_PER_BANK - 1;
+			scrollback_loc_bank = (scrollback_loc_bank == 0) ? SCROLLBACK_NUM_BANKS - 1 : scrollback_loc_bank - 1;
+		}
+		else
+		{
+			--scrollback_loc_line;
+		}
+	}
+	
+	zp_bank_num = previous_bank;
+	Memory_SwapInNewBank(SCROLLBACK_SLOT);
+	
+	return result;
+}
+
+
+// handle a key typed while searching, and move scrollback_match accordingly
+// returns false if the key isn't a search key (so cursor keys etc. still move the view)
+bool Scrollback_SearchKey(uint8_t the_key)
+{
+	uint16_t	search_from;
+	uint16_t	the_match;
+	
+	if (the_key >= CH_SPACE && the_key < 0x7F)
+	{
+		if (scrollback_query_len == SCROLLBACK_MAX_QUERY_LEN)
+		{
+			return true;
+		}
+		
+		if (the_key >= 'A' && the_key <= 'Z')
+		{
+			the_key += ('a' - 'A');
+		}
+		
+		scrollback_query[scrollback_query_len++] = the_key;
+		scrollback_query[scrollback_query_len] = 0;
+		
+		// LOGIC:
+		//   the longer text can't match anywhere newer than where the shorter text first did, so carry on from there
+		search_from = (scrollback_match != SCROLLBACK_NOT_FOUND) ? scrollback_match : scrollback_search_start;
+	}
+	else if (the_key == CH_BKSP)
+	{
+		if (scrollback_query_len == 0)
+		{
+			return true;
+		}
+		
+		scrollback_query[--scrollback_query_len] = 0;
+		search_from = scrollback_search_start;
+	}
+	else if (the_key == ACTION_CONFIRM)
+	{
+		if (scrollback_query_len == 0)
+		{
+			return true;
+		}
+		
+		if (scrollback_match == SCROLLBACK_NOT_FOUND)
+		{
+			search_from = scrollback_search_start;
+		}
+		else if (scrollback_match == 0)
+		{
+			Buffer_NewMessage(General_GetString(ID_STR_MSG_SCROLLBACK_NOT_FOUND));
+			return true;
+		}
+		else
+		{
+			search_from = scrollback_match - 1;
+		}
+	}
+	else
+	{
+		return false;
+	}
+	
+	// LOGIC:
+	//   a single char has no pairs, so its signature rules nothing out and every line would be scanned in full.
+	//   wait for a second char before searching as-you-type; ENTER still searches for a single char if asked.
+	
+	if (scrollback_query_len < 2 && the_key != ACTION_CONFIRM)
+	{
+		scrollback_match = SCROLLBACK_NOT_FOUND;
+		return true;
+	}
+	
+	Scrollback_MakeSignature((uint8_t*)scrollback_query, scrollback_query_len, scrollback_query_sig);
+	the_match = Scrollback_FindOlder(search_from);
+	
+	if (the_match == SCROLLBACK_NOT_FOUND)
+	{
+		Buffer_NewMessage(General_GetString(ID_STR_MSG_SCROLLBACK_NOT_FOUND));
+		
+		if (the_key == ACTION_CONFIRM)
+		{
+			// keep showing the last match: there is just nothing older
+			return true;
+		}
+	}
+	
+	scrollback_match = the_match;
+	
+	return true;
+}
+
+
+// highlight the current match, if it is in view, and draw the search text on the bottom row of the history view
+void Scrollback_DrawSearch(uint16_t the_top)
+{
+	char*		the_prompt;
+	uint8_t		x;
+	uint8_t		y;
+	
+	if (scrollback_match != SCROLLBACK_NOT_FOUND && scrollback_match >= the_top && scrollback_match - the_top < TERM_BODY_HEIGHT - 1)
+	{
+		x = TERM_BODY_X1 + scrollback_match_col;
+		y = TERM_BODY_Y1 + (uint8_t)(scrollback_match - the_top);
+		Text_InvertBox(x, y, x + scrollback_query_len - 1, y);
+	}
+	
+	the_prompt = General_GetString(ID_STR_LBL_SCROLLBACK_FIND);
+	strcat(the_prompt, scrollback_query);
+	
+	Text_FillBox(TERM_BODY_X1, TERM_BODY_Y2, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, COLOR_BRIGHT_WHITE, COLOR_BLACK);
+	Text_DrawStringAtXY(TERM_BODY_X1, TERM_BODY_Y2, the_prompt, COLOR_BRIGHT_WHITE, COLOR_BLACK);
+}
+
+
+// draw a page of the history view into the terminal body
+// the_top is the line shown in the top row: 0 to scrollback_count-1 are history lines, and the live terminal rows follow on
+void Scrollback_DrawPage(uint16_t the_top)
+{
+	uint8_t		i;
+	
+	for (i = 0; i < TERM_BODY_HEIGHT; i++)
+	{
+		if (the_top < scrollback_count)
+		{
+			Scrollback_GetLine(the_top, (uint8_t*)STORAGE_INTERBANK_BUFFER);
+			Text_DrawRowFromBuffer(TERM_BODY_Y1 + i, (uint8_t*)STORAGE_INTERBANK_BUFFER);
+		}
+		else
+		{
+			Shadow_DrawRowAt(the_top - scrollback_count, TERM_BODY_Y1 + i);
+		}
+		
+		++the_top;
+	}
+}
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// add a line to the history, dropping the oldest line if full
+// the_line is SCROLLBACK_LINE_SIZE bytes (80 chars, then 80 attrs), and must not be in the overlay slot
+void Scrollback_AddLine(uint8_t* the_line)
+{
+	uint8_t		previous_bank;
+	
+	// LOGIC:
+	//   this runs for every line that scrolls off, so no division here: the bank/line/address of the next slot are
+	//   tracked alongside the slot number, and stepped forward together.
+	
+	zp_bank_num = SCROLLBACK_FIRST_PHYS_BANK_NUM + scrollback_next_bank;
+	previous_bank = Memory_SwapInNewBank(SCROLLBACK_SLOT);
+	
+	memcpy(scrollback_next_loc, the_line, SCROLLBACK_LINE_SIZE);
+	
+	// LOGIC:
+	//   the search signature is not computed here, to keep scrolling fast: it is just marked as not done yet, and
+	//   Scrollback_IndexIdle() (or a search that gets there first) fills it in later
+	memset((uint8_t*)SCROLLBACK_SIG_CPU_ADDR + ((uint16_t)scrollback_next_bank_line << SCROLLBACK_SIG_SHIFT), 0, SCROLLBACK_SIG_SIZE);
+	
+	zp_bank_num = previous_bank;
+	Memory_SwapInNewBank(SCROLLBACK_SLOT);
+	
+	if (++scrollback_next_bank_line == SCROLLBACK_LINES_PER_BANK)
+	{
+		scrollback_next_bank_line = 0;
+		scrollback_next_loc = (uint8_t*)SCROLLBACK_CPU_ADDR;
+		
+		if (++scrollback_next_bank == SCROLLBACK_NUM_BANKS)
+		{
+			scrollback_next_bank = 0;
+		}
+	}
+	else
+	{
+		scrollback_next_loc += SCROLLBACK_LINE_SIZE;
+	}
+	
+	if (++scrollback_next == SCROLLBACK_MAX_LINES)
+	{
+		scrollback_next = 0;
+	}
+	
+	if (scrollback_count < SCROLLBACK_MAX_LINES)
+	{
+		++scrollback_count;
+	}
+	
+	if (scrollback_unindexed < scrollback_count)
+	{
+		++scrollback_unindexed;
+	}
+}
+
+
+// compute the search signatures of a few of the newest lines that don't have one yet
+// meant for the main loop to call when there is no received data to process
+void Scrollback_IndexIdle(void)
+{
+	uint8_t		i;
+	uint8_t		previous_bank;
+	uint8_t*	the_sig;
+	
+	for (i = 0; i < SCROLLBACK_INDEX_BATCH && scrollback_unindexed > 0; i++)
+	{
+		Scrollback_LocateLine(scrollback_count - scrollback_unindexed);
+		
+		zp_bank_num = SCROLLBACK_FIRST_PHYS_BANK_NUM + scrollback_loc_bank;
+		previous_bank = Memory_SwapInNewBank(SCROLLBACK_SLOT);
+		
+		the_sig = (uint8_t*)SCROLLBACK_SIG_CPU_ADDR + ((uint16_t)scrollback_loc_line << SCROLLBACK_SIG_SHIFT);
+		
+		if (the_sig[0] == 0)
+		{
+			Scrollback_MakeSignature((uint8_t*)SCROLLBACK_CPU_ADDR + (uint16_t)scrollback_loc_line * SCROLLBACK_LINE_SIZE, TERM_BODY_WIDTH, the_sig);
+		}
+		
+		zp_bank_num = previous_bank;
+		Memory_SwapInNewBank(SCROLLBACK_SLOT);
+		
+		--scrollback_unindexed;
+	}
+}
+
+
+// returns the number of lines currently in the history
+uint16_t Scrollback_GetLineCount(void)
+{
+	return scrollback_count;
+}
+
+
+// copy a line from the history into the_buffer (SCROLLBACK_LINE_SIZE bytes, must not be in the overlay slot)
+// the_index is 0 for the oldest line, up to Scrollback_GetLineCount() - 1 for the newest
+void Scrollback_GetLine(uint16_t the_index, uint8_t* the_buffer)
+{
+	uint8_t		previous_bank;
+	
+	Scrollback_LocateLine(the_index);
+	
+	zp_bank_num = SCROLLBACK_FIRST_PHYS_BANK_NUM + scrollback_loc_bank;
+	previous_bank = Memory_SwapInNewBank(SCROLLBACK_SLOT);
+	
+	memcpy(the_buffer, (uint8_t*)SCROLLBACK_CPU_ADDR + (uint16_t)scrollback_loc_line * SCROLLBACK_LINE_SIZE, SCROLLBACK_LINE_SIZE);
+	
+	zp_bank_num = previous_bank;
+	Memory_SwapInNewBank(SCROLLBACK_SLOT);
+}
+
+
+// let the user page through the history in the terminal body, until they hit ESC
+// the terminal body is put back as it was when done. received data waits in the RX buffer meanwhile.
+void Scrollback_View(void)
+{
+	uint16_t	the_top;
+	uint16_t	live_top;
+	uint16_t	shown_match;
+	uint8_t		user_input;
+	uint8_t		cursor_x;
+	uint8_t		cursor_y;
+	bool		redraw = true;
+	bool		searching = false;
+	bool		done = false;
+	
+	// LOGIC:
+	//   the view is a window onto the history followed by the live terminal rows. the_top is the line in the top row.
+	//   live_top is the_top's value when the window shows only the live terminal, which is as far down as it goes.
+	//   nothing is rendered while viewing, so the history doesn't change under us. incoming data collects in the RX ring
+	//   (the IRQ handler keeps draining the UART; flow control, if on, pauses the other side if the ring gets full).
+	//   while searching, the bottom row shows the search text, and the view is moved to keep the match on screen.
+	
+	if (scrollback_count == 0)
+	{
+		Buffer_NewMessage(General_GetString(ID_STR_MSG_SCROLLBACK_EMPTY));
+		return;
+	}
+	
+	cursor_x = Text_GetX();
+	cursor_y = Text_GetY();
+	
+	Shadow_Save();
+	Buffer_NewMessage(General_GetString(ID_STR_MSG_SCROLLBACK_VIEW));
+	
+	live_top = scrollback_count;
+	the_top = (live_top > TERM_BODY_HEIGHT) ? live_top - TERM_BODY_HEIGHT : 0;
+	
+	while (!done)
+	{
+		if (redraw)
+		{
+			Scrollback_DrawPage(the_top);
+			
+			if (searching)
+			{
+				Scrollback_DrawSearch(the_top);
+			}
+			
+			redraw = false;
+		}
+		
+		Serial_ReadUART();
+		user_input = Keyboard_GetKeyIfPressed();
+		
+		if (user_input == 0)
+		{
+			continue;
+		}
+		
+		if (searching)
+		{
+			if (user_input == ACTION_CANCEL || user_input == ACTION_CANCEL_ALT)
+			{
+				searching = false;
+				redraw = true;
+				continue;
+			}
+			
+			shown_match = scrollback_match;
+			
+			if (Scrollback_SearchKey(user_input))
+			{
+				if (scrollback_match != shown_match && scrollback_match != SCROLLBACK_NOT_FOUND)
+				{
+					// bring the match to the middle of the view, unless that would go past the live rows
+					the_top = (scrollback_match > TERM_BODY_HEIGHT / 2) ? scrollback_match - TERM_BODY_HEIGHT / 2 : 0;
+					
+					if (the_top > live_top)
+					{
+						the_top = live_top;
+					}
+				}
+				
+				redraw = true;
+				continue;
+			}
+		}
+		
+		switch (user_input)
+		{
+			case MOVE_UP:
+				if (the_top > 0)
+				{
+					--the_top;
+					redraw = true;
+				}
+				break;
+				
+			case MOVE_DOWN:
+				if (the_top < live_top)
+				{
+					++the_top;
+					redraw = true;
+				}
+				break;
+				
+			case MOVE_LEFT:
+				the_top = (the_top > TERM_BODY_HEIGHT) ? the_top - TERM_BODY_HEIGHT : 0;
+				redraw = true;
+				break;
+				
+			case MOVE_RIGHT:
+				the_top = (live_top - the_top > TERM_BODY_HEIGHT) ? the_top + TERM_BODY_HEIGHT : live_top;
+				redraw = true;
+				break;
+				
+			case SCROLLBACK_ACTION_SEARCH:
+				scrollback_query[0] = 0;
+				scrollback_query_len = 0;
+				scrollback_match = SCROLLBACK_NOT_FOUND;
+				
+				// search starts from the history line at the bottom of the view (or the newest, if the view is on live rows)
+				scrollback_search_start = the_top + TERM_BODY_HEIGHT - 1;
+				
+				if (scrollback_search_start >= scrollback_count)
+				{
+					scrollback_search_start = scrollback_count - 1;
+				}
+				
+				Buffer_NewMessage(General_GetString(ID_STR_MSG_SCROLLBACK_SEARCH));
+				searching = true;
+				redraw = true;
+				break;
+				
+			case ACTION_CANCEL:
+			case ACTION_CANCEL_ALT:
+				done = true;
+				break;
+				
+			default:
+				break;
+		}
+	}
+	
+	Shadow_Restore();
+	Text_SetXY(cursor_x, cursor_y);
+}
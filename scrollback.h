@@ -0,0 +1,83 @@
+/*
+ * scrollback.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+#ifndef SCROLLBACK_H_
+#define SCROLLBACK_H_
+
+
+
+/* about this class: Scrollback
+ *
+ * history of the lines that have scrolled off the top of the terminal body
+ *
+ *** things this class needs to be able to do
+ *
+ * take a line (chars + attrs) as it scrolls off the top, with one copy into extended memory
+ * hand back any stored line by index, oldest first
+ * let the user page back through history, while incoming data keeps collecting in the RX buffer
+ * search the history as the user types, highlighting matches
+ *
+ *** things objects of this class have
+ *
+ * a ring of fixed-size lines spread over several extended memory banks (see SCROLLBACK_* in memory.h)
+ * a bigram signature per line, in the same bank as the line, so a search can skip most lines without reading them
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "app.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// add a line to the history, dropping the oldest line if full
+// the_line is SCROLLBACK_LINE_SIZE bytes (80 chars, then 80 attrs), and must not be in the overlay slot
+void Scrollback_AddLine(uint8_t* the_line);
+
+// compute the search signatures of a few of the newest lines that don't have one yet
+// meant for the main loop to call when there is no received data to process
+void Scrollback_IndexIdle(void);
+
+// returns the number of lines currently in the history
+uint16_t Scrollback_GetLineCount(void);
+
+// copy a line from the history into the_buffer (SCROLLBACK_LINE_SIZE bytes, must not be in the overlay slot)
+// the_index is 0 for the oldest line, up to Scrollback_GetLineCount() - 1 for the newest
+void Scrollback_GetLine(uint16_t the_index, uint8_t* the_buffer);
+
+// let the user page through the history in the terminal body, until they hit ESC
+// the terminal body is put back as it was when done. received data waits in the RX buffer meanwhile.
+void Scrollback_View(void);
+
+
+#endif /* SCROLLBACK_H_ */
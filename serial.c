@@ -17,9 +17,11 @@
 #include "comm_buffer.h"
 #include "debug.h"
 #include "general.h"
+#include "interrupt.h"
 #include "memory.h"
 #include "screen.h"
 #include "serial.h"
+#include "shadow.h"
 #include "strings.h"
 #include "sys.h"
 #include "text.h"
@@ -44,8 +46,55 @@
 #define TERMINAL_DEFAULT_BACK_COLOR		ANSI_COLOR_BLACK	// defined by ANSI. do not change.
 #define TERMINAL_DEFAULT_FORE_COLOR		ANSI_COLOR_WHITE	// defined by ANSI. do not change.
 
-#define UART_MAX_SEND_ATTEMPTS	1000
-#define ANSI_MAX_SEQUENCE_LEN	128
+#define UART_SEND_TIMEOUT_TICKS	2		// changes of the RTC seconds register (so 1-2 s) with no room in the transmit queue before a send gives up
+#define ANSI_DEL				0x7F	// ignored in the ground state: not a glyph
+#define SERIAL_ZDLE				0x18	// ZMODEM's escape char (same value as CAN). see Serial_ProcessAvailableData().
+#define SERIAL_ZRQINIT_MATCH	"\x18" "B00"	// ZDLE, then the start of a ZRQINIT hex header
+#define SERIAL_ZRQINIT_MATCH_LEN	4
+#define ANSI_MAX_PARAMS			16		// params past this many are dropped (the sequence is still consumed)
+#define ANSI_PARAM_MAX_VALUE	255		// params saturate here (they're uint8_t). ?1000h and the like only need to not wrap around.
+
+// ANSI parser states. see ansi_transition[] for how bytes move between them. loosely follows the DEC VT500 parser.
+#define ANSI_STATE_GROUND			0		// normal text
+#define ANSI_STATE_ESCAPE			1		// got ESC
+#define ANSI_STATE_ESC_INTERMEDIATE	2		// got ESC + 0x20-0x2F (eg, ESC ( B): waiting for the final byte
+#define ANSI_STATE_CSI_ENTRY		3		// got ESC [
+#define ANSI_STATE_CSI_PARAM		4		// collecting numeric params
+#define ANSI_STATE_CSI_INTERMEDIATE	5		// got 0x20-0x2F after the params: waiting for the final byte
+#define ANSI_STATE_CSI_IGNORE		6		// malformed CSI sequence: swallow everything up to the final byte
+#define ANSI_STATE_OSC_STRING		7		// got ESC ] (OSC), or ESC P/X/^/_ (DCS/SOS/PM/APC): swallow everything up to BEL or ESC (ST)
+#define ANSI_NUM_STATES				8
+
+// byte classes, for indexing ansi_transition[]
+#define ANSI_CLASS_C0				0		// control chars that print/execute in place
+#define ANSI_CLASS_BEL				1		// 0x07. also ends an OSC string
+#define ANSI_CLASS_CANCEL			2		// CAN, SUB: abort any sequence in progress
+#define ANSI_CLASS_ESC				3
+#define ANSI_CLASS_INTERMEDIATE		4		// 0x20-0x2F
+#define ANSI_CLASS_DIGIT			5		// 0-9
+#define ANSI_CLASS_COLON			6		// sub-parameter separator. not supported: sequence gets ignored
+#define ANSI_CLASS_SEMICOLON		7		// parameter separator
+#define ANSI_CLASS_PRIVATE			8		// < = > ? private parameter markers
+#define ANSI_CLASS_LBRACKET			9		// [
+#define ANSI_CLASS_RBRACKET			10		// ]
+#define ANSI_CLASS_FINAL			11		// 0x40-0x7E (other than [, ], and the string introducers below)
+#define ANSI_CLASS_DEL				12
+#define ANSI_CLASS_HIGH				13		// 0x80-0xFF. printable chars in the F256 fonts.
+#define ANSI_CLASS_STRING			14		// P X ^ _: after ESC, start a DCS/SOS/PM/APC string. elsewhere, same as FINAL.
+#define ANSI_NUM_CLASSES			15
+
+// what to do with a byte on a given transition. stored in the high nibble of each ansi_transition[] entry
+#define ANSI_ACTION_NONE			0		// swallow the byte
+#define ANSI_ACTION_PRINT			1		// print (or execute, for controls) the byte
+#define ANSI_ACTION_CLEAR			2		// start of a new sequence: forget previous params, etc.
+#define ANSI_ACTION_PARAM			3		// add a digit to the current param
+#define ANSI_ACTION_NEXT_PARAM		4		// move on to the next param
+#define ANSI_ACTION_PRIVATE			5		// remember the private marker
+#define ANSI_ACTION_COLLECT			6		// remember the intermediate byte
+#define ANSI_ACTION_CSI_DISPATCH	7		// byte is the final byte of a CSI sequence: carry it out
+#define ANSI_ACTION_ESC_DISPATCH	8		// byte is the final byte of an ESC sequence: carry it out
+
+#define ANSI_TRANSITION(action, state)	(((action) << 4) | (state))
 
 #define ANSI_FUNCTION_CUU			'A'		// Cursor Up
 #define ANSI_FUNCTION_CUD			'B'		// Cursor Down
@@ -57,16 +106,33 @@
 #define ANSI_FUNCTION_CUP			'H'		// Cursor Position
 #define ANSI_FUNCTION_ED			'J'		// Erase in Display
 #define ANSI_FUNCTION_EL			'K'		// Erase in Line
-#define ANSI_FUNCTION_SU			'S'		// Scroll Up (page)
-#define ANSI_FUNCTION_SD			'T'		// Scroll Down (page)
+#define ANSI_FUNCTION_IL			'L'		// Insert Line
+#define ANSI_FUNCTION_DL			'M'		// Delete Line
+#define ANSI_FUNCTION_DCH			'P'		// Delete Character
+#define ANSI_FUNCTION_ECH			'X'		// Erase Character
+#define ANSI_FUNCTION_ICH			'@'		// Insert Character
+#define ANSI_FUNCTION_SU			'S'		// Scroll Up
+#define ANSI_FUNCTION_SD			'T'		// Scroll Down
 #define ANSI_FUNCTION_HVP			'f'		// Horizontal Vertical Position
 #define ANSI_FUNCTION_SGR			'm'		// Select Graphic Rendition
 #define ANSI_FUNCTION_DSR			'n'		// Device Status Report
+#define ANSI_FUNCTION_DECSTBM		'r'		// Set Top and Bottom Margins (scroll region)
 #define ANSI_FUNCTION_CLEAR			'U'		//  Clear the screen with the "normal" attribute and home the cursor
 #define ANSI_FUNCTION_SAVECURPOS	's'		// save current cursor position
 #define ANSI_FUNCTION_RESTORECURPOS	'u'		// restore cursor position from last saven
 #define ANSI_FUNCTION_PRIVHIDEMOUSE	'h'		// ?1000h is a private ANSI combo for "hide mouse pointer"
 #define ANSI_FUNCTION_PRIVSHOWMOUSE	'l'		// ?1000l is a private ANSI combo for "show mouse pointer"
+#define ANSI_FUNCTION_PRIVSETMODE	'h'		// DECSET: CSI ? n h
+#define ANSI_FUNCTION_PRIVRESETMODE	'l'		// DECRST: CSI ? n l
+
+#define ANSI_PRIVATE_MODE_DECAWM	7		// ?7h/?7l: autowrap on/off
+
+#define ANSI_ESC_FUNCTION_DECSC		'7'		// ESC 7: save cursor position
+#define ANSI_ESC_FUNCTION_DECRC		'8'		// ESC 8: restore cursor position
+#define ANSI_ESC_FUNCTION_RIS		'c'		// ESC c: reset to initial state
+#define ANSI_ESC_FUNCTION_IND		'D'		// ESC D: index (line feed)
+#define ANSI_ESC_FUNCTION_NEL		'E'		// ESC E: next line (CR + line feed)
+#define ANSI_ESC_FUNCTION_RI		'M'		// ESC M: reverse index (reverse line feed)
 
 
 
@@ -74,20 +140,31 @@
 /*                          File-scoped Variables                            */
 /*****************************************************************************/
 
-static uint8_t			ansi_sequence_storage[ANSI_MAX_SEQUENCE_LEN + 1];
-static uint8_t*			ansi_sequence = ansi_sequence_storage;
-static uint8_t			ansi_phase = 0;	// 0 = not started; 1=ESC, 2=bracket (full on), 3=done
+static uint8_t			ansi_state = ANSI_STATE_GROUND;
+static uint8_t			ansi_param[ANSI_MAX_PARAMS];	// numeric params of the sequence in progress. omitted params are 0.
+static uint8_t			ansi_param_idx;					// index of the param digits are currently going to. # of params is this + 1.
+static uint8_t			ansi_private;					// private marker (eg, '?') of the sequence in progress, or 0
+static uint8_t			ansi_intermediate;				// (last) intermediate byte of the sequence in progress, or 0
 static bool				ansi_bold_mode = false;	// need to track bold mode between SGR commands as well as within one
 
 static uint8_t			serial_x;	// text coords need to maintained separately from
 static uint8_t			serial_y;	//  global text engine because buffer update/etc will affect global ones
 static uint8_t			serial_save_x;	// in case BBS instructs save cursor pos
 static uint8_t			serial_save_y;	// in case BBS instructs save cursor pos
+static bool				serial_autowrap = true;		// DECAWM: printing past the right edge continues on the next row
+static bool				serial_wrap_pending;		// last column was just printed to: wrap before the next printable char
+static uint8_t			serial_scroll_top = TERM_BODY_Y1;		// scroll region (DECSTBM). line feeds at the bottom margin
+static uint8_t			serial_scroll_bottom = TERM_BODY_Y2;	//  scroll only these rows; the rows outside stay put.
 
 static uint8_t			serial_fg_color = TERMINAL_DEFAULT_FORE_COLOR;
 static uint8_t			serial_bg_color = TERMINAL_DEFAULT_BACK_COLOR;
+static uint8_t			serial_attr = ((TERMINAL_DEFAULT_FORE_COLOR << 4) | TERMINAL_DEFAULT_BACK_COLOR);	// VICKY attribute byte for serial_fg_color/serial_bg_color. see Serial_UpdateAttr().
 static uint8_t			serial_current_pref_color = ANSI_COLOR_BRIGHT_RED;			// user's preferred foreground color. ANSI will override.
 
+static uint8_t			serial_rx_chunk[UART_RX_CHUNK_SIZE];	// bytes copied out of the EM RX ring, waiting to be processed
+static uint8_t			serial_zrqinit_match;		// bytes of SERIAL_ZRQINIT_MATCH held back so far (0 = none). carries over from one chunk to the next.
+static bool				serial_zmodem_requested;	// a ZMODEM sender's ZRQINIT came in. see Serial_ZModemStartRequested().
+
 // F256JR/K colors, used for both fore- and background colors in Text mode
 // in C256 & F256, these are 8 bit values; in A2560s, they are 32 bit values, and endianness matters
 const static uint8_t ansi_text_color_lut[64] = 
@@ -111,13 +188,114 @@ const static uint8_t ansi_text_color_lut[64] =
 	0xFF, 0xFF, 0xFF, 0x00,
 };
 
+// byte class for each 7-bit char. 0x80-0xFF are all ANSI_CLASS_HIGH, so aren't in the table.
+static const uint8_t	ansi_byte_class[128] = 
+{
+	// 0x00-0x0F
+	ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_BEL,
+	ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0,
+	// 0x10-0x1F
+	ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0,
+	ANSI_CLASS_CANCEL, ANSI_CLASS_C0, ANSI_CLASS_CANCEL, ANSI_CLASS_ESC, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0, ANSI_CLASS_C0,
+	// 0x20-0x2F
+	ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE,
+	ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE, ANSI_CLASS_INTERMEDIATE,
+	// 0x30-0x3F
+	ANSI_CLASS_DIGIT, ANSI_CLASS_DIGIT, ANSI_CLASS_DIGIT, ANSI_CLASS_DIGIT, ANSI_CLASS_DIGIT, ANSI_CLASS_DIGIT, ANSI_CLASS_DIGIT, ANSI_CLASS_DIGIT,
+	ANSI_CLASS_DIGIT, ANSI_CLASS_DIGIT, ANSI_CLASS_COLON, ANSI_CLASS_SEMICOLON, ANSI_CLASS_PRIVATE, ANSI_CLASS_PRIVATE, ANSI_CLASS_PRIVATE, ANSI_CLASS_PRIVATE,
+	// 0x40-0x4F
+	ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL,
+	ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL,
+	// 0x50-0x5F
+	ANSI_CLASS_STRING, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL,
+	ANSI_CLASS_STRING, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_LBRACKET, ANSI_CLASS_FINAL, ANSI_CLASS_RBRACKET, ANSI_CLASS_STRING, ANSI_CLASS_STRING,
+	// 0x60-0x6F
+	ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL,
+	ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL,
+	// 0x70-0x7F
+	ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL,
+	ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_FINAL, ANSI_CLASS_DEL,
+};
+
+#define T	ANSI_TRANSITION
+#define A_NONE	ANSI_ACTION_NONE
+#define A_PRINT	ANSI_ACTION_PRINT
+#define A_CLEAR	ANSI_ACTION_CLEAR
+#define A_PARAM	ANSI_ACTION_PARAM
+#define A_NEXT	ANSI_ACTION_NEXT_PARAM
+#define A_PRIV	ANSI_ACTION_PRIVATE
+#define A_COLL	ANSI_ACTION_COLLECT
+#define A_CSI	ANSI_ACTION_CSI_DISPATCH
+#define A_ESC	ANSI_ACTION_ESC_DISPATCH
+#define S_GRND	ANSI_STATE_GROUND
+#define S_ESC	ANSI_STATE_ESCAPE
+#define S_EINT	ANSI_STATE_ESC_INTERMEDIATE
+#define S_CENT	ANSI_STATE_CSI_ENTRY
+#define S_CPAR	ANSI_STATE_CSI_PARAM
+#define S_CINT	ANSI_STATE_CSI_INTERMEDIATE
+#define S_CIGN	ANSI_STATE_CSI_IGNORE
+#define S_OSC	ANSI_STATE_OSC_STRING
+
+// [current state][byte class] -> action to take (high nibble) + next state (low nibble)
+static const uint8_t	ansi_transition[ANSI_NUM_STATES][ANSI_NUM_CLASSES] = 
+{
+	//  C0              BEL             CANCEL          ESC             INTERMEDIATE    DIGIT           COLON           SEMICOLON       PRIVATE         [               ]               FINAL           DEL             HIGH            P X ^ _
+	// ANSI_STATE_GROUND (Serial_ProcessByte handles the common case of this row without the lookup)
+	{T(A_PRINT,S_GRND),T(A_PRINT,S_GRND),T(A_PRINT,S_GRND),T(A_CLEAR,S_ESC), T(A_PRINT,S_GRND),T(A_PRINT,S_GRND),T(A_PRINT,S_GRND),T(A_PRINT,S_GRND),T(A_PRINT,S_GRND),T(A_PRINT,S_GRND),T(A_PRINT,S_GRND),T(A_PRINT,S_GRND),T(A_NONE,S_GRND), T(A_PRINT,S_GRND),T(A_PRINT,S_GRND)},
+	// ANSI_STATE_ESCAPE
+	{T(A_PRINT,S_ESC), T(A_PRINT,S_ESC), T(A_NONE,S_GRND), T(A_CLEAR,S_ESC), T(A_COLL,S_EINT), T(A_ESC,S_GRND),  T(A_ESC,S_GRND),  T(A_ESC,S_GRND),  T(A_ESC,S_GRND),  T(A_NONE,S_CENT), T(A_NONE,S_OSC),  T(A_ESC,S_GRND),  T(A_NONE,S_ESC),  T(A_NONE,S_GRND), T(A_NONE,S_OSC)},
+	// ANSI_STATE_ESC_INTERMEDIATE
+	{T(A_PRINT,S_EINT),T(A_PRINT,S_EINT),T(A_NONE,S_GRND), T(A_CLEAR,S_ESC), T(A_COLL,S_EINT), T(A_ESC,S_GRND),  T(A_ESC,S_GRND),  T(A_ESC,S_GRND),  T(A_ESC,S_GRND),  T(A_ESC,S_GRND),  T(A_ESC,S_GRND),  T(A_ESC,S_GRND),  T(A_NONE,S_EINT), T(A_NONE,S_GRND), T(A_ESC,S_GRND)},
+	// ANSI_STATE_CSI_ENTRY
+	{T(A_PRINT,S_CENT),T(A_PRINT,S_CENT),T(A_NONE,S_GRND), T(A_CLEAR,S_ESC), T(A_COLL,S_CINT), T(A_PARAM,S_CPAR),T(A_NONE,S_CIGN), T(A_NEXT,S_CPAR), T(A_PRIV,S_CPAR), T(A_CSI,S_GRND),  T(A_CSI,S_GRND),  T(A_CSI,S_GRND),  T(A_NONE,S_CENT), T(A_NONE,S_CIGN), T(A_CSI,S_GRND)},
+	// ANSI_STATE_CSI_PARAM
+	{T(A_PRINT,S_CPAR),T(A_PRINT,S_CPAR),T(A_NONE,S_GRND), T(A_CLEAR,S_ESC), T(A_COLL,S_CINT), T(A_PARAM,S_CPAR),T(A_NONE,S_CIGN), T(A_NEXT,S_CPAR), T(A_NONE,S_CIGN), T(A_CSI,S_GRND),  T(A_CSI,S_GRND),  T(A_CSI,S_GRND),  T(A_NONE,S_CPAR), T(A_NONE,S_CIGN), T(A_CSI,S_GRND)},
+	// ANSI_STATE_CSI_INTERMEDIATE
+	{T(A_PRINT,S_CINT),T(A_PRINT,S_CINT),T(A_NONE,S_GRND), T(A_CLEAR,S_ESC), T(A_COLL,S_CINT), T(A_NONE,S_CIGN), T(A_NONE,S_CIGN), T(A_NONE,S_CIGN), T(A_NONE,S_CIGN), T(A_CSI,S_GRND),  T(A_CSI,S_GRND),  T(A_CSI,S_GRND),  T(A_NONE,S_CINT), T(A_NONE,S_CIGN), T(A_CSI,S_GRND)},
+	// ANSI_STATE_CSI_IGNORE
+	{T(A_PRINT,S_CIGN),T(A_PRINT,S_CIGN),T(A_NONE,S_GRND), T(A_CLEAR,S_ESC), T(A_NONE,S_CIGN), T(A_NONE,S_CIGN), T(A_NONE,S_CIGN), T(A_NONE,S_CIGN), T(A_NONE,S_CIGN), T(A_NONE,S_GRND), T(A_NONE,S_GRND), T(A_NONE,S_GRND), T(A_NONE,S_CIGN), T(A_NONE,S_CIGN), T(A_NONE,S_GRND)},
+	// ANSI_STATE_OSC_STRING (window titles, DCS device strings, APC/PM/SOS payloads: we have no use for any of them)
+	{T(A_NONE,S_OSC),  T(A_NONE,S_GRND), T(A_NONE,S_GRND), T(A_CLEAR,S_ESC), T(A_NONE,S_OSC),  T(A_NONE,S_OSC),  T(A_NONE,S_OSC),  T(A_NONE,S_OSC),  T(A_NONE,S_OSC),  T(A_NONE,S_OSC),  T(A_NONE,S_OSC),  T(A_NONE,S_OSC),  T(A_NONE,S_OSC),  T(A_NONE,S_OSC),  T(A_NONE,S_OSC)},
+};
+
+#undef T
+#undef A_NONE
+#undef A_PRINT
+#undef A_CLEAR
+#undef A_PARAM
+#undef A_NEXT
+#undef A_PRIV
+#undef A_COLL
+#undef A_CSI
+#undef A_ESC
+#undef S_GRND
+#undef S_ESC
+#undef S_EINT
+#undef S_CENT
+#undef S_CPAR
+#undef S_CINT
+#undef S_CIGN
+#undef S_OSC
+
 /*****************************************************************************/
 /*                             Global Variables                              */
 /*****************************************************************************/
 
-uint8_t*				global_uart_in_buffer = (uint8_t*)UART_BUFFER_START_ADDR;
-uint16_t				global_uart_write_idx;
-uint16_t				global_uart_read_idx;
+uint16_t				global_uart_write_idx;	// ring position the IRQ handler will write the next byte to. only the IRQ handler changes it.
+uint16_t				global_uart_read_idx;	// ring position of the next byte to be processed. IRQ handler only reads it.
+uint8_t					global_uart_line_status;		// UART_ERROR_MASK bits from LSR, latched by the IRQ handler until Serial_ReadUART reports them
+uint8_t					global_uart_flow_control = UART_FLOW_CONTROL_NONE;
+bool					global_uart_rx_throttled;		// set by the IRQ handler when the ring hits high water, cleared by Serial_RingRead at low water
+bool					global_uart_tx_paused;			// XON/XOFF mode: set/cleared by the IRQ handler when the other side sends XOFF/XON
+uint8_t					global_uart_tx_control_byte;	// XON or XOFF waiting for the transmitter, or 0 if none
+uint8_t					global_uart_fifo_burst;			// bytes guaranteed to be in the RX FIFO when the UART reports its trigger level
+uint8_t					global_uart_tx_buffer[UART_TX_QUEUE_SIZE];	// transmit queue. bytes go out from the UART IRQ handler.
+uint8_t					global_uart_tx_head;			// queue position the next byte will be added at. only mainline code changes it.
+uint8_t					global_uart_tx_tail;			// queue position of the next byte to send. only the IRQ handler changes it.
+
+static const uint8_t	serial_fifo_trigger_bytes[4] = {1, 4, 8, 14};	// indexed by UART_FCR_TRIGGER_x >> 6
+
+static uint8_t			serial_suspended_flow_control = UART_FLOW_CONTROL_NONE;	// mode to go back to after a binary transfer
 
 extern char*			global_string_buff1;
 extern char*			global_string_buff2;
@@ -147,8 +325,45 @@ void Serial_ProcessByte(uint8_t the_byte);
 // print a byte to screen, from the serial port
 void Serial_PrintByte(uint8_t the_byte);
 
-// process the ANSI sequence stored in ansi_sequence_storage
-void Serial_ProcessANSI(void);
+// print a run of printable (non-control) bytes to screen at the current serial position, from the serial port
+// same result as calling Serial_PrintByte() for each, but with one screen write and one cursor update for the whole run
+void Serial_PrintRun(uint8_t* the_run, uint16_t the_len);
+
+// carry out the CSI sequence whose params have been collected in ansi_param[]
+// the_function is the final byte of the sequence (eg, 'H' for CUP)
+void Serial_ProcessANSI(uint8_t the_function);
+
+// carry out a (non-CSI) ESC sequence. the_function is the final byte of the sequence (eg, '7' for ESC 7)
+void Serial_ProcessEscape(uint8_t the_function);
+
+// tell the other side it can resume sending, and clear the throttled state
+void Serial_ReleaseReceiveThrottle(void);
+
+// turn on the UART's transmit-holding-register-empty interrupt, so the IRQ handler starts feeding it from the queue
+void Serial_StartTransmit(void);
+
+// wait for room for at least 1 byte in the transmit queue
+// returns false if none opens up within UART_SEND_TIMEOUT_TICKS (the line has been stopped, not just slow)
+bool Serial_WaitForQueueSpace(void);
+
+// rebuild serial_attr after serial_fg_color or serial_bg_color has changed
+void Serial_UpdateAttr(void);
+
+// scroll rows y1-y2 up the_count rows, blanking the rows opened up at the bottom. the cursor does not move.
+// if to_history is true, the rows scrolled off the top are added to the scrollback history
+void Serial_ScrollRowsUp(uint8_t y1, uint8_t y2, uint8_t the_count, bool to_history);
+
+// scroll rows y1-y2 down the_count rows, blanking the rows opened up at the top. the cursor does not move.
+void Serial_ScrollRowsDown(uint8_t y1, uint8_t y2, uint8_t the_count);
+
+// scroll the scroll region up the_count rows. the cursor does not move.
+void Serial_ScrollRegionUp(uint8_t the_count);
+
+// move the cursor down one row. at the bottom margin of the scroll region, scroll the region up instead.
+void Serial_Index(void);
+
+// move the cursor up one row. at the top margin of the scroll region, scroll the region down instead.
+void Serial_ReverseIndex(void);
 
 // Moves the cursor n (default 1) cells in the given direction.
 // If the cursor is already at the edge of the screen, this has no effect.
@@ -169,8 +384,33 @@ void Serial_ANSICursorRight(uint8_t the_count);
 // Moves cursor to beginning of the line n (default 1) lines down.
 void Serial_ANSICursorNextLine(uint8_t the_count);
 
-// scrolls down one line or an entire page
-void Serial_ANSIScrollDown(bool scroll_page);
+// ANSI SD: scrolls the scroll region down n (default 1) lines. the cursor does not move.
+void Serial_ANSIScrollDown(uint8_t the_count);
+
+// ANSI SU: scrolls the scroll region up n (default 1) lines. the cursor does not move.
+void Serial_ANSIScrollUp(uint8_t the_count);
+
+// ANSI DECSTBM: CSI t ; b r
+// Sets the scroll region to rows t-b (1-based, default whole terminal body), and homes the cursor
+// ignored if the region would be less than 2 rows, or doesn't fit the terminal body
+void Serial_ANSISetScrollRegion(uint8_t the_top, uint8_t the_bottom);
+
+// ANSI IL: inserts n (default 1) blank lines at the cursor row, pushing the rows below it down to the bottom margin
+// no effect if the cursor is outside the scroll region. the cursor moves to the first column.
+void Serial_ANSIInsertLines(uint8_t the_count);
+
+// ANSI DL: deletes n (default 1) lines from the cursor row down, pulling the rows below up and blanking at the bottom margin
+// no effect if the cursor is outside the scroll region. the cursor moves to the first column.
+void Serial_ANSIDeleteLines(uint8_t the_count);
+
+// ANSI ICH: inserts n (default 1) blank cells at the cursor, pushing the rest of the row right. the cursor does not move.
+void Serial_ANSIInsertChars(uint8_t the_count);
+
+// ANSI DCH: deletes n (default 1) cells at the cursor, pulling the rest of the row left. the cursor does not move.
+void Serial_ANSIDeleteChars(uint8_t the_count);
+
+// ANSI ECH: blanks n (default 1) cells from the cursor on, without moving anything. the cursor does not move.
+void Serial_ANSIEraseChars(uint8_t the_count);
 
 // Moves cursor to beginning of the line n (default 1) lines up.
 void Serial_ANSICursorPreviousLine(uint8_t the_count);
@@ -184,13 +424,13 @@ void Serial_ANSICursorSetXPos(uint8_t the_count);
 // The values are 1-based, and default to 1 (top left corner) if omitted. 
 // A sequence such as CSI ;5H is a synonym for CSI 1;5H
 //   CSI 17;H is the same as CSI 17H and CSI 17;1H
-void Serial_ANSICursorSetXYPos();
+void Serial_ANSICursorSetXYPos(uint8_t the_row, uint8_t the_col);
 
 // ANSI HVP: CSI n ; m f
 // Moves the cursor to row n, column m. 
 // Same as CUP, but counts as a format effector function (like CR or LF) rather than an editor function (like CUD or CNL). 
 // The values are 1-based, and default to 1 (top left corner) if omitted. 
-void Serial_ANSICursorMoveToXY();
+void Serial_ANSICursorMoveToXY(uint8_t the_row, uint8_t the_col);
 
 // ANSI clear
 // clears the screen setting attributs to normal. homes the cursor
@@ -219,9 +459,12 @@ void Serial_ANSIEraseInLine(uint8_t the_count);
 void Serial_ANSISendDSR(uint8_t the_count);
 
 // ANSI function handler for SGR: Select Graphic Rendition
-// ANSI sequence to process is already in ansi_sequence (ESC [ is not included)
-// the_len contains the length of the sequence, not including the final command character. 
-void Serial_ANSIHandleSGR(uint8_t the_len);
+// the params of the sequence are in ansi_param[0..ansi_param_idx]
+void Serial_ANSIHandleSGR(void);
+
+// DECSET/DECRST: CSI ? n ; ... h (set) or l (reset). the modes are in ansi_param[0..ansi_param_idx]
+// only DECAWM (7, autowrap) is acted on; the rest (eg, 1000, mouse) are ignored
+void Serial_ANSISetPrivateModes(bool set_mode);
 	
 
 /*****************************************************************************/
@@ -261,13 +504,190 @@ void Serial_ClearDLAB(void)
 	R8(UART_LCR) = R8(UART_LCR) & (~UART_DLAB_MASK);
 	Sys_RestoreIOPage();
 }
+
+
+// tell the other side it can resume sending, and clear the throttled state
+void Serial_ReleaseReceiveThrottle(void)
+{
+	Sys_SwapIOPage(VICKY_IO_PAGE_REGISTERS);
+	asm("SEI");
+	R8(UART_MCR) = R8(UART_MCR) | FLAG_UART_MCR_RTS;
+	
+	if (global_uart_rx_throttled == true && global_uart_flow_control == UART_FLOW_CONTROL_XON_XOFF)
+	{
+		global_uart_tx_control_byte = CH_XON;
+	}
+	
+	global_uart_rx_throttled = false;
+	asm("CLI");
+	Sys_RestoreIOPage();
+	
+	Serial_StartTransmit();
+}
+
+
+// rebuild serial_attr after serial_fg_color or serial_bg_color has changed
+void Serial_UpdateAttr(void)
+{
+	// LOGIC:
+	//   the colors only change on SGR, clear, and color cycling, but chars get drawn and lines get erased constantly.
+	//   so build the attribute byte here, once per change, and hand it straight to the text routines everywhere else.
+	//   text mode only supports 16 colors. lower 4 bits are back, upper 4 bits are foreground
+	
+	serial_attr = ((serial_fg_color << 4) | serial_bg_color);
+}
+
+
+// turn on the UART's transmit-holding-register-empty interrupt, so the IRQ handler starts feeding it from the queue
+void Serial_StartTransmit(void)
+{
+	// LOGIC:
+	//   if THR is already empty, the UART raises the IRQ as soon as the interrupt is enabled, so this is all it takes.
+	//   the handler turns it back off when the queue runs dry or flow control says to wait.
+	
+	Sys_SwapIOPage(VICKY_IO_PAGE_REGISTERS);
+	asm("SEI");
+	R8(UART_IER) = R8(UART_IER) | FLAG_UART_IER_TXA;
+	asm("CLI");
+	Sys_RestoreIOPage();
+}
+
+
+// wait for room for at least 1 byte in the transmit queue
+// returns false if none opens up within UART_SEND_TIMEOUT_TICKS (the line has been stopped, not just slow)
+bool Serial_WaitForQueueSpace(void)
+{
+	uint8_t		last_second = Sys_GetRTCSeconds();
+	uint8_t		this_second;
+	uint8_t		ticks_left = UART_SEND_TIMEOUT_TICKS;
+
+	// LOGIC:
+	//   a full queue gets 1 byte of room each time the UART takes the next char: one character time, which is
+	//   33 ms at 300 baud (87 us at 115200). a count of tries ran out sooner than that at low baud rates, so an
+	//   XMODEM ACK/NAK/CAN queued behind a full queue could be dropped. the wait is timed by the RTC instead:
+	//   2 changes of the seconds register is 1-2 s, 30+ character times even at 300 baud.
+	//   if the queue hasn't moved in that long, the other side has stopped us (flow control) or the line is down.
+
+	while (Serial_QueueSpace() == 0)
+	{
+		this_second = Sys_GetRTCSeconds();
+
+		if (this_second != last_second)
+		{
+			last_second = this_second;
+
+			if (--ticks_left == 0)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+// scroll rows y1-y2 up the_count rows, blanking the rows opened up at the bottom. the cursor does not move.
+// if to_history is true, the rows scrolled off the top are added to the scrollback history
+void Serial_ScrollRowsUp(uint8_t y1, uint8_t y2, uint8_t the_count, bool to_history)
+{
+	// LOGIC:
+	//   only the rows passed move, so a BBS's fixed header/status rows outside the scroll region don't have to be resent.
+	//   each step is a row-pointer rotation in the shadow bank, so scrolling n rows is n cheap steps, not n block moves.
+	
+	if (the_count > y2 - y1 + 1)
+	{
+		the_count = y2 - y1 + 1;
+	}
+	
+	while (the_count > 0)
+	{
+		if (y1 < y2)
+		{
+			Shadow_ScrollUp(y1 + 1, y2, to_history);
+		}
+		
+		Shadow_FillBox(TERM_BODY_X1, y2, TERM_BODY_X2, y2, CH_SPACE, serial_attr);
+		--the_count;
+	}
+}
+
+
+// scroll rows y1-y2 down the_count rows, blanking the rows opened up at the top. the cursor does not move.
+void Serial_ScrollRowsDown(uint8_t y1, uint8_t y2, uint8_t the_count)
+{
+	if (the_count > y2 - y1 + 1)
+	{
+		the_count = y2 - y1 + 1;
+	}
+	
+	while (the_count > 0)
+	{
+		if (y1 < y2)
+		{
+			Shadow_ScrollDown(y1, y2 - 1);
+		}
+		
+		Shadow_FillBox(TERM_BODY_X1, y1, TERM_BODY_X2, y1, CH_SPACE, serial_attr);
+		--the_count;
+	}
+}
+
+
+// scroll the scroll region up the_count rows. the cursor does not move.
+void Serial_ScrollRegionUp(uint8_t the_count)
+{
+	// LOGIC:
+	//   rows only go to the scrollback history when the region starts at the top of the terminal body.
+	//   lines scrolled out of a region further down (eg, under a fixed header) are not kept, same as xterm.
+	
+	Serial_ScrollRowsUp(serial_scroll_top, serial_scroll_bottom, the_count, serial_scroll_top == TERM_BODY_Y1);
+}
+
+
+// move the cursor down one row. at the bottom margin of the scroll region, scroll the region up instead.
+void Serial_Index(void)
+{
+	// LOGIC:
+	//   below the region (eg, on a status line under it), the cursor just moves down, stopping at the bottom of the body
 	
+	if (serial_y == serial_scroll_bottom)
+	{
+		Serial_ScrollRegionUp(1);
+	}
+	else if (serial_y < TERM_BODY_Y2)
+	{
+		++serial_y;
+	}
+}
+
+
+// move the cursor up one row. at the top margin of the scroll region, scroll the region down instead.
+void Serial_ReverseIndex(void)
+{
+	if (serial_y == serial_scroll_top)
+	{
+		Serial_ScrollRowsDown(serial_scroll_top, serial_scroll_bottom, 1);
+	}
+	else if (serial_y > TERM_BODY_Y1)
+	{
+		--serial_y;
+	}
+}
+
 
 // Moves the cursor n (default 1) cells in the given direction.
 // If the cursor is already at the edge of the screen, this has no effect.
 void Serial_ANSICursorUp(uint8_t the_count)
 {
-	while (serial_y > TERM_BODY_Y1 && the_count > 0)
+	uint8_t		the_limit;
+	
+	// LOGIC:
+	//   from inside the scroll region, the cursor stops at the top margin. from above it, at the top of the body.
+	
+	the_limit = (serial_y >= serial_scroll_top) ? serial_scroll_top : TERM_BODY_Y1;
+	
+	while (serial_y > the_limit && the_count > 0)
 	{
 		serial_y--;
 		the_count--;
@@ -281,7 +701,14 @@ void Serial_ANSICursorUp(uint8_t the_count)
 // If the cursor is already at the edge of the screen, this has no effect.
 void Serial_ANSICursorDown(uint8_t the_count)
 {
-	while (serial_y < TERM_BODY_Y2 && the_count > 0)
+	uint8_t		the_limit;
+	
+	// LOGIC:
+	//   from inside the scroll region, the cursor stops at the bottom margin. from below it, at the bottom of the body.
+	
+	the_limit = (serial_y <= serial_scroll_bottom) ? serial_scroll_bottom : TERM_BODY_Y2;
+	
+	while (serial_y < the_limit && the_count > 0)
 	{
 		serial_y++;
 		the_count--;
@@ -322,89 +749,116 @@ void Serial_ANSICursorRight(uint8_t the_count)
 // Moves cursor to beginning of the line n (default 1) lines down.
 void Serial_ANSICursorNextLine(uint8_t the_count)
 {
-	serial_x = TERM_BODY_X1;
+	// LOGIC:
+	//   CNL is CUD + carriage return: it stops at the bottom margin rather than scrolling
 	
-	while (serial_y < TERM_BODY_Y2 && the_count > 0)
-	{
-		Text_ScrollTextAndAttrRowsUp(TERM_BODY_Y1+1, TERM_BODY_Y2);
-		Text_FillBox(TERM_BODY_X1, TERM_BODY_Y2, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
-		serial_y++;
-		the_count--;
-	}
+	serial_x = TERM_BODY_X1;
+	Serial_ANSICursorDown(the_count);
+}
 
-	Text_SetXY(serial_x, serial_y);
+
+// ANSI SD: scrolls the scroll region down n (default 1) lines. the cursor does not move.
+void Serial_ANSIScrollDown(uint8_t the_count)
+{
+	Serial_ScrollRowsDown(serial_scroll_top, serial_scroll_bottom, the_count);
 }
 
 
-// scrolls down one line or an entire page
-void Serial_ANSIScrollDown(bool scroll_page)
+// Moves cursor to beginning of the line n (default 1) lines up.
+void Serial_ANSICursorPreviousLine(uint8_t the_count)
 {
-	uint8_t		the_count;
-	
 	serial_x = TERM_BODY_X1;
+	Serial_ANSICursorUp(the_count);
+}
+
+
+// ANSI SU: scrolls the scroll region up n (default 1) lines. the cursor does not move.
+void Serial_ANSIScrollUp(uint8_t the_count)
+{
+	Serial_ScrollRegionUp(the_count);
+}
+
+
+// ANSI DECSTBM: CSI t ; b r
+// Sets the scroll region to rows t-b (1-based, default whole terminal body), and homes the cursor
+// ignored if the region would be less than 2 rows, or doesn't fit the terminal body
+void Serial_ANSISetScrollRegion(uint8_t the_top, uint8_t the_bottom)
+{
+	// if value was left out, the parser will have left it at 0: top defaults to first row, bottom to last
+	if (the_top == 0) the_top = 1;
+	if (the_bottom == 0 || the_bottom > TERM_BODY_HEIGHT) the_bottom = TERM_BODY_HEIGHT;
 	
-	if (scroll_page == true)
-	{
-		the_count = TERM_BODY_HEIGHT;
-	}
-	else
+	if (the_top >= the_bottom)
 	{
-		the_count = 1;
+		return;
 	}
 	
-	while (serial_y > TERM_BODY_Y1 && the_count > 0)
-	{
-		serial_y--;
-		the_count--;
-	}
-
+	serial_scroll_top = TERM_BODY_Y1 + the_top - 1;
+	serial_scroll_bottom = TERM_BODY_Y1 + the_bottom - 1;
+	
+	serial_x = TERM_BODY_X1;
+	serial_y = TERM_BODY_Y1;
+	
 	Text_SetXY(serial_x, serial_y);
 }
 
 
-// Moves cursor to beginning of the line n (default 1) lines up.
-void Serial_ANSICursorPreviousLine(uint8_t the_count)
+// ANSI IL: inserts n (default 1) blank lines at the cursor row, pushing the rows below it down to the bottom margin
+// no effect if the cursor is outside the scroll region. the cursor moves to the first column.
+void Serial_ANSIInsertLines(uint8_t the_count)
 {
-	serial_x = 0;
-	
-	while (serial_y > TERM_BODY_Y1 && the_count > 0)
+	if (serial_y < serial_scroll_top || serial_y > serial_scroll_bottom)
 	{
-		serial_y--;
-		the_count--;
+		return;
 	}
-
+	
+	Serial_ScrollRowsDown(serial_y, serial_scroll_bottom, the_count);
+	serial_x = TERM_BODY_X1;
 	Text_SetXY(serial_x, serial_y);
 }
 
 
-// scrolls up one line or an entire page
-void Serial_ANSIScrollUp(bool scroll_page)
+// ANSI DL: deletes n (default 1) lines from the cursor row down, pulling the rows below up and blanking at the bottom margin
+// no effect if the cursor is outside the scroll region. the cursor moves to the first column.
+void Serial_ANSIDeleteLines(uint8_t the_count)
 {
-	uint8_t		the_count;
-	
-	serial_x = TERM_BODY_X1;
-	
-	if (scroll_page == true)
-	{
-		the_count = TERM_BODY_HEIGHT;
-	}
-	else
+	if (serial_y < serial_scroll_top || serial_y > serial_scroll_bottom)
 	{
-		the_count = 1;
+		return;
 	}
 	
-	while (serial_y < TERM_BODY_Y2 && the_count > 0)
-	{
-		Text_ScrollTextAndAttrRowsUp(TERM_BODY_Y1+1, TERM_BODY_Y2);
-		Text_FillBox(TERM_BODY_X1, TERM_BODY_Y2, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
-		serial_y++;
-		the_count--;
-	}
-
+	// deleted lines are gone, not scrolled off: they don't go to the history
+	Serial_ScrollRowsUp(serial_y, serial_scroll_bottom, the_count, false);
+	serial_x = TERM_BODY_X1;
 	Text_SetXY(serial_x, serial_y);
 }
 
 
+// ANSI ICH: inserts n (default 1) blank cells at the cursor, pushing the rest of the row right. the cursor does not move.
+void Serial_ANSIInsertChars(uint8_t the_count)
+{
+	Shadow_InsertCells(serial_x, serial_y, the_count, serial_attr);
+}
+
+
+// ANSI DCH: deletes n (default 1) cells at the cursor, pulling the rest of the row left. the cursor does not move.
+void Serial_ANSIDeleteChars(uint8_t the_count)
+{
+	Shadow_DeleteCells(serial_x, serial_y, the_count, serial_attr);
+}
+
+
+// ANSI ECH: blanks n (default 1) cells from the cursor on, without moving anything. the cursor does not move.
+void Serial_ANSIEraseChars(uint8_t the_count)
+{
+	uint8_t		the_last_col;
+	
+	the_last_col = (the_count > TERM_BODY_X2 - serial_x) ? TERM_BODY_X2 : serial_x + the_count - 1;
+	
+	Shadow_FillBox(serial_x, serial_y, the_last_col, serial_y, CH_SPACE, serial_attr);
+}
+
+
 // ANSI CHA
 // Moves the cursor to column n (default 1)
 void Serial_ANSICursorSetXPos(uint8_t the_count)
@@ -437,66 +891,31 @@ void Serial_ANSICursorSetXPos(uint8_t the_count)
 // The values are 1-based, and default to 1 (top left corner) if omitted. 
 // A sequence such as CSI ;5H is a synonym for CSI 1;5H
 //   CSI 17;H is the same as CSI 17H and CSI 17;1H
-void Serial_ANSICursorSetXYPos()
+void Serial_ANSICursorSetXYPos(uint8_t the_row, uint8_t the_col)
 {
-	uint8_t		the_x;
-	uint8_t		the_y;
-	char*		this_token;
-	char*		splitter;
-	
-	// LOGIC:
-	//   
-
-// sprintf(global_string_buff2, "%s", ansi_sequence);
-
-	// check that a column value was provided. if left out, it defeaults to 1 (y=0)
-	splitter = strchr((char*)ansi_sequence, ';');
-	
-	if (splitter == NULL)
-	{
-		// row was left out. set to 1 as that's the default value.
-		the_y = 1;
-		//the_x = atoi((char*)ansi_sequence) + 1;
-		this_token = strtok((char*)ansi_sequence, (const char*)"H");
-		the_x = atoi(this_token);
-	}
-	else
-	{		
-		// tokenize to get first and second values
-		this_token = strtok((char*)ansi_sequence, (const char*)";");
-
-		the_y = atoi(this_token);
-		this_token = strtok(NULL, (const char*)";");
-		the_x = atoi(this_token);
-		//the_x = atoi((char*)ansi_sequence);
-	}
-	
-	// if value was left out, atoi will have returned 0, but default is 1.
-	if (the_x == 0)	the_x = 1;
-	if (the_y == 0) the_y = 1;
+	// if value was left out, the parser will have left it at 0, but default is 1.
+	if (the_col == 0) the_col = 1;
+	if (the_row == 0) the_row = 1;
 	
-// sprintf(global_string_buff1, "CUP x,y=%d,%d ('%s')", the_x, the_y, global_string_buff2);
-// Buffer_NewMessage((global_string_buff1));
-
 	// account for 0-based vs 1-based
-	the_y--;
-	the_x--;
+	the_row--;
+	the_col--;
 	
 	// account for fact our screen doesn't start at 0
-	the_y += TERM_BODY_Y1;
+	the_row += TERM_BODY_Y1;
 	
-	if (the_y < TERM_BODY_Y2)
+	if (the_row < TERM_BODY_Y2)
 	{
-		serial_y = the_y;
+		serial_y = the_row;
 	}
 	else
 	{
 		serial_y = TERM_BODY_Y2;
 	}
 	
-	if (the_x < TERM_BODY_X2)
+	if (the_col < TERM_BODY_X2)
 	{
-		serial_x = the_x;
+		serial_x = the_col;
 	}
 	else
 	{
@@ -511,73 +930,38 @@ void Serial_ANSICursorSetXYPos()
 // Moves the cursor to row n, column m. 
 // Same as CUP, but counts as a format effector function (like CR or LF) rather than an editor function (like CUD or CNL). 
 // The values are 1-based, and default to 1 (top left corner) if omitted. 
-void Serial_ANSICursorMoveToXY()
+void Serial_ANSICursorMoveToXY(uint8_t the_row, uint8_t the_col)
 {
-	uint8_t		the_x;
-	uint8_t		the_y;
-	char*		this_token;
-	char*		splitter;
-	
-	// LOGIC:
-	//   
-// sprintf(global_string_buff2, "%s", ansi_sequence);
-
-	// check that a column value was provided. if left out, it defeaults to 1 (y=0)
-	splitter = strchr((char*)ansi_sequence, ';');
-	
-	if (splitter == NULL)
-	{
-		// row was left out. set to 1 as that's the default value.
-		the_y = 1;
-		//the_x = atoi((char*)ansi_sequence) + 1;
-		this_token = strtok((char*)ansi_sequence, (const char*)"f");
-		the_x = atoi(this_token);
-	}
-	else
-	{		
-		// tokenize to get first and second values
-		this_token = strtok((char*)ansi_sequence, (const char*)";");
-
-		the_y = atoi(this_token);
-		this_token = strtok(NULL, (const char*)";");
-		the_x = atoi(this_token);
-		//the_x = atoi((char*)ansi_sequence);
-	}
-	
-	// if value was left out, atoi will have returned 0, but default is 1.
-	if (the_x == 0)	the_x = 1;
-	if (the_y == 0) the_y = 1;
+	// if value was left out, the parser will have left it at 0, but default is 1.
+	if (the_col == 0) the_col = 1;
+	if (the_row == 0) the_row = 1;
 	
-// sprintf(global_string_buff1, "HVP x,y=%d,%d ('%s')", the_x, the_y, global_string_buff2);
-// Buffer_NewMessage((global_string_buff1));
-
 	// account for 0-based vs 1-based
-	the_y--;
-	the_x--;
+	the_row--;
+	the_col--;
 	
 	// account for fact our screen doesn't start at 0
-	the_y += TERM_BODY_Y1;
+	the_row += TERM_BODY_Y1;
 	
-	if (the_y <= TERM_BODY_Y2)
+	if (the_row <= TERM_BODY_Y2)
 	{
-		serial_y = the_y;
+		serial_y = the_row;
 	}
 	else
 	{
-		the_y -= serial_y;
+		the_row -= serial_y;
 		
-		while (serial_y < TERM_BODY_Y2 && the_y > TERM_BODY_Y1)
+		while (serial_y < TERM_BODY_Y2 && the_row > TERM_BODY_Y1)
 		{
-			Text_ScrollTextAndAttrRowsUp(TERM_BODY_Y1+1, TERM_BODY_Y2);
-			Text_FillBox(TERM_BODY_X1, TERM_BODY_Y2, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
+			Serial_ScrollRegionUp(1);
 			serial_y++;
-			the_y--;
+			the_row--;
 		}
 	}
 	
-	if (the_x <= TERM_BODY_X2)
+	if (the_col <= TERM_BODY_X2)
 	{
-		serial_x = the_x;
+		serial_x = the_col;
 	}
 	else
 	{
@@ -594,8 +978,9 @@ void Serial_ANSIClear(void)
 {
 	serial_fg_color = TERMINAL_DEFAULT_FORE_COLOR;
 	serial_bg_color = TERMINAL_DEFAULT_BACK_COLOR;
+	Serial_UpdateAttr();
 	
-	Text_FillBox(TERM_BODY_X1, TERM_BODY_Y1, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
+	Shadow_FillBox(TERM_BODY_X1, TERM_BODY_Y1, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_attr);
 
 	serial_x = TERM_BODY_X1;
 	serial_y = TERM_BODY_Y1;
@@ -616,20 +1001,20 @@ void Serial_ANSIEraseInDisplay(uint8_t the_count)
 	{
 		case 0:
 			// clear from cursor to end of screen
-			Text_FillBox(TERM_BODY_X1, serial_y, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
+			Shadow_FillBox(TERM_BODY_X1, serial_y, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_attr);
 			serial_x = TERM_BODY_X1;
 			break;
 		
 		case 1:
 			// clear from cursor to beginning of the screen. 
-			Text_FillBox(TERM_BODY_X1, TERM_BODY_Y1, TERM_BODY_X2, serial_y, CH_SPACE, serial_fg_color, serial_bg_color);
+			Shadow_FillBox(TERM_BODY_X1, TERM_BODY_Y1, TERM_BODY_X2, serial_y, CH_SPACE, serial_attr);
 			serial_x = TERM_BODY_X1;
 			break;
 			
 		case 2:
 		case 3:
 			// clear entire screen
-			Text_FillBox(TERM_BODY_X1, TERM_BODY_Y1, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
+			Shadow_FillBox(TERM_BODY_X1, TERM_BODY_Y1, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_attr);
 			serial_x = TERM_BODY_X1;
 			serial_y = TERM_BODY_Y1;
 			break;
@@ -654,17 +1039,17 @@ void Serial_ANSIEraseInLine(uint8_t the_count)
 	{
 		case 0:
 			// clear from cursor to the end of the line
-			Text_FillBox(serial_x + 1, serial_y, TERM_BODY_X2, serial_y, CH_SPACE, serial_fg_color, serial_bg_color);
+			Shadow_FillBox(serial_x + 1, serial_y, TERM_BODY_X2, serial_y, CH_SPACE, serial_attr);
 			break;
 		
 		case 1:
 			// clear from cursor to beginning of the screen. 
-			Text_FillBox(TERM_BODY_X1, serial_y, serial_x - 1, serial_y, CH_SPACE, serial_fg_color, serial_bg_color);
+			Shadow_FillBox(TERM_BODY_X1, serial_y, serial_x - 1, serial_y, CH_SPACE, serial_attr);
 			break;
 			
 		case 2:
 			// clear entire line
-			Text_FillBox(TERM_BODY_X1, serial_y, TERM_BODY_X2, serial_y, CH_SPACE, serial_fg_color, serial_bg_color);
+			Shadow_FillBox(TERM_BODY_X1, serial_y, TERM_BODY_X2, serial_y, CH_SPACE, serial_attr);
 			break;
 			
 		default:
@@ -694,6 +1079,8 @@ void Serial_ANSISendDSR(uint8_t the_count)
 	}
 	
 	the_len = strlen(global_string_buff1);
+	
+	// LOGIC: a report cut short would throw off the host's parsing of it, so wait for room rather than queue what fits
 	Serial_SendData((uint8_t*)global_string_buff1, the_len);
 // 	if ( (result = Serial_SendData((uint8_t*)global_string_buff1, the_len)) != the_len )
 // 	{
@@ -709,14 +1096,12 @@ void Serial_ANSISendDSR(uint8_t the_count)
 
 
 // ANSI function handler for SGR: Select Graphic Rendition
-// ANSI sequence to process is already in ansi_sequence (ESC [ is not included)
-// the_len contains the length of the sequence, not including the final command character. 
-void Serial_ANSIHandleSGR(uint8_t the_len)
+// the params of the sequence are in ansi_param[0..ansi_param_idx]
+void Serial_ANSIHandleSGR(void)
 {
 	uint8_t			temp;
-	int16_t			this_color_code;
-	char*			this_token;
-	char*			splitter;
+	uint8_t			i;
+	uint8_t			this_color_code;
 	
 	// LOGIC:
 	//   Wikipedia: The control sequence CSI n m, named Select Graphic Rendition (SGR), sets display attributes. Several attributes can be set in the same sequence, separated by semicolons.[21] Each display attribute remains in effect until a following occurrence of SGR resets it.[5] If no codes are given, CSI m is treated as CSI 0 m (reset / normal).
@@ -725,29 +1110,14 @@ void Serial_ANSIHandleSGR(uint8_t the_len)
 	//   background color codes are 40-47, or 100-107
 	//   colors can be made bold with a '1;' sequence before. 
 	//   a lot of this encoding won't be supportable on an F256 using text mode (underline, framed, etc.)
-// sprintf(global_string_buff2, "('%s'), start bold mode=%x", ansi_sequence, ansi_bold_mode);
+	//   the parser leaves an omitted param at 0, so CSI m comes through as a single 0, which is exactly the reset we want
 	
-	// work through the command from left to right, allowing for multiple params
-	// check we're not dealing with a singleton value
-	splitter = strchr((char*)ansi_sequence, ';');
-	
-	if (splitter == NULL)
-	{
-		//this_token = (char*)ansi_sequence;
-		this_token = strtok((char*)ansi_sequence, (const char*)"m");
-//sprintf(global_string_buff2, "(solo token='%s'), start bold mode=%x", this_token, ansi_bold_mode);
-	}
-	else
-	{		
-		this_token = strtok((char*)ansi_sequence, (const char*)";");
-	}
-		
-	while (this_token != NULL)
+	// work through the params from left to right
+	for (i = 0; i <= ansi_param_idx; i++)
 	{
-		this_color_code = atoi(this_token);
+		this_color_code = ansi_param[i];
 		
-		//if (this_color_code == 0)
-		if (this_token[0] == '0' && strlen(this_token) == 1)
+		if (this_color_code == 0)
 		{
 			// 0 = reset background and foreground color to default
 			serial_fg_color = TERMINAL_DEFAULT_FORE_COLOR;
@@ -824,76 +1194,137 @@ void Serial_ANSIHandleSGR(uint8_t the_len)
 			}
 			else
 			{
-				sprintf(global_string_buff1, "SGR unhandled code '%s' (colorcode=%d) %s", ansi_sequence, this_color_code, global_string_buff2);
+				sprintf(global_string_buff1, "SGR unhandled code %u", this_color_code);
 				Buffer_NewMessage((global_string_buff1));
 			}
 		}
-		
-		this_token = strtok(NULL, (const char*)";");
 	}
-// sprintf(global_string_buff1, "SGR fg/bg=%d,%d; bold=%x %s", serial_fg_color, serial_bg_color, bold, global_string_buff2);
-// Buffer_NewMessage((global_string_buff1));
+	
+	Serial_UpdateAttr();
+}
+
+
+// DECSET/DECRST: CSI ? n ; ... h (set) or l (reset). the modes are in ansi_param[0..ansi_param_idx]
+// only DECAWM (7, autowrap) is acted on; the rest (eg, 1000, mouse) are ignored
+void Serial_ANSISetPrivateModes(bool set_mode)
+{
+	uint8_t		i;
+	
+	for (i = 0; i <= ansi_param_idx; i++)
+	{
+		if (ansi_param[i] == ANSI_PRIVATE_MODE_DECAWM)
+		{
+			serial_autowrap = set_mode;
+			
+			if (set_mode == false)
+			{
+				serial_wrap_pending = false;
+			}
+		}
+	}
 }
 
 
 // process a byte from the serial port, including checking for ANSI sequences and printing to screen
 void Serial_ProcessByte(uint8_t the_byte)
 {
+	uint8_t		the_class;
+	uint8_t		the_transition;
+	uint8_t		the_digit;
+	uint8_t*	this_param;
+	
+	// LOGIC:
+	//   bytes are run through a small state machine (see ansi_transition[]) one at a time, as they arrive
+	//   numeric params are accumulated into ansi_param[] digit by digit, so nothing is ever stored as text and re-parsed.
+	//   when the final byte of a sequence arrives, it's dispatched with its params already in hand.
+	//   sequences of any length are safe: extra params are dropped and the rest of the sequence is still consumed.
+	//   plain text in the ground state is by far the most common case, so it skips the table lookup.
+	
 	if (the_byte == 0)
 	{
 		// error condition
 		return;
 	}
-	else
+	
+	if (ansi_state == ANSI_STATE_GROUND && the_byte != CH_ESC && the_byte != ANSI_DEL)
 	{
-		// TODO: dedicated routine to display chars, handling movement back to next line, scroll screen, etc. 
-		
-		if (ansi_phase == 0 && the_byte != CH_ESC)
-		{
-			// normal text, not part of ANSI sequence
-			Serial_PrintByte(the_byte);
-		}
-		else
-		{
-			// are we in an ANSI sequence, or just kicking one off?
-			if (ansi_phase == 0 && the_byte == CH_ESC)
+		// normal text, not part of ANSI sequence
+		Serial_PrintByte(the_byte);
+		return;
+	}
+	
+	if (the_byte & 0x80)
+	{
+		the_class = ANSI_CLASS_HIGH;
+	}
+	else
+	{
+		the_class = ansi_byte_class[the_byte];
+	}
+	
+	the_transition = ansi_transition[ansi_state][the_class];
+	ansi_state = the_transition & 0x0f;
+	
+	switch (the_transition >> 4)
+	{
+		case ANSI_ACTION_PRINT:
+			// control chars inside a sequence are carried out as if the sequence wasn't there
+			Serial_PrintByte(the_byte);
+			break;
+			
+		case ANSI_ACTION_CLEAR:
+			memset(ansi_param, 0, ANSI_MAX_PARAMS);
+			ansi_param_idx = 0;
+			ansi_private = 0;
+			ansi_intermediate = 0;
+			break;
+			
+		case ANSI_ACTION_PARAM:
+			this_param = &ansi_param[ansi_param_idx];
+			the_digit = the_byte - CH_0;
+			
+			// saturate rather than wrap: anything over 255 becomes 255
+			if (*this_param > 25 || (*this_param == 25 && the_digit > 5))
 			{
-				ansi_phase = 1;
-				ansi_sequence = ansi_sequence_storage;
+				*this_param = ANSI_PARAM_MAX_VALUE;
 			}
-			else if (ansi_phase == 1)
+			else
 			{
-				if (the_byte == CH_LBRACKET)
-				{
-					// now we have full starting sequence: ESC+bracket
-					ansi_phase = 2;
-				}
-				else
-				{
-					// turns out this wasn't ANSI after all.
-					ansi_phase = 0;
-					Serial_PrintByte(the_byte);					
-				}
+				*this_param = *this_param * 10 + the_digit;
+			}
+			break;
+			
+		case ANSI_ACTION_NEXT_PARAM:
+			if (ansi_param_idx < ANSI_MAX_PARAMS - 1)
+			{
+				++ansi_param_idx;
 			}
 			else
 			{
-				// we were already in an ANSI sequence. collect.
-				if ( (the_byte > CH_AT && the_byte < CH_LBRACKET) || (the_byte > CH_LSQUOTE && the_byte < CH_LCBRACKET) )
-				{
-					// terminated marker for an ANSI sequence is an upper or lower case alpha char
-					*ansi_sequence++ = the_byte;
-					*ansi_sequence = 0;
-					ansi_phase = 0;
-					Serial_ProcessANSI();
-					ansi_sequence = ansi_sequence_storage;
-				}
-				else
-				{
-					// some part of the body of the sequence
-					*ansi_sequence++ = the_byte;
-				}
+				// out of room: keep consuming, but anything past here is lost
+				ansi_param[ansi_param_idx] = 0;
 			}
-		}
+			break;
+			
+		case ANSI_ACTION_PRIVATE:
+			ansi_private = the_byte;
+			break;
+			
+		case ANSI_ACTION_COLLECT:
+			ansi_intermediate = the_byte;
+			break;
+			
+		case ANSI_ACTION_CSI_DISPATCH:
+			Serial_ProcessANSI(the_byte);
+			break;
+			
+		case ANSI_ACTION_ESC_DISPATCH:
+			Serial_ProcessEscape(the_byte);
+			break;
+			
+		default:
+			// ANSI_ACTION_NONE
+			break;
 	}
 }
 
@@ -901,42 +1332,28 @@ void Serial_ProcessByte(uint8_t the_byte)
 // print a byte to screen, from the serial port
 void Serial_PrintByte(uint8_t the_byte)
 {
-	bool		update_vicky_curs_pos = true;
-
 	// reset text engine location, in case it has changed due to other action
 	Text_SetXY(serial_x, serial_y);
 	
 	if (the_byte == CH_ENTER)
 	{
 		serial_x = TERM_BODY_X1;
+		serial_wrap_pending = false;
 	}
 	else if (the_byte == CH_LF || the_byte == CH_FF)
 	{
-		if (serial_y >= TERM_BODY_Y2)
-		{
-			Text_ScrollTextAndAttrRowsUp(TERM_BODY_Y1+1, TERM_BODY_Y2);
-			Text_FillBox(TERM_BODY_X1, TERM_BODY_Y2, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
-		}
-		else
-		{
-			++serial_y;
-		}
+		Serial_Index();
+		serial_wrap_pending = false;
 	}
 	else if (the_byte == CH_BKSP && serial_x > TERM_BODY_X1)
 	{
 		// backspace in ASCII. not sure if right thing is to move back or delete prev char and move back
 		--serial_x;
+		serial_wrap_pending = false;
 	}
 	else
 	{
-		Text_SetCharAndColor(the_byte, serial_fg_color, serial_bg_color);
-		serial_x++;	// test lib moved ahead, but locally we need to know if wrapping happened.
-		update_vicky_curs_pos = false;
-
-		if (serial_x > TERM_BODY_X2)
-		{
-			serial_x = TERM_BODY_X2;
-		}
+		Serial_PrintRun(&the_byte, 1);
 		
 // 		// DEBUG - print everything in the in-buffer
 // 		memcpy(global_string_buff1, global_uart_in_buffer, global_uart_read_idx);
@@ -946,86 +1363,149 @@ void Serial_PrintByte(uint8_t the_byte)
 	}
 	
 	// update cursor position in VICKY so flashing cursor shows where we are
-	if (update_vicky_curs_pos == true)
+	Text_SetXY(serial_x, serial_y);
+}
+
+
+// print a run of printable (non-control) bytes to screen at the current serial position, from the serial port
+// same result as calling Serial_PrintByte() for each, but with one screen write per row and one cursor update for the whole run
+void Serial_PrintRun(uint8_t* the_run, uint16_t the_len)
+{
+	uint8_t		space_left;
+	
+	// LOGIC:
+	//   VT-style deferred wrap: printing to the last column leaves the cursor there, with a wrap pending. the wrap
+	//   (CR + index, scrolling if at the bottom margin) happens only when another printable char arrives. so a line of
+	//   exactly 80 chars followed by CR LF doesn't leave a blank row, which is what BBS ANSI art expects.
+	//   a run is drawn in row-sized pieces: one draw per row, however long the run.
+	//   with autowrap off, chars past the right edge each overwrite the last column, so only the run's last char shows.
+	
+	while (the_len > 0)
 	{
-		Text_SetXY(serial_x, serial_y);
+		if (serial_wrap_pending)
+		{
+			serial_x = TERM_BODY_X1;
+			Serial_Index();
+			serial_wrap_pending = false;
+		}
+		
+		space_left = (TERM_BODY_X2 + 1) - serial_x;
+		
+		if (the_len < space_left)
+		{
+			Shadow_DrawRun(serial_x, serial_y, the_run, (uint8_t)the_len, serial_attr);
+			serial_x += (uint8_t)the_len;
+			break;
+		}
+		
+		Shadow_DrawRun(serial_x, serial_y, the_run, space_left, serial_attr);
+		serial_x = TERM_BODY_X2;
+		
+		if (serial_autowrap == false)
+		{
+			if (the_len > space_left)
+			{
+				Shadow_DrawRun(TERM_BODY_X2, serial_y, &the_run[the_len - 1], 1, serial_attr);
+			}
+			
+			break;
+		}
+		
+		serial_wrap_pending = true;
+		the_run += space_left;
+		the_len -= space_left;
 	}
+	
+	// update cursor position in VICKY, once for the whole run
+	Text_SetXY(serial_x, serial_y);
 }
 
 
-// process the ANSI sequence stored in ansi_sequence_storage
-void Serial_ProcessANSI(void)
+// carry out the CSI sequence whose params have been collected in ansi_param[]
+// the_function is the final byte of the sequence (eg, 'H' for CUP)
+void Serial_ProcessANSI(uint8_t the_function)
 {
-	uint8_t			the_len;
-	uint8_t			ansi_function;
-	uint8_t			the_count;	// for single-number functions, will hold converted number
-	ansi_action		the_action = ANSI_UNRECOGNIZED;
+	uint8_t			the_count;	// for single-number functions, the first param
 	
 	// LOGIC:
 	//   ANSI CSI (Control Sequence Introducer) sequences consist of ESC + [ + params + function code
 	//   The function code is a single byte, case sensitive
-	//   the parameters are read left to right, and can be stacked with semicolons
-	//
-	//   design here is to first distinguish which function it is by checking last letter,
-	//   then...
+	//   the parameters have already been converted to numbers by Serial_ProcessByte(), left to right, in ansi_param[]
+	//   an omitted param is 0. for the cursor movement functions that means 1.
+	
+	if (ansi_intermediate == 0 && ansi_private == '?' && (the_function == ANSI_FUNCTION_PRIVSETMODE || the_function == ANSI_FUNCTION_PRIVRESETMODE))
+	{
+		Serial_ANSISetPrivateModes(the_function == ANSI_FUNCTION_PRIVSETMODE);
+		return;
+	}
+	
+	if (ansi_private != 0 || ansi_intermediate != 0)
+	{
+		// other private functions (eg, ?1000h, hide mouse) and ones with intermediates: none we attempt to handle
+		return;
+	}
 	
-	ansi_sequence = ansi_sequence_storage;
+	// LOGIC:
+	//   a pending wrap is cancelled by anything that moves the cursor or edits the screen. SGR (and DSR, which only reports)
+	//   leave it alone, so a color change between the 80th and 81st chars of a line doesn't lose the wrap.
+	
+	if (the_function != ANSI_FUNCTION_SGR && the_function != ANSI_FUNCTION_DSR)
+	{
+		serial_wrap_pending = false;
+	}
 	
-	the_len = General_Strnlen((char*)ansi_sequence, ANSI_MAX_SEQUENCE_LEN + 1);
-	ansi_function = ansi_sequence[the_len-1];
-	--the_len; // so we can pass this to handler functions and not have it see the command code
-	the_count = atoi((char*)ansi_sequence);	// won't work for all functions, but that's fine.
+	the_count = ansi_param[0];
 	
-	switch (ansi_function)
+	switch (the_function)
 	{
 		case ANSI_FUNCTION_CUU:
 			// Cursor Up
-			Serial_ANSICursorUp(the_count);
+			Serial_ANSICursorUp(the_count ? the_count : 1);
 			break;
 		
 		case ANSI_FUNCTION_SU:
 			// Scroll Up
-			Serial_ANSIScrollUp(false);
+			Serial_ANSIScrollUp(the_count ? the_count : 1);
 			break;
 		
 		case ANSI_FUNCTION_CUD:
 			// Cursor Down
-			Serial_ANSICursorDown(the_count);
+			Serial_ANSICursorDown(the_count ? the_count : 1);
 			break;
 		
 		case ANSI_FUNCTION_SD:
 			// Scroll Down
-			Serial_ANSIScrollUp(false);
+			Serial_ANSIScrollDown(the_count ? the_count : 1);
 			break;
 		
 		case ANSI_FUNCTION_CUF:
 			// Cursor Forward
-			Serial_ANSICursorRight(the_count);
+			Serial_ANSICursorRight(the_count ? the_count : 1);
 			break;
 		
 		case ANSI_FUNCTION_CUB:
 			// Cursor Back
-			Serial_ANSICursorLeft(the_count);
+			Serial_ANSICursorLeft(the_count ? the_count : 1);
 			break;
 		
 		case ANSI_FUNCTION_CNL:
 			// Cursor Next Line
-			Serial_ANSICursorNextLine(the_count);
+			Serial_ANSICursorNextLine(the_count ? the_count : 1);
 			break;
 		
 		case ANSI_FUNCTION_CPL:
 			// Cursor Previous Line
-			Serial_ANSICursorPreviousLine(the_count);
+			Serial_ANSICursorPreviousLine(the_count ? the_count : 1);
 			break;
 		
 		case ANSI_FUNCTION_CHA:
 			// Cursor Horizontal Absolute
-			Serial_ANSICursorSetXPos(the_count);
+			Serial_ANSICursorSetXPos(the_count ? the_count : 1);
 			break;
 		
 		case ANSI_FUNCTION_CUP:
 			// Cursor Position
-			Serial_ANSICursorSetXYPos();
+			Serial_ANSICursorSetXYPos(ansi_param[0], ansi_param[1]);
 			break;
 
 		case ANSI_FUNCTION_SAVECURPOS:
@@ -1054,12 +1534,12 @@ void Serial_ProcessANSI(void)
 		
 		case ANSI_FUNCTION_HVP:
 			// Horizontal Vertical Position
-			Serial_ANSICursorMoveToXY();
+			Serial_ANSICursorMoveToXY(ansi_param[0], ansi_param[1]);
 			break;
 		
 		case ANSI_FUNCTION_SGR:
 			// Select Graphic Rendition
-			Serial_ANSIHandleSGR(the_len);
+			Serial_ANSIHandleSGR();
 			break;
 		
 		case ANSI_FUNCTION_DSR:
@@ -1067,20 +1547,99 @@ void Serial_ProcessANSI(void)
 			Serial_ANSISendDSR(the_count);
 			break;
 		
-		case ANSI_FUNCTION_PRIVHIDEMOUSE:
-		case ANSI_FUNCTION_PRIVSHOWMOUSE:
-			// private functions we will not attempt to parse
+		case ANSI_FUNCTION_IL:
+			// Insert Line
+			Serial_ANSIInsertLines(the_count ? the_count : 1);
 			break;
-			
+		
+		case ANSI_FUNCTION_DL:
+			// Delete Line
+			Serial_ANSIDeleteLines(the_count ? the_count : 1);
+			break;
+		
+		case ANSI_FUNCTION_ICH:
+			// Insert Character
+			Serial_ANSIInsertChars(the_count ? the_count : 1);
+			break;
+		
+		case ANSI_FUNCTION_DCH:
+			// Delete Character
+			Serial_ANSIDeleteChars(the_count ? the_count : 1);
+			break;
+		
+		case ANSI_FUNCTION_ECH:
+			// Erase Character
+			Serial_ANSIEraseChars(the_count ? the_count : 1);
+			break;
+		
+		case ANSI_FUNCTION_DECSTBM:
+			// Set scroll region
+			Serial_ANSISetScrollRegion(ansi_param[0], ansi_param[1]);
+			break;
+		
 		default:
 			// unknown (to f/term) ANSI functions: capture in the buffer
-			Buffer_NewMessage((char*)ansi_sequence);
+			sprintf(global_string_buff1, "CSI %u;%u%c unhandled", ansi_param[0], ansi_param[1], the_function);
+			Buffer_NewMessage(global_string_buff1);
+			break;
+	}
+}
+
+
+// carry out a (non-CSI) ESC sequence. the_function is the final byte of the sequence (eg, '7' for ESC 7)
+void Serial_ProcessEscape(uint8_t the_function)
+{
+	if (ansi_intermediate != 0)
+	{
+		// character set designations (ESC ( B, etc.): only one set is available, so nothing to do
+		return;
+	}
+	
+	if (the_function != ANSI_ESC_FUNCTION_DECSC)
+	{
+		serial_wrap_pending = false;
+	}
+	
+	switch (the_function)
+	{
+		case ANSI_ESC_FUNCTION_DECSC:
+			Serial_ANSICursorSave();
+			break;
+			
+		case ANSI_ESC_FUNCTION_DECRC:
+			Serial_ANSICursorRestore();
+			break;
+			
+		case ANSI_ESC_FUNCTION_RIS:
+			serial_autowrap = true;
+			serial_scroll_top = TERM_BODY_Y1;
+			serial_scroll_bottom = TERM_BODY_Y2;
+			Serial_ANSIClear();
+			break;
+			
+		case ANSI_ESC_FUNCTION_IND:
+			Serial_Index();
+			Text_SetXY(serial_x, serial_y);
+			break;
+			
+		case ANSI_ESC_FUNCTION_NEL:
+			serial_x = TERM_BODY_X1;
+			Serial_Index();
+			Text_SetXY(serial_x, serial_y);
+			break;
+			
+		case ANSI_ESC_FUNCTION_RI:
+			Serial_ReverseIndex();
+			Text_SetXY(serial_x, serial_y);
+			break;
+			
+		default:
+			// includes the backslash of an ST (ESC backslash) ending an OSC string
 			break;
 	}
 }
 // stuff found I didn't detect:
 // 8;25;80t	: Ps = 8 ;  height ;  width ⇒  Resize the text area to given height and width in characters.  Omitted parameters reuse the current height or width.  Zero parameters use the display's height or width
-// 1;25r	: ESC [ <top> ; <bottom> r    set scroll region
 
 
 /*****************************************************************************/
@@ -1102,7 +1661,8 @@ void Serial_InitANSIColors(void)
 
 // set up UART for serial comms
 // the_baud_rate_divisor must be UART_BAUD_DIV_4800, UART_BAUD_DIV_9600, etc.
-void Serial_InitUART(uint16_t the_baud_rate_divisor)
+// the_fifo_trigger must be UART_FCR_TRIGGER_1, UART_FCR_TRIGGER_4, etc.
+void Serial_InitUART(uint16_t the_baud_rate_divisor, uint8_t the_fifo_trigger)
 {
  	uint8_t		junk;
 
@@ -1111,13 +1671,22 @@ void Serial_InitUART(uint16_t the_baud_rate_divisor)
 
 	Serial_SetBaud(the_baud_rate_divisor);
 
-	// no idea what this does. copying blindly from EMWhite's BASIC example
-	R8(UART_IIR) = 231;
-	R8(UART_IER) = 0;	// probably turns off interrupts
+	Serial_SetFIFO(the_fifo_trigger);
 
 	// Read and clear status registers
 	junk = R8(UART_LSR);
 	junk = R8(UART_MSR);
+	junk = R8(UART_RBR);
+	junk = R8(UART_IIR);
+
+	// have the UART raise an IRQ when data arrives. OUT2 gates the UART's interrupt line, so it must be on too.
+	// the handler in interrupt.asm then drains the FIFO into the RX buffer without waiting on the main loop.
+	R8(UART_MCR) = FLAG_UART_MCR_DTR | FLAG_UART_MCR_RTS | FLAG_UART_MCR_OUT2;
+	R8(UART_IER) = FLAG_UART_IER_RXA;
+	
+	// clear any stale UART interrupt, then unmask it at the interrupt controller (kernel leaves it masked)
+	R8(INT_PENDING_REG1) = FLAG_INT1_UART;
+	R8(INT_MASK_REG1) = R8(INT_MASK_REG1) & (~FLAG_INT1_UART);
 
 	Sys_RestoreIOPage();
 	
@@ -1132,111 +1701,130 @@ void Serial_SetBaud(uint16_t the_baud_rate_divisor)
 {
 	Sys_SwapIOPage(VICKY_IO_PAGE_REGISTERS);
 
+	// while DLAB is set, RBR reads back as DLL: keep the UART IRQ handler out until it's cleared again
+	asm("SEI");
 	Serial_SetDLAB();
 	R16(UART_DLL) = the_baud_rate_divisor;
 	Serial_ClearDLAB();
+	asm("CLI");
 
 	Sys_RestoreIOPage();
 }
 
 
-// send a byte over the UART serial connection
-// if the UART send buffer does not have space for the byte, it will try for UART_MAX_SEND_ATTEMPTS then return an error
-// returns false on any error condition
-bool Serial_SendByte(uint8_t the_byte)
+// enable and reset the UART FIFOs, and set the receive FIFO level at which the UART raises an IRQ
+// the_fifo_trigger must be UART_FCR_TRIGGER_1, UART_FCR_TRIGGER_4, etc.
+void Serial_SetFIFO(uint8_t the_fifo_trigger)
 {
-	uint8_t		error_code;
-	bool		uart_in_buff_is_empty = false;
-	uint16_t	num_tries = 0;
+	// LOGIC:
+	//   when the UART says it hit the trigger level (rather than timing out), at least that many bytes are waiting,
+	//   so the IRQ handler can pull them all without checking LSR between bytes. tell it how many that is.
+	//   (this replaces the old magic 231 from the BASIC example: trigger 14 + both FIFO resets + enable. 
+	//   bit 5 there is a no-op on a 16550; leaving it off keeps the trigger-to-bytes table right on a 16750 too)
 	
 	Sys_SwapIOPage(VICKY_IO_PAGE_REGISTERS);
+	asm("SEI");
+	R8(UART_FCR) = FLAG_UART_FCR_ENABLE | FLAG_UART_FCR_RX_RESET | FLAG_UART_FCR_TX_RESET | (the_fifo_trigger & UART_FCR_TRIGGER_MASK);
+	global_uart_fifo_burst = serial_fifo_trigger_bytes[the_fifo_trigger >> 6];
+	asm("CLI");
+	Sys_RestoreIOPage();
+}
+
+
+// add bytes to the transmit queue and return immediately. the UART IRQ handler sends them as the UART has room
+// (and as flow control allows), so this never waits on the serial line.
+// returns # of bytes queued, which is less than buffer_size if the queue filled up
+uint16_t Serial_QueueData(uint8_t* the_buffer, uint16_t buffer_size)
+{
+	uint16_t	i;
+	uint8_t		next_head;
 	
-	error_code = R8(UART_LSR) & UART_ERROR_MASK;
+	// LOGIC:
+	//   single producer (us), single consumer (the IRQ handler): the byte goes in before head moves past it,
+	//   and head/tail are each 1 byte, so neither side ever sees a half-updated position. no need for SEI.
+	//   the queue is 256 bytes so the uint8_t positions wrap on their own. 1 slot is kept open to tell full from empty.
 	
-	if (error_code > 0)
+	for (i = 0; i < buffer_size; i++)
 	{
-		App_EnterStealthTextUpdateMode();
-		
-		if (error_code & FLAG_UART_LSR_OE)
-		{
-			Text_SetCharAtXY(TERM_ERROR_OE_X-10, TITLE_BAR_Y, 'O');
-		}
+		next_head = global_uart_tx_head + 1;
 		
-		if (error_code & FLAG_UART_LSR_PE)
-		{
-			Text_SetCharAtXY(TERM_ERROR_PE_X-10, TITLE_BAR_Y, 'P');
-		}
-		
-		if (error_code & FLAG_UART_LSR_FE)
-		{
-			Text_SetCharAtXY(TERM_ERROR_FE_X-10, TITLE_BAR_Y, 'F');
-		}
-		
-		if (error_code & FLAG_UART_LSR_BI)
-		{
-			Text_SetCharAtXY(TERM_ERROR_BI_X-10, TITLE_BAR_Y, 'B');
-		}
-		
-		if (error_code & FLAG_UART_LSR_ERR)
+		if (next_head == global_uart_tx_tail)
 		{
-			Text_SetCharAtXY(TERM_ERROR_ERR_X-10, TITLE_BAR_Y, 'E');
+			break;
 		}
 		
-		// try to clear error. 
-		error_code = R8(UART_LSR);
-		error_code = R8(UART_MSR);
-		
-		App_ExitStealthTextUpdateMode();
-
-		goto error;
+		global_uart_tx_buffer[global_uart_tx_head] = the_buffer[i];
+		global_uart_tx_head = next_head;
 	}
 	
-	while (uart_in_buff_is_empty == false && num_tries < UART_MAX_SEND_ATTEMPTS)
+	if (i > 0)
 	{
-		uart_in_buff_is_empty = R8(UART_LSR) & UART_THR_IS_EMPTY;
-		++num_tries;
-	};
+		Serial_StartTransmit();
+	}
 	
-	if (uart_in_buff_is_empty == true)
+	return i;
+}
+
+
+// add 1 byte to the transmit queue and return immediately
+// returns false if the queue is full
+bool Serial_QueueByte(uint8_t the_byte)
+{
+	return (Serial_QueueData(&the_byte, 1) == 1);
+}
+
+
+// returns the number of bytes that can be added to the transmit queue right now
+uint8_t Serial_QueueSpace(void)
+{
+	return (uint8_t)(global_uart_tx_tail - global_uart_tx_head - 1);
+}
+
+
+// send a byte over the UART serial connection
+// the byte goes through the transmit queue, so it stays in order with anything queued earlier
+// if the queue does not have space for the byte, it waits for room, up to UART_SEND_TIMEOUT_TICKS, then returns an error
+// returns false on any error condition
+bool Serial_SendByte(uint8_t the_byte)
+{
+	while (Serial_QueueByte(the_byte) == false)
 	{
-		goto error;
+		if (Serial_WaitForQueueSpace() == false)
+		{
+			return false;
+		}
 	}
 	
-	R8(UART_THR) = the_byte;
-	
-	Sys_RestoreIOPage();
-	
 	return true;
-	
-	error:
-		Sys_RestoreIOPage();
-		return false;
 }
 
 
-// send 1-255 bytes to the UART serial connection
-// returns # of bytes successfully sent (which may be less than number requested, in event of error, etc.)
-uint8_t Serial_SendData(uint8_t* the_buffer, uint16_t buffer_size)
+// send bytes to the UART serial connection, waiting for room in the transmit queue as needed
+// prefer Serial_QueueData() unless the caller really can't do anything else until the bytes are handed off
+// returns # of bytes successfully sent (which may be less than number requested, if the queue stops draining)
+uint16_t Serial_SendData(uint8_t* the_buffer, uint16_t buffer_size)
 {
-	uint16_t	i;
-	uint8_t		the_byte;
-	
-	if (buffer_size > 256)
-	{
-		return 0;
-	}
+	uint16_t	num_sent = 0;
+	uint16_t	num_queued;
 	
-	for (i=0; i < buffer_size; i++)
+	while (num_sent < buffer_size)
 	{
-		the_byte = the_buffer[i];
+		num_queued = Serial_QueueData(the_buffer + num_sent, buffer_size - num_sent);
 		
-		if (Serial_SendByte(the_byte) == false)
+		if (num_queued == 0)
+		{
+			if (Serial_WaitForQueueSpace() == false)
+			{
+				break;
+			}
+		}
+		else
 		{
-			return i;
+			num_sent += num_queued;
 		}
 	}
 	
-	return i;
+	return num_sent;
 }
 
 
@@ -1247,9 +1835,18 @@ bool Serial_ReadUART(void)
 	uint8_t		error_code;
 	bool		success = true;
 	
-	Sys_SwapIOPage(VICKY_IO_PAGE_REGISTERS);
-		
-	error_code = R8(UART_LSR) & UART_ERROR_MASK;
+	// LOGIC:
+	//   the UART IRQ handler (interrupt.asm) does the real work of moving bytes into the circular buffer
+	//   we still sweep the FIFO here once per main loop, in case the kernel was holding IRQs off when data arrived
+	//   (the sweep also restarts the transmit queue if it was waiting on CTS)
+	//   line errors are latched by the handler; report them (and clear the latch) here, outside of interrupt time
+	
+	Interrupt_ServiceUART();
+	
+	asm("SEI");
+	error_code = global_uart_line_status;
+	global_uart_line_status = 0;
+	asm("CLI");
 
 	if (error_code > 0)
 	{
@@ -1280,30 +1877,12 @@ bool Serial_ReadUART(void)
 			Text_SetCharAtXY(TERM_ERROR_ERR_X, TITLE_BAR_Y, 'E');
 		}
 		
-		// try to clear error. 
-		error_code = R8(UART_LSR);
-		error_code = R8(UART_MSR);
-		
 		//sprintf(global_string_buff1, "serial error %x", error_code);
 		//Buffer_NewMessage(global_string_buff1);
 		success = false;
 		
 		App_ExitStealthTextUpdateMode();
 	}
-	else
-	{
-		while ( (R8(UART_LSR) & UART_DATA_AVAILABLE) > 0)
-		{
-			global_uart_in_buffer[global_uart_write_idx++] = R8(UART_BASE);
-				
-			if (global_uart_write_idx > UART_BUFFER_SIZE)
-			{
-				global_uart_write_idx = 0;
-			}
-		}
-	}
-	
-	Sys_RestoreIOPage();
 	
 	return success;
 }
@@ -1313,35 +1892,249 @@ bool Serial_ReadUART(void)
 // returns false if no bytes were available
 bool Serial_ProcessAvailableData(void)
 {
-	if (global_uart_read_idx == global_uart_write_idx)
+	uint16_t	the_len;
+	uint16_t	i;
+	uint16_t	run_start;
+	
+	// LOGIC:
+	//   pull at most one chunk out of the EM ring per call, so the main loop still gets to check the keyboard
+	//   between chunks even when the ring has many KB queued up
+	
+	the_len = Serial_RingRead(serial_rx_chunk, UART_RX_CHUNK_SIZE);
+	
+	if (the_len == 0)
 	{
 		// nothing in receive buffer
 		return false;
 	}
-	else
+	
+	// LOGIC:
+	//   the VICKY cursor only matters when the screen is looked at, so don't move it for every glyph drawn.
+	//   text engine tracks the position in RAM while the chunk renders, and the cursor is pushed to VICKY once at the end.
+	//   a chunk is at most 256 bytes, ~22ms at 115200, so the cursor is at most about one frame behind during a flood.
+	
+	Text_DeferCursorUpdates(true);
+	Shadow_Begin();
+	
+	// LOGIC:
+	//   plain text makes up most of what BBSes send. when not in the middle of an ANSI sequence, scan ahead for a run
+	//   of printable bytes and hand the whole run to Serial_PrintRun(). everything else goes byte by byte through the parser.
+	//   printable here is anything from space up except DEL: controls below space, and DEL, are the only bytes the ground state treats specially.
+	//   a ZMODEM sender starts with a ZRQINIT hex header: "**", ZDLE (0x18), then "B00" and the rest of the header.
+	//   the "**" prints like any text. a ZDLE in the ground state is held back rather than processed, and so are the
+	//   bytes after it, for as long as they go on matching "B00". the match count carries over from one chunk to the next,
+	//   so a chunk boundary anywhere in the header doesn't matter. on a full match, stop rendering: the rest is the header,
+	//   and the main loop hands over to the ZMODEM receiver. on a mismatch, the ZDLE is dropped (CAN does nothing in the
+	//   ground state) and the bytes that matched after it are shown as the text they turned out to be.
+	
+	i = 0;
+	
+	while (i < the_len)
 	{
-		while ( global_uart_read_idx != global_uart_write_idx )
+		if (serial_zrqinit_match > 0)
 		{
-			Serial_ProcessByte(global_uart_in_buffer[global_uart_read_idx++]);
+			if (serial_rx_chunk[i] == SERIAL_ZRQINIT_MATCH[serial_zrqinit_match])
+			{
+				++i;
+				
+				if (++serial_zrqinit_match == SERIAL_ZRQINIT_MATCH_LEN)
+				{
+					serial_zrqinit_match = 0;
+					serial_zmodem_requested = true;
+					break;
+				}
+				
+				continue;
+			}
 			
-			if (global_uart_read_idx > UART_BUFFER_SIZE)
+			if (serial_zrqinit_match > 1)
 			{
-				global_uart_read_idx = 0;
+				Serial_PrintRun((uint8_t*)SERIAL_ZRQINIT_MATCH + 1, serial_zrqinit_match - 1);
 			}
+			
+			serial_zrqinit_match = 0;
+			
+			// this byte was not part of the match: fall through and handle it as usual
+		}
+		
+		if (ansi_state == ANSI_STATE_GROUND && serial_rx_chunk[i] >= CH_SPACE && serial_rx_chunk[i] != ANSI_DEL)
+		{
+			run_start = i;
+			
+			do
+			{
+				++i;
+			} while (i < the_len && serial_rx_chunk[i] >= CH_SPACE && serial_rx_chunk[i] != ANSI_DEL);
+			
+			Serial_PrintRun(&serial_rx_chunk[run_start], i - run_start);
+		}
+		else if (ansi_state == ANSI_STATE_GROUND && serial_rx_chunk[i] == SERIAL_ZDLE)
+		{
+			serial_zrqinit_match = 1;
+			++i;
+		}
+		else
+		{
+			Serial_ProcessByte(serial_rx_chunk[i]);
+			++i;
 		}
 	}
 	
+	Shadow_End();
+	Text_DeferCursorUpdates(false);
+	
 	return true;
 }
 
 
+// returns true (once) if a ZMODEM sender asked to start a transfer during the last Serial_ProcessAvailableData()
+// the rest of the sender's request was not displayed: the caller should start the ZMODEM receiver right away
+bool Serial_ZModemStartRequested(void)
+{
+	bool	was_requested = serial_zmodem_requested;
+	
+	serial_zmodem_requested = false;
+	
+	return was_requested;
+}
+
+
+// copy up to max_len bytes out of the extended memory RX ring into the_buffer, and mark them as consumed
+// each contiguous run within a ring bank is moved with one bank swap and one memcpy
+// returns the number of bytes copied (0 if the ring is empty)
+uint16_t Serial_RingRead(uint8_t* the_buffer, uint16_t max_len)
+{
+	uint16_t	write_idx;
+	uint16_t	read_idx;
+	uint16_t	the_len;
+	uint16_t	run_len;
+	uint16_t	bank_offset;
+	uint16_t	total_copied = 0;
+	uint8_t		previous_bank;
+	
+	// LOGIC:
+	//   the IRQ handler can move global_uart_write_idx at any moment, so take a snapshot with IRQs off (16-bit read isn't atomic)
+	//   anything that arrives while we copy will be picked up on the next call
+	//   a run stops at the end of a bank, so at most 2 swaps are needed per call unless max_len > 8K
+	//   the IRQ handler saves/restores slot 5 itself, so it's fine for it to fire while we have a ring bank mapped
+	
+	asm("SEI");
+	write_idx = global_uart_write_idx;
+	asm("CLI");
+	
+	read_idx = global_uart_read_idx;
+	the_len = (write_idx - read_idx) & UART_RING_MASK;
+	
+	if (the_len > max_len)
+	{
+		the_len = max_len;
+	}
+	
+	while (the_len > 0)
+	{
+		bank_offset = read_idx & (UART_RING_BANK_SIZE - 1);
+		run_len = UART_RING_BANK_SIZE - bank_offset;
+		
+		if (run_len > the_len)
+		{
+			run_len = the_len;
+		}
+		
+		zp_bank_num = UART_RING_START_PHYS_BANK_NUM + (read_idx >> UART_RING_BANK_SHIFT);
+		previous_bank = Memory_SwapInNewBank(UART_RING_SLOT);
+		
+		memcpy(the_buffer, (uint8_t*)(UART_RING_START_CPU_ADDR + bank_offset), run_len);
+		
+		zp_bank_num = previous_bank;
+		Memory_SwapInNewBank(UART_RING_SLOT);
+		
+		the_buffer += run_len;
+		read_idx = (read_idx + run_len) & UART_RING_MASK;
+		the_len -= run_len;
+		total_copied += run_len;
+	}
+	
+	// hand the space back to the IRQ handler
+	asm("SEI");
+	global_uart_read_idx = read_idx;
+	asm("CLI");
+	
+	// if the IRQ handler had asked the other side to pause, let it resume once we've caught up
+	if (global_uart_rx_throttled == true && Serial_RingBytesUsed() <= UART_RING_LOW_WATER)
+	{
+		Serial_ReleaseReceiveThrottle();
+	}
+	
+	return total_copied;
+}
+
+
+// returns the number of received bytes waiting in the RX ring
+uint16_t Serial_RingBytesUsed(void)
+{
+	uint16_t	write_idx;
+	
+	asm("SEI");
+	write_idx = global_uart_write_idx;
+	asm("CLI");
+	
+	return (write_idx - global_uart_read_idx) & UART_RING_MASK;
+}
+
+
+// set the flow control mode to UART_FLOW_CONTROL_NONE, UART_FLOW_CONTROL_RTS_CTS, or UART_FLOW_CONTROL_XON_XOFF
+// if receive was being throttled under the old mode, it is released. returns the previous mode.
+uint8_t Serial_SetFlowControl(uint8_t the_mode)
+{
+	uint8_t		previous_mode = global_uart_flow_control;
+	
+	// release under the old mode (so an XOFF we sent gets its XON), then switch
+	// RTS is left up whenever we aren't throttling, so this also covers switching flow control off
+	Serial_ReleaseReceiveThrottle();
+	
+	asm("SEI");
+	global_uart_flow_control = the_mode;
+	global_uart_tx_paused = false;
+	asm("CLI");
+	
+	// anything held back by the old mode can go now
+	Serial_StartTransmit();
+	
+	return previous_mode;
+}
+
+
+// call before starting a binary file transfer. XON/XOFF bytes are legitimate data in a binary stream,
+// so software flow control is suspended until Serial_EndBinaryTransfer(). hardware flow control stays on.
+void Serial_BeginBinaryTransfer(void)
+{
+	if (global_uart_flow_control == UART_FLOW_CONTROL_XON_XOFF)
+	{
+		serial_suspended_flow_control = Serial_SetFlowControl(UART_FLOW_CONTROL_NONE);
+	}
+}
+
+
+// call when a binary file transfer is over: restores software flow control if it was suspended
+void Serial_EndBinaryTransfer(void)
+{
+	if (serial_suspended_flow_control != UART_FLOW_CONTROL_NONE)
+	{
+		Serial_SetFlowControl(serial_suspended_flow_control);
+		serial_suspended_flow_control = UART_FLOW_CONTROL_NONE;
+	}
+}
+
+
 // get a byte from UART serial connection, or 1 ANSI sequence worth of bytes
 // flush the in (Rx) buffer
 // resets circular buffer pointers so that any not-yet-processed bytes are forgotten about
 void Serial_FlushInBuffer(void)
 {
+	asm("SEI");
 	global_uart_read_idx = 0;
 	global_uart_write_idx = 0;
+	asm("CLI");
 }
 
 
@@ -1373,7 +2166,9 @@ void Serial_CycleForegroundColor(void)
 	}
 	
 	Text_FillBoxAttrOnly(TERM_BODY_X1, TERM_BODY_Y1, TERM_BODY_X2, TERM_BODY_Y2, serial_current_pref_color, COLOR_BLACK);
+	Shadow_Invalidate();
 	serial_fg_color = serial_current_pref_color;
+	Serial_UpdateAttr();
 }
 
 
@@ -49,8 +49,12 @@
 
 #define NUM_ANSI_CODES			19
 
-//#define UART_BUFFER_SIZE		8192	// size of the circular buffer offloading serial data
-//#define UART_BUFFER_MASK		(UART_BUFFER_SIZE - 1)
+// flow control modes for Serial_SetFlowControl(). interrupt.asm has its own copy of these values.
+#define UART_FLOW_CONTROL_NONE		0
+#define UART_FLOW_CONTROL_RTS_CTS	1	// drop RTS when the RX ring is nearly full; only transmit while CTS is up
+#define UART_FLOW_CONTROL_XON_XOFF	2	// send XOFF/XON at the RX ring watermarks; pause transmit between a received XOFF and XON
+
+#define UART_TX_QUEUE_SIZE			256	// must stay 256: the queue positions are uint8_t and wrap on their own
 
 // ANSI color codes
 #define ANSI_COLOR_BLACK			(uint8_t)0x00
@@ -126,18 +130,37 @@ void Serial_InitANSIColors(void);
 
 // set up UART for serial comms
 // the_baud_rate_divisor must be UART_BAUD_DIV_4800, UART_BAUD_DIV_9600, etc.
-void Serial_InitUART(uint16_t the_baud_rate_divisor);
+// the_fifo_trigger must be UART_FCR_TRIGGER_1, UART_FCR_TRIGGER_4, etc.
+void Serial_InitUART(uint16_t the_baud_rate_divisor, uint8_t the_fifo_trigger);
 
 // change baud rate
 // the_baud_rate_divisor must be UART_BAUD_DIV_4800, UART_BAUD_DIV_9600, etc.
 void Serial_SetBaud(uint16_t the_baud_rate_divisor);
 
-// send 1-255 bytes to the UART serial connection
-// returns # of bytes successfully sent (which may be less than number requested, in event of error, etc.)
-uint8_t Serial_SendData(uint8_t* the_buffer, uint16_t buffer_size);
+// enable and reset the UART FIFOs, and set the receive FIFO level at which the UART raises an IRQ
+// the_fifo_trigger must be UART_FCR_TRIGGER_1, UART_FCR_TRIGGER_4, etc.
+void Serial_SetFIFO(uint8_t the_fifo_trigger);
+
+// add bytes to the transmit queue and return immediately. the UART IRQ handler sends them as the UART has room
+// (and as flow control allows), so this never waits on the serial line.
+// returns # of bytes queued, which is less than buffer_size if the queue filled up
+uint16_t Serial_QueueData(uint8_t* the_buffer, uint16_t buffer_size);
+
+// add 1 byte to the transmit queue and return immediately
+// returns false if the queue is full
+bool Serial_QueueByte(uint8_t the_byte);
+
+// returns the number of bytes that can be added to the transmit queue right now
+uint8_t Serial_QueueSpace(void);
+
+// send bytes to the UART serial connection, waiting for room in the transmit queue as needed
+// prefer Serial_QueueData() unless the caller really can't do anything else until the bytes are handed off
+// returns # of bytes successfully sent (which may be less than number requested, if the queue stops draining)
+uint16_t Serial_SendData(uint8_t* the_buffer, uint16_t buffer_size);
 
 // send a byte over the UART serial connection
-// if the UART send buffer does not have space for the byte, it will try for UART_MAX_SEND_ATTEMPTS then return an error
+// the byte goes through the transmit queue, so it stays in order with anything queued earlier
+// if the queue does not have space for the byte, it waits for room, up to UART_SEND_TIMEOUT_TICKS, then returns an error
 // returns false on any error condition
 bool Serial_SendByte(uint8_t the_byte);
 
@@ -149,6 +172,29 @@ bool Serial_ReadUART(void);
 // returns false if no bytes were available
 bool Serial_ProcessAvailableData(void);
 
+// returns true (once) if a ZMODEM sender asked to start a transfer during the last Serial_ProcessAvailableData()
+// the rest of the sender's request was not displayed: the caller should start the ZMODEM receiver right away
+bool Serial_ZModemStartRequested(void);
+
+// copy up to max_len bytes out of the extended memory RX ring into the_buffer, and mark them as consumed
+// each contiguous run within a ring bank is moved with one bank swap and one memcpy
+// returns the number of bytes copied (0 if the ring is empty)
+uint16_t Serial_RingRead(uint8_t* the_buffer, uint16_t max_len);
+
+// returns the number of received bytes waiting in the RX ring
+uint16_t Serial_RingBytesUsed(void);
+
+// set the flow control mode to UART_FLOW_CONTROL_NONE, UART_FLOW_CONTROL_RTS_CTS, or UART_FLOW_CONTROL_XON_XOFF
+// if receive was being throttled under the old mode, it is released. returns the previous mode.
+uint8_t Serial_SetFlowControl(uint8_t the_mode);
+
+// call before starting a binary file transfer. XON/XOFF bytes are legitimate data in a binary stream,
+// so software flow control is suspended until Serial_EndBinaryTransfer(). hardware flow control stays on.
+void Serial_BeginBinaryTransfer(void);
+
+// call when a binary file transfer is over: restores software flow control if it was suspended
+void Serial_EndBinaryTransfer(void);
+
 // flush the in (Rx) buffer
 // resets circular buffer pointers so that any not-yet-processed bytes are forgotten about
 void Serial_FlushInBuffer(void);
@@ -162,8 +208,6 @@ void Serial_ANSICursorRestore(void);
 // cycle to the next foreground color, updating every cell in the terminal screen
 void Serial_CycleForegroundColor(void);
 
-// // start YMODEM file receive
-// bool Serial_StartYModemReceive(void);
 
 
 
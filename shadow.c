@@ -0,0 +1,480 @@
+/*
+ * shadow.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+// off-screen copy of the terminal body, so ANSI drawing doesn't hit VICKY memory (and swap IO pages) for every operation
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "shadow.h"
+#include "memory.h"
+#include "screen.h"
+#include "scrollback.h"
+#include "sys.h"
+#include "text.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// F256 includes
+#include "f256.h"
+
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define SHADOW_DIRTY_BYTES		((TERM_BODY_HEIGHT + 7) / 8)
+
+
+/*****************************************************************************/
+/*                           File-scoped Variables                           */
+/*****************************************************************************/
+
+static bool			shadow_enabled;
+static bool			shadow_active;		// true between Shadow_Begin() and Shadow_End()
+static bool			shadow_stale = true;	// VICKY memory has changed behind our back: reload before use
+static uint8_t		shadow_previous_bank;
+static uint8_t*		shadow_row[TERM_BODY_HEIGHT];	// logical row -> its 160 bytes in the shadow bank. rotated to scroll.
+static uint8_t		shadow_dirty[SHADOW_DIRTY_BYTES];	// 1 bit per row: drawn since last flush
+
+static const uint8_t	shadow_bit[8] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+extern uint8_t			zp_bank_num;
+#pragma zpsym ("zp_bank_num");
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// mark a shadow row (0 to TERM_BODY_HEIGHT-1) as needing to be flushed
+void Shadow_MarkDirty(uint8_t the_row);
+
+// point every logical row back at its own slot in the shadow bank, and load the shadow from VICKY memory
+// shadow bank must be mapped in
+void Shadow_Reload(void);
+
+// copy all dirty rows to VICKY memory, and clear the dirty bitmap
+// shadow bank must be mapped in
+void Shadow_Flush(void);
+
+// map the shadow bank into the overlay slot, remembering what was there
+void Shadow_MapIn(void);
+
+// put back whatever was in the overlay slot before Shadow_MapIn()
+void Shadow_MapOut(void);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// mark a shadow row (0 to TERM_BODY_HEIGHT-1) as needing to be flushed
+void Shadow_MarkDirty(uint8_t the_row)
+{
+	shadow_dirty[the_row >> 3] |= shadow_bit[the_row & 0x07];
+}
+
+
+// point every logical row back at its own slot in the shadow bank, and load the shadow from VICKY memory
+// shadow bank must be mapped in
+void Shadow_Reload(void)
+{
+	uint8_t		i;
+	uint8_t*	the_shadow_loc = (uint8_t*)SHADOW_CPU_ADDR;
+	
+	for (i = 0; i < TERM_BODY_HEIGHT; i++)
+	{
+		shadow_row[i] = the_shadow_loc;
+		the_shadow_loc += SHADOW_ROW_SIZE;
+	}
+	
+	Sys_SwapIOPage(VICKY_IO_PAGE_CHAR_MEM);
+
+	for (i = 0; i < TERM_BODY_HEIGHT; i++)
+	{
+		memcpy(shadow_row[i], TEXT_ROW_ADDR(TERM_BODY_Y1 + i) + TERM_BODY_X1, TERM_BODY_WIDTH);
+	}
+	
+	Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
+
+	for (i = 0; i < TERM_BODY_HEIGHT; i++)
+	{
+		memcpy(shadow_row[i] + SHADOW_ATTR_OFFSET, TEXT_ROW_ADDR(TERM_BODY_Y1 + i) + TERM_BODY_X1, TERM_BODY_WIDTH);
+	}
+	
+	Sys_RestoreIOPage();
+
+	memset(shadow_dirty, 0, SHADOW_DIRTY_BYTES);
+	shadow_stale = false;
+}
+
+
+
+// copy all dirty rows to VICKY memory, and clear the dirty bitmap
+// shadow bank must be mapped in
+void Shadow_Flush(void)
+{
+	uint8_t		i;
+	
+	// LOGIC:
+	//   char and attr memory share addresses, so do all dirty rows' chars in one IO page visit, then all their attrs in another.
+	//   the VICKY DMA engine can't reach text memory (see memory.asm), so the copies are done by the CPU.
+	
+	Sys_SwapIOPage(VICKY_IO_PAGE_CHAR_MEM);
+
+	for (i = 0; i < TERM_BODY_HEIGHT; i++)
+	{
+		if (shadow_dirty[i >> 3] & shadow_bit[i & 0x07])
+		{
+			memcpy(TEXT_ROW_ADDR(TERM_BODY_Y1 + i) + TERM_BODY_X1, shadow_row[i], TERM_BODY_WIDTH);
+		}
+	}
+	
+	Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
+
+	for (i = 0; i < TERM_BODY_HEIGHT; i++)
+	{
+		if (shadow_dirty[i >> 3] & shadow_bit[i & 0x07])
+		{
+			memcpy(TEXT_ROW_ADDR(TERM_BODY_Y1 + i) + TERM_BODY_X1, shadow_row[i] + SHADOW_ATTR_OFFSET, TERM_BODY_WIDTH);
+		}
+	}
+	
+	Sys_RestoreIOPage();
+	
+	memset(shadow_dirty, 0, SHADOW_DIRTY_BYTES);
+}
+
+
+// map the shadow bank into the overlay slot, remembering what was there
+void Shadow_MapIn(void)
+{
+	zp_bank_num = SHADOW_PHYS_BANK_NUM;
+	shadow_previous_bank = Memory_SwapInNewBank(SHADOW_SLOT);
+}
+
+
+// put back whatever was in the overlay slot before Shadow_MapIn()
+void Shadow_MapOut(void)
+{
+	zp_bank_num = shadow_previous_bank;
+	Memory_SwapInNewBank(SHADOW_SLOT);
+}
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// set up the row table. the shadow starts out stale, and is loaded from VICKY on first use. call once at startup.
+void Shadow_Init(void)
+{
+	shadow_active = false;
+	shadow_stale = true;
+	memset(shadow_dirty, 0, SHADOW_DIRTY_BYTES);
+}
+
+
+// turn the shadow screen on or off. when off, all Shadow_ drawing goes straight to VICKY.
+void Shadow_SetEnabled(bool enable_it)
+{
+	shadow_enabled = enable_it;
+	shadow_stale = true;
+}
+
+
+// map in the shadow bank so the Shadow_ drawing functions write to it. reloads the shadow from VICKY first, if stale.
+// must be paired with Shadow_End(). nothing else may use the overlay slot in between, except with a matched swap/restore.
+void Shadow_Begin(void)
+{
+	if (shadow_enabled == false)
+	{
+		return;
+	}
+	
+	Shadow_MapIn();
+	shadow_active = true;
+	
+	if (shadow_stale)
+	{
+		Shadow_Reload();
+	}
+}
+
+
+// copy any rows drawn since Shadow_Begin() to VICKY, and restore the overlay slot
+void Shadow_End(void)
+{
+	if (shadow_active == false)
+	{
+		return;
+	}
+	
+	Shadow_Flush();
+	Shadow_MapOut();
+	shadow_active = false;
+}
+
+
+// tell the shadow that something other than the Shadow_ functions changed the terminal body in VICKY memory
+// the shadow will be reloaded from VICKY on the next Shadow_Begin()
+void Shadow_Invalidate(void)
+{
+	shadow_stale = true;
+}
+
+
+// draw a run of chars, all with the same attribute, at x, y. the run must fit on the row.
+void Shadow_DrawRun(uint8_t x, uint8_t y, uint8_t* the_run, uint8_t the_len, uint8_t the_attribute_value)
+{
+	uint8_t*	the_write_loc;
+	
+	if (shadow_active == false)
+	{
+		Text_DrawCharsAndAttrAtXY(x, y, the_run, the_len, the_attribute_value);
+		shadow_stale = true;
+		return;
+	}
+	
+	y -= TERM_BODY_Y1;
+	the_write_loc = shadow_row[y] + (x - TERM_BODY_X1);
+	memcpy(the_write_loc, the_run, the_len);
+	memset(the_write_loc + SHADOW_ATTR_OFFSET, the_attribute_value, the_len);
+	Shadow_MarkDirty(y);
+}
+
+
+// fill a box with the_char and the_attribute_value. x1,y1 and x2,y2 are inclusive, and must be inside the terminal body.
+void Shadow_FillBox(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t the_char, uint8_t the_attribute_value)
+{
+	uint8_t*	the_write_loc;
+	uint8_t		width;
+	
+	if (shadow_active == false)
+	{
+		Text_FillBoxCharAndAttr(x1, y1, x2, y2, the_char, the_attribute_value);
+		shadow_stale = true;
+		return;
+	}
+	
+	width = x2 - x1 + 1;
+	x1 -= TERM_BODY_X1;
+	y1 -= TERM_BODY_Y1;
+	y2 -= TERM_BODY_Y1;
+	
+	for (; y1 <= y2; y1++)
+	{
+		the_write_loc = shadow_row[y1] + x1;
+		memset(the_write_loc, the_char, width);
+		memset(the_write_loc + SHADOW_ATTR_OFFSET, the_attribute_value, width);
+		Shadow_MarkDirty(y1);
+	}
+}
+
+
+// scroll rows y1-y2 up one row, same as Text_ScrollTextAndAttrRowsUp(): row y1-1 is lost, row y2 is left as it was
+// y1 must be > TERM_BODY_Y1, and y2 <= TERM_BODY_Y2
+// if to_history is true, the lost row is added to the scrollback history
+void Shadow_ScrollUp(uint8_t y1, uint8_t y2, bool to_history)
+{
+	uint8_t*	the_lost_row;
+	uint8_t		i;
+	
+	// LOGIC:
+	//   history lives in other extended memory banks, so the lost row is staged through the (always mapped) interbank buffer.
+	
+	if (shadow_active == false)
+	{
+		if (to_history)
+		{
+			Sys_SwapIOPage(VICKY_IO_PAGE_CHAR_MEM);
+			memcpy((uint8_t*)STORAGE_INTERBANK_BUFFER, TEXT_ROW_ADDR(y1 - 1) + TERM_BODY_X1, TERM_BODY_WIDTH);
+			Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
+			memcpy((uint8_t*)STORAGE_INTERBANK_BUFFER + SHADOW_ATTR_OFFSET, TEXT_ROW_ADDR(y1 - 1) + TERM_BODY_X1, TERM_BODY_WIDTH);
+			Sys_RestoreIOPage();
+			Scrollback_AddLine((uint8_t*)STORAGE_INTERBANK_BUFFER);
+		}
+		
+		Text_ScrollTextAndAttrRowsUp(y1, y2);
+		shadow_stale = true;
+		return;
+	}
+	
+	// LOGIC:
+	//   rows don't move in the shadow bank: the row table is rotated, and the lost row's storage is reused as the new row y2.
+	//   it gets a copy of row y2's old contents, so the result matches the VICKY version, which leaves row y2 as it was.
+	//   every row in the range is now different from VICKY, so all of them are flushed.
+	
+	y1 -= TERM_BODY_Y1;
+	y2 -= TERM_BODY_Y1;
+	
+	the_lost_row = shadow_row[y1 - 1];
+	
+	if (to_history)
+	{
+		memcpy((uint8_t*)STORAGE_INTERBANK_BUFFER, the_lost_row, SHADOW_ROW_SIZE);
+		Scrollback_AddLine((uint8_t*)STORAGE_INTERBANK_BUFFER);
+	}
+	
+	for (i = y1 - 1; i < y2; i++)
+	{
+		shadow_row[i] = shadow_row[i + 1];
+		Shadow_MarkDirty(i);
+	}
+	
+	memcpy(the_lost_row, shadow_row[y2], SHADOW_ROW_SIZE);
+	shadow_row[y2] = the_lost_row;
+	Shadow_MarkDirty(y2);
+}
+
+
+// scroll rows y1-y2 down one row, same as Text_ScrollTextAndAttrRowsDown(): row y2+1 is lost, row y1 is left as it was
+// y1 must be >= TERM_BODY_Y1, and y2 < TERM_BODY_Y2
+void Shadow_ScrollDown(uint8_t y1, uint8_t y2)
+{
+	uint8_t*	the_lost_row;
+	uint8_t		i;
+	
+	// LOGIC:
+	//   mirror image of Shadow_ScrollUp(). nothing goes to the scrollback history: the lost row is at the bottom.
+	
+	if (shadow_active == false)
+	{
+		Text_ScrollTextAndAttrRowsDown(y1, y2);
+		shadow_stale = true;
+		return;
+	}
+	
+	y1 -= TERM_BODY_Y1;
+	y2 -= TERM_BODY_Y1;
+	
+	the_lost_row = shadow_row[y2 + 1];
+	
+	for (i = y2 + 1; i > y1; i--)
+	{
+		shadow_row[i] = shadow_row[i - 1];
+		Shadow_MarkDirty(i);
+	}
+	
+	memcpy(the_lost_row, shadow_row[y1], SHADOW_ROW_SIZE);
+	shadow_row[y1] = the_lost_row;
+	Shadow_MarkDirty(y1);
+}
+
+
+// shift the cells of row y from x to the right edge right by the_count, blanking the cells opened up at x
+// cells pushed past the right edge are lost. the_count must be 1+.
+void Shadow_InsertCells(uint8_t x, uint8_t y, uint8_t the_count, uint8_t the_attribute_value)
+{
+	uint8_t*	the_row;
+	uint8_t		the_length;
+	
+	if (x + the_count > TERM_BODY_X2)
+	{
+		the_count = TERM_BODY_X2 - x + 1;
+	}
+	
+	if (shadow_active == false)
+	{
+		Text_ShiftTextAndAttrRight(x, y, the_count, CH_SPACE, the_attribute_value >> 4, the_attribute_value & 0x0F);
+		shadow_stale = true;
+		return;
+	}
+	
+	the_length = (TERM_BODY_X2 + 1 - x) - the_count;
+	x -= TERM_BODY_X1;
+	y -= TERM_BODY_Y1;
+	the_row = shadow_row[y] + x;
+	
+	memmove(the_row + the_count, the_row, the_length);
+	memset(the_row, CH_SPACE, the_count);
+	the_row += SHADOW_ATTR_OFFSET;
+	memmove(the_row + the_count, the_row, the_length);
+	memset(the_row, the_attribute_value, the_count);
+	
+	Shadow_MarkDirty(y);
+}
+
+
+// shift the cells of row y right of x+the_count-1 left by the_count, so they start at x, blanking the cells opened up at the right edge
+// cells x to x+the_count-1 are lost. the_count must be 1+.
+void Shadow_DeleteCells(uint8_t x, uint8_t y, uint8_t the_count, uint8_t the_attribute_value)
+{
+	uint8_t*	the_row;
+	uint8_t		the_length;
+	
+	if (x + the_count > TERM_BODY_X2)
+	{
+		// nothing is left to pull in from the right: just blank to the end of the row
+		Shadow_FillBox(x, y, TERM_BODY_X2, y, CH_SPACE, the_attribute_value);
+		return;
+	}
+	
+	if (shadow_active == false)
+	{
+		Text_ShiftTextAndAttrLeft(x + the_count, y, the_count, CH_SPACE, the_attribute_value >> 4, the_attribute_value & 0x0F);
+		shadow_stale = true;
+		return;
+	}
+	
+	the_length = (TERM_BODY_X2 + 1 - x) - the_count;
+	x -= TERM_BODY_X1;
+	y -= TERM_BODY_Y1;
+	the_row = shadow_row[y] + x;
+	
+	memmove(the_row, the_row + the_count, the_length);
+	memset(the_row + the_length, CH_SPACE, the_count);
+	the_row += SHADOW_ATTR_OFFSET;
+	memmove(the_row, the_row + the_count, the_length);
+	memset(the_row + the_length, the_attribute_value, the_count);
+	
+	Shadow_MarkDirty(y);
+}
+
+
+// load the shadow from VICKY memory, whether or not the shadow screen is enabled, so the terminal body can be put back
+// later with Shadow_Restore(). for things like the scrollback view, that take over the terminal body for a while.
+// not for use between Shadow_Begin() and Shadow_End().
+void Shadow_Save(void)
+{
+	Shadow_MapIn();
+	Shadow_Reload();
+	Shadow_MapOut();
+}
+
+
+// redraw the whole terminal body from the shadow. see Shadow_Save().
+void Shadow_Restore(void)
+{
+	Shadow_MapIn();
+	memset(shadow_dirty, 0xFF, SHADOW_DIRTY_BYTES);
+	Shadow_Flush();
+	Shadow_MapOut();
+}
+
+
+// draw one row of the shadow (0 to TERM_BODY_HEIGHT-1) to VICKY memory at screen row y. see Shadow_Save().
+void Shadow_DrawRowAt(uint8_t the_row, uint8_t y)
+{
+	Shadow_MapIn();
+	Text_DrawRowFromBuffer(y, shadow_row[the_row]);
+	Shadow_MapOut();
+}
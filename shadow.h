@@ -0,0 +1,120 @@
+/*
+ * shadow.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+#ifndef SHADOW_H_
+#define SHADOW_H_
+
+
+
+/* about this class: Shadow
+ *
+ * an off-screen copy of the terminal body (char + attr for TERM_BODY_HEIGHT rows of 80), kept in an extended memory bank
+ *
+ *** things this class needs to be able to do
+ *
+ * take the serial renderer's drawing (runs, box fills, scrolls) in place of VICKY text memory
+ * track which rows were touched since the last flush, in a bitmap
+ * flush only the touched rows to VICKY, once per chunk of received data (~1 frame at 115200)
+ * scroll by rotating row pointers instead of moving 2 x 80 bytes per row, passing the row that scrolls off to the scrollback history
+ * fall back to drawing straight to VICKY when not between Shadow_Begin() and Shadow_End()
+ *
+ *** things objects of this class have
+ *
+ * a row pointer table (logical row -> 160 bytes in the shadow bank: 80 chars then 80 attrs)
+ * a dirty row bitmap
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "app.h"
+#include "screen.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+#define SHADOW_ROW_SIZE				(TERM_BODY_WIDTH * 2)	// one row in the shadow bank: chars, then attrs
+#define SHADOW_ATTR_OFFSET			TERM_BODY_WIDTH			// offset of a row's attrs from its chars
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// set up the row table. the shadow starts out stale, and is loaded from VICKY on first use. call once at startup.
+void Shadow_Init(void);
+
+// turn the shadow screen on or off. when off, all Shadow_ drawing goes straight to VICKY.
+void Shadow_SetEnabled(bool enable_it);
+
+// map in the shadow bank so the Shadow_ drawing functions write to it. reloads the shadow from VICKY first, if stale.
+// must be paired with Shadow_End(). nothing else may use the overlay slot in between, except with a matched swap/restore.
+void Shadow_Begin(void);
+
+// copy any rows drawn since Shadow_Begin() to VICKY, and restore the overlay slot
+void Shadow_End(void);
+
+// tell the shadow that something other than the Shadow_ functions changed the terminal body in VICKY memory
+// the shadow will be reloaded from VICKY on the next Shadow_Begin()
+void Shadow_Invalidate(void);
+
+// draw a run of chars, all with the same attribute, at x, y. the run must fit on the row.
+void Shadow_DrawRun(uint8_t x, uint8_t y, uint8_t* the_run, uint8_t the_len, uint8_t the_attribute_value);
+
+// fill a box with the_char and the_attribute_value. x1,y1 and x2,y2 are inclusive, and must be inside the terminal body.
+void Shadow_FillBox(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t the_char, uint8_t the_attribute_value);
+
+// scroll rows y1-y2 up one row, same as Text_ScrollTextAndAttrRowsUp(): row y1-1 is lost, row y2 is left as it was
+// y1 must be > TERM_BODY_Y1, and y2 <= TERM_BODY_Y2
+// if to_history is true, the lost row is added to the scrollback history
+void Shadow_ScrollUp(uint8_t y1, uint8_t y2, bool to_history);
+
+// scroll rows y1-y2 down one row, same as Text_ScrollTextAndAttrRowsDown(): row y2+1 is lost, row y1 is left as it was
+// y1 must be >= TERM_BODY_Y1, and y2 < TERM_BODY_Y2
+void Shadow_ScrollDown(uint8_t y1, uint8_t y2);
+
+// shift the cells of row y from x to the right edge right by the_count, blanking the cells opened up at x
+// cells pushed past the right edge are lost. the_count must be 1+.
+void Shadow_InsertCells(uint8_t x, uint8_t y, uint8_t the_count, uint8_t the_attribute_value);
+
+// shift the cells of row y right of x+the_count-1 left by the_count, so they start at x, blanking the cells opened up at the right edge
+// cells x to x+the_count-1 are lost. the_count must be 1+.
+void Shadow_DeleteCells(uint8_t x, uint8_t y, uint8_t the_count, uint8_t the_attribute_value);
+
+// load the shadow from VICKY memory, whether or not the shadow screen is enabled, so the terminal body can be put back
+// later with Shadow_Restore(). for things like the scrollback view, that take over the terminal body for a while.
+// not for use between Shadow_Begin() and Shadow_End().
+void Shadow_Save(void);
+
+// redraw the whole terminal body from the shadow. see Shadow_Save().
+void Shadow_Restore(void);
+
+// draw one row of the shadow (0 to TERM_BODY_HEIGHT-1) to VICKY memory at screen row y. see Shadow_Save().
+void Shadow_DrawRowAt(uint8_t the_row, uint8_t y);
+
+
+#endif /* SHADOW_H_ */
@@ -0,0 +1,549 @@
+/*
+ * staging.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+// extended memory ring between the disk and a file transfer, so neither sending nor receiving has to wait on the SD card
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "staging.h"
+#include "general.h"
+#include "memory.h"
+#include "kernel.h"
+#include "dirent.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+// F256 includes
+#include "f256.h"
+
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                           File-scoped Variables                           */
+/*****************************************************************************/
+
+static int			staging_file = -1;
+static bool			staging_writing;			// file was opened with Staging_OpenWrite(): data flows into the ring, then out to disk
+static bool			staging_write_failed;		// a write to disk failed: the file is incomplete
+static bool			staging_at_eof;				// the last read from disk came up short: the whole file has been read
+static uint32_t		staging_start_pos;			// file position of the oldest byte still in the ring
+static uint32_t		staging_read_pos;			// file position of the next byte Staging_Take() hands out (writing: next byte to go to disk)
+static uint32_t		staging_fill_pos;			// file position of the next byte to read from disk (writing: next byte Staging_Put() adds) = end of the data in the ring
+static uint32_t		staging_flush_end;			// writing: file position the disk write under way stops at
+static char			staging_path[FILE_MAX_PATHNAME_SIZE];	// to open the file again, for a seek to before the start of the ring
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+extern uint8_t			zp_bank_num;
+#pragma zpsym ("zp_bank_num");
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// open (or re-open) staging_path, with the ring empty and the position at the start of the file
+bool Staging_Open(void);
+
+// read the next STAGING_READ_CHUNK (or fewer) bytes of the file from disk into the ring, if there is room for them
+// returns false if nothing was read (ring full, end of file, or no file open)
+bool Staging_ReadAhead(void);
+
+// write the next STAGING_WRITE_CHUNK (or fewer) bytes of the ring out to disk
+// unless write_all, only once a whole STAGING_FLUSH_SIZE is waiting (or one is part written)
+// returns false if nothing was written (nothing due, no file open for writing, or the write failed)
+bool Staging_WriteBehind(bool write_all);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// open (or re-open) staging_path, with the ring empty and the position at the start of the file
+bool Staging_Open(void)
+{
+	staging_file = open(staging_path, O_RDONLY);
+	staging_writing = false;
+	staging_at_eof = false;
+	staging_start_pos = 0;
+	staging_read_pos = 0;
+	staging_fill_pos = 0;
+
+	return (staging_file >= 0);
+}
+
+
+// read the next STAGING_READ_CHUNK (or fewer) bytes of the file from disk into the ring, if there is room for them
+// returns false if nothing was read (ring full, end of file, or no file open)
+bool Staging_ReadAhead(void)
+{
+	uint16_t	bank_offset;
+	uint16_t	the_len;
+	int			got;
+	uint8_t		previous_bank;
+
+	// LOGIC:
+	//   the kernel copies the data straight into the ring bank, mapped into the overlay slot for the call: no bounce buffer.
+	//   one kernel read per call keeps each call to a few ms, so callers can slip it in between other work.
+	//   room is whatever hasn't been handed out yet: bytes already taken are kept until overwritten, for Staging_Seek().
+	//   a read stops at the end of a bank, so only one bank needs to be mapped in.
+
+	if (staging_file < 0 || staging_at_eof)
+	{
+		return false;
+	}
+
+	the_len = STAGING_SIZE - (uint16_t)(staging_fill_pos - staging_read_pos);
+
+	if (the_len > STAGING_READ_CHUNK)
+	{
+		the_len = STAGING_READ_CHUNK;
+	}
+
+	bank_offset = (uint16_t)staging_fill_pos & (STAGING_BANK_SIZE - 1);
+
+	if (the_len > STAGING_BANK_SIZE - bank_offset)
+	{
+		the_len = STAGING_BANK_SIZE - bank_offset;
+	}
+
+	if (the_len == 0)
+	{
+		return false;
+	}
+
+	zp_bank_num = STAGING_START_PHYS_BANK_NUM + (((uint16_t)staging_fill_pos & STAGING_MASK) >> STAGING_BANK_SHIFT);
+	previous_bank = Memory_SwapInNewBank(STAGING_SLOT);
+
+	got = read(staging_file, (uint8_t*)(STAGING_CPU_ADDR + bank_offset), the_len);
+
+	zp_bank_num = previous_bank;
+	Memory_SwapInNewBank(STAGING_SLOT);
+
+	if (got < (int)the_len)
+	{
+		staging_at_eof = true;
+	}
+
+	if (got <= 0)
+	{
+		return false;
+	}
+
+	staging_fill_pos += got;
+
+	if (staging_fill_pos - staging_start_pos > STAGING_SIZE)
+	{
+		staging_start_pos = staging_fill_pos - STAGING_SIZE;
+	}
+
+	return true;
+}
+
+
+// write the next STAGING_WRITE_CHUNK (or fewer) bytes of the ring out to disk
+// unless write_all, only once a whole STAGING_FLUSH_SIZE is waiting (or one is part written)
+// returns false if nothing was written (nothing due, no file open for writing, or the write failed)
+bool Staging_WriteBehind(bool write_all)
+{
+	uint16_t	bank_offset;
+	uint16_t	the_len;
+	int			wrote;
+	uint8_t		previous_bank;
+
+	// LOGIC:
+	//   the protocol fills the ring at the front while the back goes to disk, a chunk per call, between received blocks
+	//   data goes out in runs of STAGING_FLUSH_SIZE (one SD cluster), so the card sees whole clusters appended, not
+	//   a dribble of odd-sized writes after every block. the tail end only goes out with write_all (from Staging_Close()).
+	//   as with reading, the bank is mapped in for the call, and the kernel takes the data straight from it
+
+	if (staging_file < 0 || staging_writing == false || staging_write_failed)
+	{
+		return false;
+	}
+
+	the_len = (uint16_t)(staging_fill_pos - staging_read_pos);
+
+	if (write_all == false)
+	{
+		if (staging_read_pos >= staging_flush_end)
+		{
+			if (the_len < STAGING_FLUSH_SIZE)
+			{
+				return false;
+			}
+
+			staging_flush_end = staging_read_pos + STAGING_FLUSH_SIZE;
+		}
+
+		the_len = (uint16_t)(staging_flush_end - staging_read_pos);
+	}
+
+	if (the_len > STAGING_WRITE_CHUNK)
+	{
+		the_len = STAGING_WRITE_CHUNK;
+	}
+
+	bank_offset = (uint16_t)staging_read_pos & (STAGING_BANK_SIZE - 1);
+
+	if (the_len > STAGING_BANK_SIZE - bank_offset)
+	{
+		the_len = STAGING_BANK_SIZE - bank_offset;
+	}
+
+	if (the_len == 0)
+	{
+		return false;
+	}
+
+	zp_bank_num = STAGING_START_PHYS_BANK_NUM + (((uint16_t)staging_read_pos & STAGING_MASK) >> STAGING_BANK_SHIFT);
+	previous_bank = Memory_SwapInNewBank(STAGING_SLOT);
+
+	wrote = write(staging_file, (uint8_t*)(STAGING_CPU_ADDR + bank_offset), the_len);
+
+	zp_bank_num = previous_bank;
+	Memory_SwapInNewBank(STAGING_SLOT);
+
+	if (wrote != (int)the_len)
+	{
+		staging_write_failed = true;
+		return false;
+	}
+
+	staging_read_pos += the_len;
+
+	return true;
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// open the_file_path for reading through the ring. returns false if it can't be opened.
+bool Staging_OpenRead(char* the_file_path)
+{
+	Staging_Close();
+	General_Strlcpy(staging_path, the_file_path, FILE_MAX_PATHNAME_SIZE);
+
+	return Staging_Open();
+}
+
+
+// open the_file_path for writing through the ring: at the end of what's there if append, else replacing it
+// returns false if it can't be opened.
+bool Staging_OpenWrite(char* the_file_path, bool append)
+{
+	Staging_Close();
+
+	staging_file = open(the_file_path, (append ? (O_WRONLY | O_APPEND) : O_WRONLY));
+	staging_writing = true;
+	staging_write_failed = false;
+	staging_read_pos = 0;
+	staging_fill_pos = 0;
+	staging_flush_end = 0;
+
+	return (staging_file >= 0);
+}
+
+
+// close the file opened by Staging_OpenRead() or Staging_OpenWrite(), first writing out whatever is still in the ring
+// returns false if any of the data put in the ring didn't make it to disk. safe to call if no file is open.
+bool Staging_Close(void)
+{
+	bool	success;
+
+	if (staging_file < 0)
+	{
+		return true;
+	}
+
+	while (Staging_WriteBehind(true))
+	{
+		// no-op unless writing
+	}
+
+	success = (staging_writing == false || staging_write_failed == false);
+
+	close(staging_file);
+	staging_file = -1;
+	staging_writing = false;
+
+	return success;
+}
+
+
+// do a moment's background work on the open file: read ahead (file opened for reading) or write behind (for writing)
+// at most one kernel call's worth. call whenever there is time to spare, eg, while waiting on the serial port.
+// returns false if there was nothing to do
+bool Staging_Pump(void)
+{
+	return (staging_writing ? Staging_WriteBehind(false) : Staging_ReadAhead());
+}
+
+
+// add the_len bytes of the_buffer to the end of the file being written. they go to disk later, from Staging_Pump() or Staging_Close()
+// only waits on the disk if it has fallen a whole ring behind. returns false if a write to disk has failed.
+bool Staging_Put(uint8_t* the_buffer, uint16_t the_len)
+{
+	uint16_t	run_len;
+	uint16_t	bank_offset;
+	uint8_t		previous_bank;
+
+	while (the_len > 0)
+	{
+		if (staging_write_failed)
+		{
+			return false;
+		}
+
+		// room is whatever hasn't gone to disk yet. if there is none, the disk has fallen behind: wait on it.
+		run_len = STAGING_SIZE - (uint16_t)(staging_fill_pos - staging_read_pos);
+
+		if (run_len == 0)
+		{
+			Staging_WriteBehind(true);
+			continue;
+		}
+
+		bank_offset = (uint16_t)staging_fill_pos & (STAGING_BANK_SIZE - 1);
+
+		if (run_len > STAGING_BANK_SIZE - bank_offset)
+		{
+			run_len = STAGING_BANK_SIZE - bank_offset;
+		}
+
+		if (run_len > the_len)
+		{
+			run_len = the_len;
+		}
+
+		zp_bank_num = STAGING_START_PHYS_BANK_NUM + (((uint16_t)staging_fill_pos & STAGING_MASK) >> STAGING_BANK_SHIFT);
+		previous_bank = Memory_SwapInNewBank(STAGING_SLOT);
+
+		memcpy((uint8_t*)(STAGING_CPU_ADDR + bank_offset), the_buffer, run_len);
+
+		zp_bank_num = previous_bank;
+		Memory_SwapInNewBank(STAGING_SLOT);
+
+		the_buffer += run_len;
+		staging_fill_pos += run_len;
+		the_len -= run_len;
+	}
+
+	return true;
+}
+
+
+// copy up to max_len bytes of the file, from the current position, out of the ring into the_buffer, and move past them
+// reads from disk first if the ring doesn't hold enough. returns # of bytes copied: less than max_len only at the end of the file
+uint16_t Staging_Take(uint8_t* the_buffer, uint16_t max_len)
+{
+	uint16_t	the_len;
+	uint16_t	run_len;
+	uint16_t	bank_offset;
+	uint16_t	total_copied = 0;
+	uint8_t		previous_bank;
+
+	while (staging_fill_pos - staging_read_pos < max_len && Staging_ReadAhead())
+	{
+		// ring ran low: the caller didn't get a chance to read ahead enough. read now.
+	}
+
+	the_len = (uint16_t)(staging_fill_pos - staging_read_pos);
+
+	if (the_len > max_len)
+	{
+		the_len = max_len;
+	}
+
+	while (the_len > 0)
+	{
+		bank_offset = (uint16_t)staging_read_pos & (STAGING_BANK_SIZE - 1);
+		run_len = STAGING_BANK_SIZE - bank_offset;
+
+		if (run_len > the_len)
+		{
+			run_len = the_len;
+		}
+
+		zp_bank_num = STAGING_START_PHYS_BANK_NUM + (((uint16_t)staging_read_pos & STAGING_MASK) >> STAGING_BANK_SHIFT);
+		previous_bank = Memory_SwapInNewBank(STAGING_SLOT);
+
+		memcpy(the_buffer, (uint8_t*)(STAGING_CPU_ADDR + bank_offset), run_len);
+
+		zp_bank_num = previous_bank;
+		Memory_SwapInNewBank(STAGING_SLOT);
+
+		the_buffer += run_len;
+		staging_read_pos += run_len;
+		the_len -= run_len;
+		total_copied += run_len;
+	}
+
+	return total_copied;
+}
+
+
+// move the current position to the_position. returns false if the file isn't that long.
+bool Staging_Seek(uint32_t the_position)
+{
+	// LOGIC:
+	//   going back a little (a NAKed block, a ZRPOS after line noise) almost always lands in the ring
+	//   further back than the ring reaches, start over: the kernel's seek isn't something we can count on
+	//   going forward (a ZRPOS to resume a partial file) reads and drops what's skipped
+
+	if (the_position < staging_start_pos)
+	{
+		Staging_Close();
+
+		if (Staging_Open() == false)
+		{
+			return false;
+		}
+	}
+
+	while (the_position > staging_fill_pos)
+	{
+		staging_read_pos = staging_fill_pos;
+
+		if (Staging_ReadAhead() == false)
+		{
+			return false;
+		}
+	}
+
+	staging_read_pos = the_position;
+
+	return true;
+}
+
+
+// returns the current position: the file offset of the next byte Staging_Take() will hand out
+uint32_t Staging_GetPosition(void)
+{
+	return staging_read_pos;
+}
+
+
+// returns the length of the_file_path on disk, or STAGING_NO_FILE if it isn't there
+// is_exact comes back false if the kernel couldn't seek, and the length is only good to the next 256 bytes (rounded up)
+// uses the ring as scratch: don't call with a file open for staging
+uint32_t Staging_GetFileLength(char* the_file_path, bool* is_exact)
+{
+	DIR*			the_dir;
+	struct dirent*	the_entry;
+	char*			the_split;
+	char*			the_name;
+	uint16_t		num_blocks = 0;
+	bool			found = false;
+	int				the_file;
+	int				the_len;
+	uint32_t		the_start;
+	uint8_t			previous_bank;
+
+	// LOGIC:
+	//   the kernel has no call that gives a file's length in bytes, and reading a big file through to count them
+	//   takes long enough for a ZMODEM sender waiting on our ZRPOS to give up (~10 s).
+	//   the file's directory entry has its length in 256-byte blocks: look that up, then seek to the last block,
+	//   and read from there to the end to trim it to the byte. at most 2 blocks get read, whatever the file's size.
+	//   if the seek fails (older kernels), or didn't land where asked (2 blocks' worth still isn't the end), settle for the whole blocks.
+
+	*is_exact = false;
+
+	// folder part of the path goes in staging_path ("0:" or "0:dir"): it's free, as no file is open. name is the rest.
+	General_Strlcpy(staging_path, the_file_path, FILE_MAX_PATHNAME_SIZE);
+	the_split = General_PathPart(staging_path);
+	the_name = the_file_path + (the_split - staging_path) + 1;
+
+	if (*the_split == ':')
+	{
+		the_split[1] = '\0';
+	}
+	else
+	{
+		*the_split = '\0';
+	}
+
+	the_dir = Kernel_OpenDir(staging_path);
+
+	if (the_dir == NULL)
+	{
+		return STAGING_NO_FILE;
+	}
+
+	while ((the_entry = Kernel_ReadDir(the_dir)) != NULL)
+	{
+		if (!_DE_ISLBL(the_entry->d_type) && General_Strncasecmp(the_entry->d_name, the_name, FILE_MAX_FILENAME_SIZE) == 0)
+		{
+			num_blocks = the_entry->d_blocks;
+			found = true;
+			break;
+		}
+	}
+
+	Kernel_CloseDir(the_dir);
+
+	if (found == false)
+	{
+		return STAGING_NO_FILE;
+	}
+
+	if (num_blocks == 0)
+	{
+		*is_exact = true;
+		return 0;
+	}
+
+	the_file = open(the_file_path, O_RDONLY);
+
+	if (the_file < 0)
+	{
+		return STAGING_NO_FILE;
+	}
+
+	the_start = (uint32_t)(num_blocks - 1) << 8;
+
+	if (Kernel_Seek(the_file, the_start) == 0)
+	{
+		zp_bank_num = STAGING_START_PHYS_BANK_NUM;
+		previous_bank = Memory_SwapInNewBank(STAGING_SLOT);
+
+		the_len = read(the_file, (uint8_t*)STAGING_CPU_ADDR, STAGING_TAIL_MAX);
+
+		zp_bank_num = previous_bank;
+		Memory_SwapInNewBank(STAGING_SLOT);
+
+		*is_exact = (the_len < STAGING_TAIL_MAX);
+	}
+
+	close(the_file);
+
+	if (*is_exact == false)
+	{
+		return (uint32_t)num_blocks << 8;
+	}
+
+	return the_start + the_len;
+}
@@ -0,0 +1,109 @@
+/*
+ * staging.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+#ifndef STAGING_H_
+#define STAGING_H_
+
+
+
+/* about this class: Staging
+ *
+ * a 32K ring of file data in extended memory (banks STAGING_START_PHYS_BANK_NUM on), between the disk and a file transfer
+ *
+ *** things this class needs to be able to do
+ *
+ * read a file ahead from disk into the ring, one kernel read at a time, whenever the caller has a moment to spare
+ * or the other way round: take received data into the ring at memory speed, and write it out behind the protocol,
+ *   one kernel write at a time, in cluster-sized runs, whenever the caller has a moment to spare
+ * hand the file out in order, in whatever size pieces the protocol wants, only going to disk if the ring runs dry
+ * go back to any earlier position the other side asks for (ZMODEM ZRPOS, a NAKed block): from the ring if it's still
+ *   there, otherwise by reading the file again from the start. skip ahead the same way.
+ * work out a file's length from its directory entry (blocks), and a seek to the last block for the exact byte count
+ *
+ *** things objects of this class have
+ *
+ * the open file, and 3 file positions: oldest byte still in the ring, next byte to hand out, next byte to read from disk
+ *   (writing: next byte to write to disk, and next byte to take in)
+ * a ring position is just the file position, masked, so the ring never has to be re-aligned
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "app.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+#define STAGING_READ_CHUNK			255			// most bytes one kernel File.Read call delivers: Staging_Pump() reads this much
+#define STAGING_WRITE_CHUNK			254			// most bytes write() hands the kernel in one File.Write call: Staging_Pump() writes this much
+#define STAGING_FLUSH_SIZE			4096		// received data goes to disk in runs of this much: one cluster on a typical SD card
+#define STAGING_NO_FILE				0xFFFFFFFF	// Staging_GetFileLength(): file not found
+#define STAGING_TAIL_MAX			512			// Staging_GetFileLength(): reading on past this many bytes after the seek means it didn't land
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// open the_file_path for reading through the ring. returns false if it can't be opened.
+bool Staging_OpenRead(char* the_file_path);
+
+// open the_file_path for writing through the ring: at the end of what's there if append, else replacing it
+// returns false if it can't be opened.
+bool Staging_OpenWrite(char* the_file_path, bool append);
+
+// close the file opened by Staging_OpenRead() or Staging_OpenWrite(), first writing out whatever is still in the ring
+// returns false if any of the data put in the ring didn't make it to disk. safe to call if no file is open.
+bool Staging_Close(void);
+
+// do a moment's background work on the open file: read ahead (file opened for reading) or write behind (for writing)
+// at most one kernel call's worth. call whenever there is time to spare, eg, while waiting on the serial port.
+// returns false if there was nothing to do
+bool Staging_Pump(void);
+
+// add the_len bytes of the_buffer to the end of the file being written. they go to disk later, from Staging_Pump() or Staging_Close()
+// only waits on the disk if it has fallen a whole ring behind. returns false if a write to disk has failed.
+bool Staging_Put(uint8_t* the_buffer, uint16_t the_len);
+
+// copy up to max_len bytes of the file, from the current position, out of the ring into the_buffer, and move past them
+// reads from disk first if the ring doesn't hold enough. returns # of bytes copied: less than max_len only at the end of the file
+uint16_t Staging_Take(uint8_t* the_buffer, uint16_t max_len);
+
+// move the current position to the_position. returns false if the file isn't that long.
+bool Staging_Seek(uint32_t the_position);
+
+// returns the current position: the file offset of the next byte Staging_Take() will hand out
+uint32_t Staging_GetPosition(void);
+
+// returns the length of the_file_path on disk, or STAGING_NO_FILE if it isn't there
+// is_exact comes back false if the kernel couldn't seek, and the length is only good to the next 256 bytes (rounded up)
+// uses the ring as scratch: don't call with a file open for staging
+uint32_t Staging_GetFileLength(char* the_file_path, bool* is_exact);
+
+
+#endif /* STAGING_H_ */
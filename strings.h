@@ -58,5 +58,36 @@
 #define ID_STR_MACHINE_JR 56
 #define ID_STR_MACHINE_K 57
 #define ID_STR_MACHINE_UNKNOWN 58
-#define NUM_STRINGS 59
-#define TOTAL_STRING_BYTES 1350
+#define ID_STR_MSG_FLOW_CONTROL_NONE 59
+#define ID_STR_MSG_FLOW_CONTROL_RTS_CTS 60
+#define ID_STR_MSG_FLOW_CONTROL_XON_XOFF 61
+#define ID_STR_MSG_SCROLLBACK_EMPTY 62
+#define ID_STR_MSG_SCROLLBACK_VIEW 63
+#define ID_STR_MSG_SCROLLBACK_SEARCH 64
+#define ID_STR_MSG_SCROLLBACK_NOT_FOUND 65
+#define ID_STR_LBL_SCROLLBACK_FIND 66
+#define ID_STR_DLG_XMODEM_RECEIVE_TITLE 67
+#define ID_STR_DLG_RECEIVE_FILE_BODY 68
+#define ID_STR_MSG_XMODEM_WAITING 69
+#define ID_STR_MSG_XFER_COMPLETE 70
+#define ID_STR_MSG_XFER_CANCELED 71
+#define ID_STR_MSG_XFER_REMOTE_CANCEL 72
+#define ID_STR_MSG_XFER_FAILED 73
+#define ID_STR_MSG_YMODEM_WAITING 74
+#define ID_STR_MSG_YMODEM_FILE 75
+#define ID_STR_MSG_YMODEM_DONE 76
+#define ID_STR_MSG_ZMODEM_WAITING 77
+#define ID_STR_MSG_ZMODEM_RESUME 78
+#define ID_STR_MSG_ZMODEM_SKIP 79
+#define ID_STR_DLG_SEND_TITLE 80
+#define ID_STR_DLG_SEND_FILE_BODY 81
+#define ID_STR_DLG_SEND_PROTOCOL_BODY 82
+#define ID_STR_MSG_XMODEM_SEND_WAITING 83
+#define ID_STR_MSG_YMODEM_SEND_WAITING 84
+#define ID_STR_MSG_ZMODEM_SEND_WAITING 85
+#define ID_STR_MSG_SENDING_FILE 86
+#define ID_STR_MSG_XFER_SENT 87
+#define ID_STR_MSG_ZMODEM_SEND_SKIPPED 88
+#define ID_STR_MSG_SENDING_FILE_NO_SIZE 89
+#define NUM_STRINGS 90
+#define TOTAL_STRING_BYTES 2461
@@ -828,6 +828,27 @@ bool Sys_UpdateRTC(char* datetime_from_user)
 }
 
 
+// read the seconds register of the real time clock (BCD, 0x00-0x59)
+// meant for timeouts: watch it for changes to count off (roughly) whole seconds
+uint8_t Sys_GetRTCSeconds(void)
+{
+	uint8_t		the_seconds;
+	
+	Sys_SwapIOPage(VICKY_IO_PAGE_REGISTERS);
+	
+	// stop RTC from updating external registers while reading. Required!
+	R8(RTC_CONTROL) = MASK_RTC_CTRL_UTI;
+	the_seconds = R8(RTC_SECONDS);
+	
+	// reset timer control to daylight savings, 24 hr model, and not battery saving mode, and clear UTI
+	R8(RTC_CONTROL) = (MASK_RTC_CTRL_DSE | MASK_RTC_CTRL_12_24 | MASK_RTC_CTRL_STOP);
+	
+	Sys_RestoreIOPage();
+	
+	return the_seconds;
+}
+
+
 
 
 
@@ -231,6 +231,10 @@ void Sys_RestoreIOPage(void);
 // returns true if format was acceptable (and thus update of RTC has been performed).
 bool Sys_UpdateRTC(char* datetime_from_user);
 
+// read the seconds register of the real time clock (BCD, 0x00-0x59)
+// meant for timeouts: watch it for changes to count off (roughly) whole seconds
+uint8_t Sys_GetRTCSeconds(void);
+
 
 
 // **** Debug functions *****
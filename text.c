@@ -20,6 +20,7 @@
 #include "general.h"
 #include "keyboard.h"
 #include "text.h"
+#include "textfast.h"
 #include "sys.h"
 
 // C includes
@@ -51,14 +52,33 @@
 /*                          File-scoped Variables                            */
 /*****************************************************************************/
 
-static uint8_t		text_x;
-static uint8_t		text_y;
-static uint8_t*		text_char_addr;
 
 /*****************************************************************************/
 /*                             Global Variables                              */
 /*****************************************************************************/
 
+// current text position. not static, as textfast.asm also reads/writes these. nothing outside the text library should touch them.
+uint8_t				text_x;
+uint8_t				text_y;
+uint8_t*			text_char_addr;
+bool				text_cursor_deferred;	// if true, cursor moves only mark text_cursor_dirty; VICKY is updated in Text_SyncCursor()
+bool				text_cursor_dirty;
+
+extern uint8_t*			zp_to_addr;
+extern uint8_t*			zp_from_addr;
+extern uint16_t			zp_copy_len;
+extern uint8_t			zp_x;
+extern uint8_t			zp_y;
+extern uint8_t			zp_temp_1;
+extern uint8_t			zp_other_byte;
+#pragma zpsym ("zp_to_addr");
+#pragma zpsym ("zp_from_addr");
+#pragma zpsym ("zp_copy_len");
+#pragma zpsym ("zp_x");
+#pragma zpsym ("zp_y");
+#pragma zpsym ("zp_temp_1");
+#pragma zpsym ("zp_other_byte");
+
 extern System*			global_system;
 
 
@@ -147,30 +167,22 @@ bool Text_FillMemory(bool for_attr, uint8_t the_fill)
 //! @return	Returns false on any error/invalid input.
 bool Text_FillMemoryBoxBoth(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t the_char, uint8_t the_attribute_value)
 {
-	uint8_t		max_row;
-
 	// LOGIC: 
 	//   On F256jr, the write len and write locs are same for char and attr memory, difference is IO page 2 or 3
+	//   textfast.asm does the row loops, with one IO page switch per page
 
 	// set up initial loc
 	Text_SetXY(x,y);
 	
-	max_row = (y + height) - 1; // we are passing '1' for a single h row
-	
-	for (; y <= max_row; y++)
-	{
-		Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
-		memset(text_char_addr, the_attribute_value, width);
-		Sys_SwapIOPage(VICKY_IO_PAGE_CHAR_MEM);
-		memset(text_char_addr, the_char, width);
-
-		text_char_addr += SCREEN_NUM_COLS;
-	}
-
-	Sys_RestoreIOPage();
+	zp_to_addr = text_char_addr;
+	zp_x = width;
+	zp_y = height;
+	zp_other_byte = the_char;
+	zp_temp_1 = the_attribute_value;
+	TextFast_FillBoxBoth();
 
 	// reset current vram loc to match x,y
-	Text_SetXY(x,y);		
+	Text_SetXY(x, y + height);		
 
 	return true;
 }
@@ -187,35 +199,29 @@ bool Text_FillMemoryBoxBoth(uint8_t x, uint8_t y, uint8_t width, uint8_t height,
 //! @return	Returns false on any error/invalid input.
 bool Text_FillMemoryBox(uint8_t x, uint8_t y, uint8_t width, uint8_t height, bool for_attr, uint8_t the_fill)
 {
-	uint8_t		max_row;
-
 	// LOGIC: 
 	//   On F256jr, the write len and write locs are same for char and attr memory, difference is IO page 2 or 3
+	//   textfast.asm does the row loops
 
 	// set up initial loc
 	Text_SetXY(x,y);
 
+	zp_to_addr = text_char_addr;
+	zp_x = width;
+	zp_y = height;
+	zp_other_byte = the_fill;
+
 	if (for_attr)
 	{
-		Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
+		TextFast_FillBox(VICKY_IO_PAGE_ATTR_MEM);
 	}
 	else
 	{
-		Sys_SwapIOPage(VICKY_IO_PAGE_CHAR_MEM);
-	}
-
-	max_row = (y + height) - 1; // we are passing '1' for a single h row
-	
-	for (; y <= max_row; y++)
-	{
-		memset(text_char_addr, the_fill, width);
-		text_char_addr += SCREEN_NUM_COLS;
+		TextFast_FillBox(VICKY_IO_PAGE_CHAR_MEM);
 	}
 		
-	Sys_RestoreIOPage();
-		
 	// reset current vram loc to match x,y
-	Text_SetXY(x,y);		
+	Text_SetXY(x, y + height);		
 			
 	return true;
 }
@@ -233,132 +239,88 @@ bool Text_FillMemoryBox(uint8_t x, uint8_t y, uint8_t width, uint8_t height, boo
 // **** Block copy functions ****
 
 
-// //! Copies characters and attributes from the left, to the right, for the passed length, backfilling with the char and attr passed
-// //!   Shift never extends beyond the current row of text. 
-// //! @param	working_buffer - valid pointer to a block of memory at least SCREEN_NUM_COLS in size, to act as a temporary line buffer for the operation. 
-// //! @param	x - the starting horizontal position, between 0 and the screen's text_cols_vis_ - 1
-// //! @param	y - the starting vertical position, between 0 and the screen's text_rows_vis_ - 1
-// //! @param	shift_count - the number of character positions text will be shifted. eg, '1' will shift everything to the right of x by 1 character.
-// //! @param	backfill_char - the character to place in the space freed up by copy. eg, if you shift 10 chars at positions 60-69 to 70-79, this char will be used to fill the slots from 60-69. 
-// //! @param	backfill_fore_color - foreground color that will be applied to the space opened up by the copy
-// //! @param	backfill_back_color - background color that will be applied to the space opened up by the copy
-// //! @return	Returns false on any error/invalid input.
-// bool Text_ShiftTextAndAttrRight(uint8_t* working_buffer, uint8_t x, uint8_t y, uint8_t shift_count, uint8_t backfill_char, uint8_t backfill_fore_color, uint8_t backfill_back_color)
-// {
-// 	uint8_t*		vram_to_loc;
-// 	uint8_t*		vram_from_loc;
-// 	int16_t			initial_offset;
-// 	uint8_t			the_length;
-// 	uint8_t			the_attribute_value;
-// 	
-// 	// calculate attribute value from passed fore and back colors
-// 	// LOGIC: text mode only supports 16 colors. lower 4 bits are back, upper 4 bits are foreground
-// 	the_attribute_value = ((backfill_fore_color << 4) | backfill_back_color);
-// 
-// 	// LOGIC: 
-// 	//   On F256jr, the write len and write locs are same for char and attr memory, difference is IO page 2 or 3
-// 
-// 	// check for valid inputs to ensure we are only adjusting 1 valid line worth of text
-// 	if (y > SCREEN_LAST_ROW)
-// 	{
-// 		return false;
-// 	}
-// 	if (x > SCREEN_LAST_COL)	// allow position 79 (eg) to be shifted off the screen
-// 	{
-// 		return false;
-// 	}
-// 	if ((x + shift_count) > SCREEN_LAST_COL)
-// 	{
-// 		// can't shift more right than the end of the row
-// 		shift_count = (SCREEN_LAST_COL - x) + 1;
-// 	}
-// 		
-// 	// get initial read/write locs - copy from right most character, not left-most.
-// 	the_length = (SCREEN_NUM_COLS - x) - shift_count;	// if x=70, and want to shift 5 chars to right, len can't be 10, len must be 5 or we'll overwrite next line
-// 	initial_offset = (SCREEN_NUM_COLS * y) + x;
-// 
-// 	// copy text
-// 	vram_from_loc = (uint8_t*)VICKY_TEXT_CHAR_RAM + initial_offset;
-// 	vram_to_loc = vram_from_loc + shift_count;
-// 	memcpy(working_buffer, vram_from_loc, the_length);
-// 	memcpy(vram_to_loc, working_buffer, the_length);
-// 	// backfill text
-// 	memset(vram_from_loc, backfill_char, shift_count);
-// 
-// 	
-// 	// copy attr
-// 	vram_from_loc = (uint8_t*)VICKY_TEXT_ATTR_RAM + initial_offset;
-// 	vram_to_loc = vram_from_loc + shift_count;
-// 	memcpy(working_buffer, vram_from_loc, the_length);
-// 	memcpy(vram_to_loc, working_buffer, the_length);
-// 	// backfill attr
-// 	memset(vram_from_loc, the_attribute_value, shift_count);
-// 	
-// 	return true;
-// }
+//! Copies characters and attributes from the left, to the right, for the passed length, backfilling with the char and attr passed
+//!   Shift never extends beyond the current row of text. 
+//! @param	x - the starting horizontal position, between 0 and the screen's text_cols_vis_ - 1
+//! @param	y - the starting vertical position, between 0 and the screen's text_rows_vis_ - 1
+//! @param	shift_count - the number of character positions text will be shifted. eg, '1' will shift everything to the right of x by 1 character.
+//! @param	backfill_char - the character to place in the space freed up by copy. eg, if you shift 10 chars at positions 60-69 to 70-79, this char will be used to fill the slots from 60-69. 
+//! @param	backfill_fore_color - foreground color that will be applied to the space opened up by the copy
+//! @param	backfill_back_color - background color that will be applied to the space opened up by the copy
+//! @return	Returns false on any error/invalid input.
+bool Text_ShiftTextAndAttrRight(uint8_t x, uint8_t y, uint8_t shift_count, uint8_t backfill_char, uint8_t backfill_fore_color, uint8_t backfill_back_color)
+{
+	uint8_t			the_length;
+	
+	// LOGIC: 
+	//   On F256jr, the write len and write locs are same for char and attr memory, difference is IO page 2 or 3
+	//   the run moves to higher addresses, so textfast.asm copies it from the right end first: no line buffer needed.
 
+	// check for valid inputs to ensure we are only adjusting 1 valid line worth of text
+	if (y > SCREEN_LAST_ROW)
+	{
+		return false;
+	}
+	if (x > SCREEN_LAST_COL || shift_count == 0)
+	{
+		return false;
+	}
+	if ((x + shift_count) > SCREEN_LAST_COL)
+	{
+		// can't shift more right than the end of the row: everything from x on is just backfilled
+		shift_count = (SCREEN_LAST_COL - x) + 1;
+	}
+	
+	the_length = (SCREEN_NUM_COLS - x) - shift_count;	// if x=70, and want to shift 5 chars to right, len can't be 10, len must be 5 or we'll overwrite next line
+	
+	if (the_length > 0)
+	{
+		zp_from_addr = TEXT_ROW_ADDR(y) + x;
+		zp_to_addr = zp_from_addr + shift_count;
+		zp_copy_len = the_length;
+		TextFast_CopyRowsDown();
+	}
+	
+	return Text_FillBox(x, y, x + shift_count - 1, y, backfill_char, backfill_fore_color, backfill_back_color);
+}
 
-// //! Copies characters and attributes from the right, to the left, for the passed length, backfilling with the char and attr passed
-// //!   Shift never extends beyond the current row of text. 
-// //! @param	x - the starting horizontal position, between 0 and the screen's text_cols_vis_ - 1
-// //! @param	y - the starting vertical position, between 0 and the screen's text_rows_vis_ - 1
-// //! @param	shift_count - the number of character positions text will be shifted. eg, '1' will shift everything to the left of x by 1 character.
-// //! @param	backfill_char - the character to place in the space freed up by copy. eg, if you shift 10 chars at positions 70-79 to 60-69, this char will be used to fill the slots from 70-79. 
-// //! @param	backfill_fore_color - foreground color that will be applied to the space opened up by the copy
-// //! @param	backfill_back_color - background color that will be applied to the space opened up by the copy
-// //! @return	Returns false on any error/invalid input.
-// bool Text_ShiftTextAndAttrLeft(uint8_t x, uint8_t y, uint8_t shift_count, uint8_t backfill_char, uint8_t backfill_fore_color, uint8_t backfill_back_color)
-// {
-// 	uint8_t*		vram_to_loc;
-// 	uint8_t*		vram_from_loc;
-// 	int16_t			initial_offset;
-// 	uint8_t			the_length;
-// 	uint8_t			the_attribute_value;
-// 
-// 	// calculate attribute value from passed fore and back colors
-// 	// LOGIC: text mode only supports 16 colors. lower 4 bits are back, upper 4 bits are foreground
-// 	the_attribute_value = ((backfill_fore_color << 4) | backfill_back_color);
-// 
-// 	// LOGIC: 
-// 	//   On F256jr, the write len and write locs are same for char and attr memory, difference is IO page 2 or 3
-// 
-// 	// check for valid inputs to ensure we are only adjusting 1 valid line worth of text
-// 	if (y > SCREEN_LAST_ROW)
-// 	{
-// 		return false;
-// 	}
-// 	if (x == 0 || x > SCREEN_LAST_COL)
-// 	{
-// 		return false;
-// 	}
-// 	if (x < shift_count)
-// 	{
-// 		// can't shift more left than the start of the row
-// 		shift_count = x;
-// 	}
-// 		
-// 	// get initial read/write locs
-// 	the_length = SCREEN_NUM_COLS - x;
-// 	initial_offset = (SCREEN_NUM_COLS * y) + x;
-// 
-// 	// copy text
-// 	vram_from_loc = (uint8_t*)VICKY_TEXT_CHAR_RAM + initial_offset;
-// 	vram_to_loc = vram_from_loc - shift_count;	
-// 	memcpy(vram_to_loc, vram_from_loc, the_length);
-// 	// backfill text
-// 	vram_from_loc += (the_length - 1);
-// 	memset(vram_from_loc, backfill_char, shift_count);
-// 	
-// 	// copy attr
-// 	vram_from_loc = (uint8_t*)VICKY_TEXT_ATTR_RAM + initial_offset;
-// 	vram_to_loc = vram_from_loc - shift_count;
-// 	memcpy(vram_to_loc, vram_from_loc, the_length);
-// 	// backfill attr
-// 	vram_from_loc += (the_length - 1);
-// 	memset(vram_from_loc, the_attribute_value, shift_count);
-// 	
-// 	return true;
-// }
+
+//! Copies characters and attributes from the right, to the left, for the passed length, backfilling with the char and attr passed
+//!   Shift never extends beyond the current row of text. 
+//! @param	x - the starting horizontal position, between 0 and the screen's text_cols_vis_ - 1
+//! @param	y - the starting vertical position, between 0 and the screen's text_rows_vis_ - 1
+//! @param	shift_count - the number of character positions text will be shifted. eg, '1' will shift everything to the left of x by 1 character.
+//! @param	backfill_char - the character to place in the space freed up by copy. eg, if you shift 10 chars at positions 70-79 to 60-69, this char will be used to fill the slots from 70-79. 
+//! @param	backfill_fore_color - foreground color that will be applied to the space opened up by the copy
+//! @param	backfill_back_color - background color that will be applied to the space opened up by the copy
+//! @return	Returns false on any error/invalid input.
+bool Text_ShiftTextAndAttrLeft(uint8_t x, uint8_t y, uint8_t shift_count, uint8_t backfill_char, uint8_t backfill_fore_color, uint8_t backfill_back_color)
+{
+	// LOGIC: 
+	//   On F256jr, the write len and write locs are same for char and attr memory, difference is IO page 2 or 3
+
+	// check for valid inputs to ensure we are only adjusting 1 valid line worth of text
+	if (y > SCREEN_LAST_ROW)
+	{
+		return false;
+	}
+	if (x == 0 || x > SCREEN_LAST_COL || shift_count == 0)
+	{
+		return false;
+	}
+	if (x < shift_count)
+	{
+		// can't shift more left than the start of the row
+		shift_count = x;
+	}
+		
+	zp_from_addr = TEXT_ROW_ADDR(y) + x;
+	zp_to_addr = zp_from_addr - shift_count;
+	zp_copy_len = SCREEN_NUM_COLS - x;
+	TextFast_CopyRowsUp();
+	
+	return Text_FillBox(SCREEN_NUM_COLS - shift_count, y, SCREEN_LAST_COL, y, backfill_char, backfill_fore_color, backfill_back_color);
+}
 
 
 //! scrolls the text and attribute memory up ONE row.
@@ -368,14 +330,11 @@ bool Text_FillMemoryBox(uint8_t x, uint8_t y, uint8_t width, uint8_t height, boo
 //! @return	Returns false on any error/invalid input.
 bool Text_ScrollTextAndAttrRowsUp(uint8_t y1, uint8_t y2)
 {
-	uint8_t*		vram_to_loc;
-	uint8_t*		vram_from_loc;
-	int16_t			initial_offset;
-	uint8_t			num_rows;
-	uint8_t			i;
-
 	// LOGIC: 
 	//   On F256jr, the write len and write locs are same for char and attr memory, difference is IO page 2 or 3
+	//   textfast.asm does the copy, a column at a time through an unrolled run of rows, with one IO page swap per page.
+	//   The VICKY DMA engine can't be used for this: text char/attr memory only exists in the IO space, not on the
+	//     system bus DMA works against. (see note in memory.asm)
 
 	// adjust the x, y, x2, y2, so that we are never trying to copy out of the physical screen box
 	if (y1 < 1)
@@ -395,88 +354,43 @@ bool Text_ScrollTextAndAttrRowsUp(uint8_t y1, uint8_t y2)
 		y2 = SCREEN_LAST_ROW;
 	}
 		
-	// get initial read/write locs
-	initial_offset = (SCREEN_NUM_COLS * y1);
-	num_rows = y2 - y1 + 1;
-
-	vram_from_loc = (uint8_t*)SCREEN_TEXT_MEMORY_LOC + initial_offset;
-	vram_to_loc = vram_from_loc - SCREEN_NUM_COLS;
+	zp_x = y1;
+	zp_y = y2;
 	
-	for (i = 0; i < num_rows; i++)
-	{
-		Sys_SwapIOPage(VICKY_IO_PAGE_CHAR_MEM);
-		memcpy(vram_to_loc, vram_from_loc, SCREEN_NUM_COLS);
-		Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
-		memcpy(vram_to_loc, vram_from_loc, SCREEN_NUM_COLS);
-		
-		vram_to_loc = vram_from_loc;
-		vram_from_loc += SCREEN_NUM_COLS;
-	}
-		
-	Sys_RestoreIOPage();
+	TextFast_ScrollRowsUp();
 
 	return true;
 }
 
 
-// //! scrolls the text and attribute memory down ONE row.
-// //!   e.g, row 59 is lost. row 58 becomes row 59, row 0 becomes row 1, row 0 is cleared.
-// //! @param	y1 - the first row to scroll down
-// //! @param	y2 - the last row to scroll down. y2+1 is overwritten, y2+2 and beyond are left as is.
-// //! @return	Returns false on any error/invalid input.
-// bool Text_ScrollTextAndAttrRowsDown(uint8_t y1, uint8_t y2)
-// {
-// 	uint8_t*		vram_to_loc;
-// 	uint8_t*		vram_from_loc;
-// 	int16_t			initial_offset;
-// 	uint8_t			num_rows;
-// 	uint8_t			i;
-// 
-// 	// LOGIC: 
-// 	//   On F256jr, the write len and write locs are same for char and attr memory, difference is IO page 2 or 3
-// 
-// 	// adjust the x, y, x2, y2, so that we are never trying to copy out of the physical screen box
-// 	if (y2 == SCREEN_LAST_ROW)
-// 	{
-// 		y2 = SCREEN_LAST_ROW - 1;	// can't scroll row 59 anywhere useful.
-// 	}
-// 	else if (y2 < 1)
-// 	{
-// 		y2 = 1;
-// 	}
-// 	if (y2 < y1)
-// 	{
-// 		y2 = y1; // ok to scroll 1 row, so this is compromise for bad data.
-// 	}
-// 		
-// 	// get initial read/write locs
-// 	initial_offset = (SCREEN_NUM_COLS * y2);
-// 	num_rows = y2 - y1 + 1;
-// 
-// 	vram_from_loc = (uint8_t*)VICKY_TEXT_CHAR_RAM + initial_offset;
-// 	vram_to_loc = vram_from_loc + SCREEN_NUM_COLS;
-// 	
-// 	for (i = 0; i < num_rows; i++)
-// 	{
-// 		memcpy(vram_to_loc, vram_from_loc, SCREEN_NUM_COLS);
-// 		
-// 		vram_to_loc = vram_from_loc;
-// 		vram_from_loc -= SCREEN_NUM_COLS;
-// 	}
-// 	
-// 	vram_from_loc = (uint8_t*)VICKY_TEXT_ATTR_RAM + initial_offset;
-// 	vram_to_loc = vram_from_loc + SCREEN_NUM_COLS;
-// 
-// 	for (i = 0; i < num_rows; i++)
-// 	{
-// 		memcpy(vram_to_loc, vram_from_loc, SCREEN_NUM_COLS);
-// 		
-// 		vram_to_loc = vram_from_loc;
-// 		vram_from_loc -= SCREEN_NUM_COLS;
-// 	}
-// 	
-// 	return true;
-// }
+//! scrolls the text and attribute memory down ONE row.
+//!   e.g, row 59 is lost. row 58 becomes row 59, row 0 becomes row 1, row 0 is cleared.
+//! @param	y1 - the first row to scroll down
+//! @param	y2 - the last row to scroll down. y2+1 is overwritten, y2+2 and beyond are left as is.
+//! @return	Returns false on any error/invalid input.
+bool Text_ScrollTextAndAttrRowsDown(uint8_t y1, uint8_t y2)
+{
+	// LOGIC: 
+	//   same approach as Text_ScrollTextAndAttrRowsUp(), but the band moves toward higher addresses,
+	//     so textfast.asm copies it from the bottom row up, so no byte is overwritten before it has been copied.
+
+	// adjust the x, y, x2, y2, so that we are never trying to copy out of the physical screen box
+	if (y2 >= SCREEN_LAST_ROW)
+	{
+		y2 = SCREEN_LAST_ROW - 1;	// can't scroll row 59 anywhere useful.
+	}
+	if (y1 > y2)
+	{
+		y1 = y2; // ok to scroll 1 row, so this is compromise for bad data.
+	}
+		
+	zp_x = y1;
+	zp_y = y2;
+	
+	TextFast_ScrollRowsDown();
+	
+	return true;
+}
 
 
 // //! Copy a linear run of text or attr to or from a linear memory buffer.
@@ -746,6 +660,22 @@ bool Text_FillBox(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t the_ch
 }
 
 
+//! Fill character and attribute memory for a specific box area, using an attribute byte the caller has already built
+//! @param	x1 - the leftmost horizontal position, between 0 and the screen's text_cols_vis_ - 1
+//! @param	y1 - the uppermost vertical position, between 0 and the screen's text_rows_vis_ - 1
+//! @param	x2 - the rightmost horizontal position, between 0 and the screen's text_cols_vis_ - 1
+//! @param	y2 - the lowermost vertical position, between 0 and the screen's text_rows_vis_ - 1
+//! @param	the_char - the character to be used for the fill operation
+//! @param	the_attribute_value - a 1-byte attribute code (foreground in high nibble, background in low nibble)
+//! @return	Returns false on any error/invalid input.
+bool Text_FillBoxCharAndAttr(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t the_char, uint8_t the_attribute_value)
+{
+ 	// add 1 to H line len, because dx becomes width, and if width = 0, then memset gets 0, and nothing happens.
+	// same for dy, as we account for that in the next function called
+	return Text_FillMemoryBoxBoth(x1, y1, x2 - x1 + 1, y2 - y1 + 1, the_char, the_attribute_value);
+}
+
+
 // //! Fill character memory for a specific box area
 // //! @param	x1 - the leftmost horizontal position, between 0 and the screen's text_cols_vis_ - 1
 // //! @param	y1 - the uppermost vertical position, between 0 and the screen's text_rows_vis_ - 1
@@ -815,41 +745,15 @@ bool Text_FillBoxAttrOnly(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_
 //! @return	Returns false on any error/invalid input.
 bool Text_InvertBox(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2)
 {
-	uint8_t			the_attribute_value;
-	uint8_t			the_inversed_value;
-	uint8_t			the_col;
-	uint8_t			skip_len;
-	uint8_t			back_nibble;
-	uint8_t			fore_nibble;
-	uint8_t*		the_write_loc;
-	
 	// get initial read/write loc
 	Text_SetXY(x1,y1);
-	the_write_loc = text_char_addr;
 	
-	// amount of cells to skip past once we have written the specified line len
-	skip_len = SCREEN_NUM_COLS - (x2 - x1) - 1;
-
-	Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
-	
-	for (; y1 <= y2; y1++)
-	{
-		for (the_col = x1; the_col <= x2; the_col++)
-		{
-			the_attribute_value = (unsigned char)*text_char_addr;
-			
-			// LOGIC: text mode only supports 16 colors. lower 4 bits are back, upper 4 bits are foreground
-			back_nibble = ((the_attribute_value & 0xF0) >> 4);
-			fore_nibble = ((the_attribute_value & 0x0F) << 4);
-			the_inversed_value = (fore_nibble | back_nibble);
-			
-			*the_write_loc++ = the_inversed_value;
-		}
-
-		the_write_loc += skip_len;
-	}
-		
-	Sys_RestoreIOPage();
+	// LOGIC: text mode only supports 16 colors. lower 4 bits are back, upper 4 bits are foreground
+	//   textfast.asm swaps the nibbles of each attribute byte in place
+	zp_to_addr = text_char_addr;
+	zp_x = x2 - x1 + 1;
+	zp_y = y2 - y1 + 1;
+	TextFast_InvertBox();
 	
 	// note: for this function, we will not update the next write VRAM address to the point after the lower right corner.
 
@@ -868,8 +772,6 @@ bool Text_InvertBox(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2)
 //! @param	y - the vertical position, between 0 and the screen's text_rows_vis_ - 1
 void Text_SetXY(uint8_t x, uint8_t y)
 {
-	uint16_t	initial_offset;
-	
 	// LOGIC:
 	//   For plotting the VRAM, VICKY uses the full width, regardless of borders. 
 	//   So even if only 72 are showing, the screen is arranged from 0-71 for row 1, then 80-151 for row 2, etc. 
@@ -878,13 +780,19 @@ void Text_SetXY(uint8_t x, uint8_t y)
 	//   the file-scoped current x/y are always set when this function is called, regardless if for attr or char
 	//   the file-scoped current memory address is also always set, but only ever points to the char memory, not attr memory. 
 	
-	initial_offset = (SCREEN_NUM_COLS * y) + x;
+	//   row start addresses come from a table, so this is two table loads and an add, not a 16-bit multiply
 	
 	// save the new current address, x, y position, and also tell VICKY where the cursor should be
-	text_char_addr = (uint8_t*)SCREEN_TEXT_MEMORY_LOC + initial_offset;
+	text_char_addr = TEXT_ROW_ADDR(y) + x;
 	text_x = x;
 	text_y = y;
 
+	if (text_cursor_deferred)
+	{
+		text_cursor_dirty = true;
+		return;
+	}
+	
 	Sys_SwapIOPage(VICKY_IO_PAGE_REGISTERS);
 	R8(VICKY_TEXT_X_POS) = text_x;
 	R8(VICKY_TEXT_Y_POS) = text_y;
@@ -908,6 +816,39 @@ uint8_t Text_GetY(void)
 }
 
 
+//! Turn deferred cursor updates on or off.
+//! While on, the text engine tracks the cursor in RAM only, and VICKY's cursor registers are written by Text_SyncCursor().
+//! Turning it off syncs the cursor right away.
+//! @param	defer_it - true to defer VICKY cursor register writes, false to write them as the cursor moves (the default)
+void Text_DeferCursorUpdates(bool defer_it)
+{
+	text_cursor_deferred = defer_it;
+	
+	if (defer_it == false)
+	{
+		Text_SyncCursor();
+	}
+}
+
+
+//! Push the text engine's cursor position to VICKY, if it has moved since the last push.
+//! Only needed when deferred cursor updates are on.
+void Text_SyncCursor(void)
+{
+	if (text_cursor_dirty == false)
+	{
+		return;
+	}
+	
+	text_cursor_dirty = false;
+	
+	Sys_SwapIOPage(VICKY_IO_PAGE_REGISTERS);
+	R8(VICKY_TEXT_X_POS) = text_x;
+	R8(VICKY_TEXT_Y_POS) = text_y;
+	Sys_RestoreIOPage();
+}
+
+
 // **** Set char/attr functions *****
 
 // NOTE: all functions from here lower that pass an x/y will update the text_x/text_y parameters.
@@ -1108,40 +1049,13 @@ bool Text_SetColor(uint8_t fore_color, uint8_t back_color)
 //! @return	Returns false on any error/invalid input.
 bool Text_SetCharAndColor(uint8_t the_char, uint8_t fore_color, uint8_t back_color)
 {
-	uint8_t			the_attribute_value;
-			
 	// calculate attribute value from passed fore and back colors
 	// LOGIC: text mode only supports 16 colors. lower 4 bits are back, upper 4 bits are foreground
-	the_attribute_value = ((fore_color << 4) | back_color);
-
-	Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
-	*text_char_addr = the_attribute_value;
-	Sys_RestoreIOPage();
-
-	Sys_SwapIOPage(VICKY_IO_PAGE_CHAR_MEM);
-	*text_char_addr = the_char;
-	Sys_RestoreIOPage();
-
-	text_char_addr++;
-	text_x++;
-	
-	// bounds check. would be nicer to JSR to this but that's expensive in C, so just copying this everywhere...
-	
-	Sys_SwapIOPage(VICKY_IO_PAGE_REGISTERS);
+	return Text_SetCharAndAttr(the_char, ((fore_color << 4) | back_color));
+}
 
-	if (text_x > SCREEN_LAST_COL && text_y < SCREEN_LAST_ROW)
-	{
-		text_x = 0;
-		text_y++;
-		R8(VICKY_TEXT_Y_POS) = text_y;
-	}
-	
-	R8(VICKY_TEXT_X_POS) = text_x;
 
-	Sys_RestoreIOPage();
-	
-	return true;
-}
+// Text_SetCharAndAttr() is implemented in textfast.asm, as it runs once per rendered glyph
 
 
 // copy n-bytes into display memory, at the current X/Y position
@@ -1156,6 +1070,12 @@ bool Text_DrawChars(uint8_t* the_buffer, uint16_t the_len)
 	text_x = text_x + (uint8_t)(the_len - ((the_len / SCREEN_NUM_COLS) * SCREEN_NUM_COLS));
 	text_char_addr += the_len;
 	
+	if (text_cursor_deferred)
+	{
+		text_cursor_dirty = true;
+		return true;
+	}
+	
 	Sys_SwapIOPage(VICKY_IO_PAGE_REGISTERS);
 	R8(VICKY_TEXT_X_POS) = text_x;
 	R8(VICKY_TEXT_Y_POS) = text_y;
@@ -1165,6 +1085,62 @@ bool Text_DrawChars(uint8_t* the_buffer, uint16_t the_len)
 }
 
 
+//! Draw a run of chars at a specified x, y coord, all with the same attribute byte, with one copy into char memory and one fill of attribute memory
+//! The run does not wrap: the caller is responsible for making sure it fits on the row.
+//! The text engine's current position ends up just past the run, but VICKY's cursor is not moved: call Text_SetXY() when done drawing.
+//! @param	x - the horizontal position, between 0 and the screen's text_cols_vis_ - 1
+//! @param	y - the vertical position, between 0 and the screen's text_rows_vis_ - 1
+//! @param	the_buffer - the chars to draw
+//! @param	the_len - the number of chars to draw
+//! @param	the_attribute_value - a 1-byte attribute code (foreground in high nibble, background in low nibble)
+//! @return	Returns false on any error/invalid input.
+bool Text_DrawCharsAndAttrAtXY(uint8_t x, uint8_t y, uint8_t* the_buffer, uint8_t the_len, uint8_t the_attribute_value)
+{
+	uint8_t*		the_write_loc;
+	
+	// LOGIC:
+	//   char and attr ram share an address; only the IO page differs. so: 1 address calc, 2 page swaps, 1 memcpy, 1 memset,
+	//   vs. (for Text_SetCharAndColor per char) 3 page swaps and 2 VICKY cursor writes for every char.
+	
+	the_write_loc = TEXT_ROW_ADDR(y) + x;
+	
+	Sys_SwapIOPage(VICKY_IO_PAGE_CHAR_MEM);
+	memcpy(the_write_loc, the_buffer, the_len);
+	Sys_RestoreIOPage();
+
+	Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
+	memset(the_write_loc, the_attribute_value, the_len);
+	Sys_RestoreIOPage();
+
+	text_char_addr = the_write_loc + the_len;
+	text_x = x + the_len;
+	text_y = y;
+	
+	return true;
+}
+
+
+//! Draw a full screen row from a buffer holding the row's 80 chars followed by its 80 attribute bytes
+//! The text engine's current position and VICKY's cursor are not changed.
+//! @param	y - the vertical position, between 0 and the screen's text_rows_vis_ - 1
+//! @param	the_buffer - SCREEN_NUM_COLS chars, then SCREEN_NUM_COLS attribute bytes
+//! @return	Returns false on any error/invalid input.
+bool Text_DrawRowFromBuffer(uint8_t y, uint8_t* the_buffer)
+{
+	uint8_t*		the_write_loc;
+	
+	the_write_loc = TEXT_ROW_ADDR(y);
+	
+	Sys_SwapIOPage(VICKY_IO_PAGE_CHAR_MEM);
+	memcpy(the_write_loc, the_buffer, SCREEN_NUM_COLS);
+	Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
+	memcpy(the_write_loc, the_buffer + SCREEN_NUM_COLS, SCREEN_NUM_COLS);
+	Sys_RestoreIOPage();
+	
+	return true;
+}
+
+
 
 
 // **** FONT RELATED *****
@@ -73,6 +73,10 @@
 #define SCREEN_TOTAL_BYTES		(SCREEN_NUM_COLS * SCREEN_NUM_ROWS)
 #define SCREEN_TEXT_MEMORY_LOC			0xC000	// start of text AND attribute memory for F256jr. text is is I/O page 2, attributes in I/O page 3. 
 
+// VRAM address of the first cell of row y (0 to SCREEN_NUM_ROWS). from the lo/hi tables in textfast.asm, so no multiply is needed.
+// row SCREEN_NUM_ROWS is the address just past the end of the screen, for computing lengths.
+#define TEXT_ROW_ADDR(y)				((uint8_t*)(text_row_addr_lo[(y)] | ((uint16_t)text_row_addr_hi[(y)] << 8)))
+
 // named F256JR Default Colors (at least in SuperBASIC)
 #define COLOR_BLACK				(uint8_t)0x00
 #define COLOR_MEDIUM_GRAY		(uint8_t)0x01
@@ -171,6 +175,9 @@ typedef struct TextDialogTemplate
 /*                             Global Variables                              */
 /*****************************************************************************/
 
+extern const uint8_t	text_row_addr_lo[SCREEN_NUM_ROWS + 1];	// see TEXT_ROW_ADDR()
+extern const uint8_t	text_row_addr_hi[SCREEN_NUM_ROWS + 1];
+
 
 /*****************************************************************************/
 /*                       Public Function Prototypes                          */
@@ -184,7 +191,6 @@ typedef struct TextDialogTemplate
 
 //! Copies characters and attributes from the left, to the right, for the passed length, backfilling with the char and attr passed
 //!   Shift never extends beyond the current row of text. 
-//! @param	working_buffer - valid pointer to a block of memory at least SCREEN_NUM_COLS in size, to act as a temporary line buffer for the operation. 
 //! @param	x - the starting horizontal position, between 0 and the screen's text_cols_vis_ - 1
 //! @param	y - the starting vertical position, between 0 and the screen's text_rows_vis_ - 1
 //! @param	shift_count - the number of character positions text will be shifted. eg, '1' will shift everything to the right of x by 1 character.
@@ -192,7 +198,7 @@ typedef struct TextDialogTemplate
 //! @param	backfill_fore_color - foreground color that will be applied to the space opened up by the copy
 //! @param	backfill_back_color - background color that will be applied to the space opened up by the copy
 //! @return	Returns false on any error/invalid input.
-bool Text_ShiftTextAndAttrRight(uint8_t* working_buffer, uint8_t x, uint8_t y, uint8_t shift_count, uint8_t backfill_char, uint8_t backfill_fore_color, uint8_t backfill_back_color);
+bool Text_ShiftTextAndAttrRight(uint8_t x, uint8_t y, uint8_t shift_count, uint8_t backfill_char, uint8_t backfill_fore_color, uint8_t backfill_back_color);
 
 //! Copies characters and attributes from the right, to the left, for the passed length, backfilling with the char and attr passed
 //!   Shift never extends beyond the current row of text. 
@@ -277,6 +283,16 @@ bool Text_FillMemory(bool for_attr, uint8_t the_fill);
 //! @return	Returns false on any error/invalid input.
 bool Text_FillBox(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t the_char, uint8_t fore_color, uint8_t back_color);
 
+//! Fill character and attribute memory for a specific box area, using an attribute byte the caller has already built
+//! @param	x1 - the leftmost horizontal position, between 0 and the screen's text_cols_vis_ - 1
+//! @param	y1 - the uppermost vertical position, between 0 and the screen's text_rows_vis_ - 1
+//! @param	x2 - the rightmost horizontal position, between 0 and the screen's text_cols_vis_ - 1
+//! @param	y2 - the lowermost vertical position, between 0 and the screen's text_rows_vis_ - 1
+//! @param	the_char - the character to be used for the fill operation
+//! @param	the_attribute_value - a 1-byte attribute code (foreground in high nibble, background in low nibble)
+//! @return	Returns false on any error/invalid input.
+bool Text_FillBoxCharAndAttr(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t the_char, uint8_t the_attribute_value);
+
 // //! Fill character memory for a specific box area
 // //! @param	x1 - the leftmost horizontal position, between 0 and the screen's text_cols_vis_ - 1
 // //! @param	y1 - the uppermost vertical position, between 0 and the screen's text_rows_vis_ - 1
@@ -333,6 +349,16 @@ uint8_t Text_GetX(void);
 //! @return	the vertical position, between 0 and the screen's text_rows_vis_ - 1
 uint8_t Text_GetY(void);
 
+//! Turn deferred cursor updates on or off.
+//! While on, the text engine tracks the cursor in RAM only, and VICKY's cursor registers are written by Text_SyncCursor().
+//! Turning it off syncs the cursor right away.
+//! @param	defer_it - true to defer VICKY cursor register writes, false to write them as the cursor moves (the default)
+void Text_DeferCursorUpdates(bool defer_it);
+
+//! Push the text engine's cursor position to VICKY, if it has moved since the last push.
+//! Only needed when deferred cursor updates are on.
+void Text_SyncCursor(void);
+
 
 
 // **** Set char/attr functions *****
@@ -398,12 +424,11 @@ bool Text_SetAttr(uint8_t the_attribute_value);
 //! @return	Returns false on any error/invalid input.
 bool Text_SetColor(uint8_t fore_color, uint8_t back_color);
 
-// //! Draw a char at the current X/Y position, also setting the color attributes
-// //! @param	the_char - the character to be used
-// //! @param	fore_color - Index to the desired foreground color (0-15). The predefined macro constants may be used (COLOR_DK_RED, etc.), but be aware that the colors are not fixed, and may not correspond to the names if the LUT in RAM has been modified.
-// //! @param	back_color - Index to the desired background color (0-15). The predefined macro constants may be used (COLOR_DK_RED, etc.), but be aware that the colors are not fixed, and may not correspond to the names if the LUT in RAM has been modified.
-// //! @return	Returns false on any error/invalid input.
-// bool Text_SetCharAndAttr(uint8_t the_char, uint8_t the_attribute_value);
+//! Draw a char at the current X/Y position, also setting the attribute byte, and advance cursor position by 1
+//! @param	the_char - the character to be used
+//! @param	the_attribute_value - a 1-byte attribute code (foreground in high nibble, background in low nibble)
+//! @return	Returns false on any error/invalid input.
+bool Text_SetCharAndAttr(uint8_t the_char, uint8_t the_attribute_value);
 
 //! Draw a char at the current X/Y position, also setting the color attributes, and advance cursor position by 1
 //! @param	the_char - the character to be used
@@ -418,6 +443,24 @@ bool Text_DrawCharsAtXY(uint8_t x, uint8_t y, uint8_t* the_buffer, uint16_t the_
 // copy n-bytes into display memory, at the current X/Y position
 bool Text_DrawChars(uint8_t* the_buffer, uint16_t the_len);
 
+//! Draw a run of chars at a specified x, y coord, all with the same attribute byte, with one copy into char memory and one fill of attribute memory
+//! The run does not wrap: the caller is responsible for making sure it fits on the row.
+//! The text engine's current position ends up just past the run, but VICKY's cursor is not moved: call Text_SetXY() when done drawing.
+//! @param	x - the horizontal position, between 0 and the screen's text_cols_vis_ - 1
+//! @param	y - the vertical position, between 0 and the screen's text_rows_vis_ - 1
+//! @param	the_buffer - the chars to draw
+//! @param	the_len - the number of chars to draw
+//! @param	the_attribute_value - a 1-byte attribute code (foreground in high nibble, background in low nibble)
+//! @return	Returns false on any error/invalid input.
+bool Text_DrawCharsAndAttrAtXY(uint8_t x, uint8_t y, uint8_t* the_buffer, uint8_t the_len, uint8_t the_attribute_value);
+
+//! Draw a full screen row from a buffer holding the row's 80 chars followed by its 80 attribute bytes
+//! The text engine's current position and VICKY's cursor are not changed.
+//! @param	y - the vertical position, between 0 and the screen's text_rows_vis_ - 1
+//! @param	the_buffer - SCREEN_NUM_COLS chars, then SCREEN_NUM_COLS attribute bytes
+//! @return	Returns false on any error/invalid input.
+bool Text_DrawRowFromBuffer(uint8_t y, uint8_t* the_buffer);
+
 
 // **** Get char/attr functions *****
 
@@ -0,0 +1,319 @@
+/*
+ * textbench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+// debug-build benchmark: the textfast.asm routines against the C code they replaced. see textbench.h, and the table in textfast.asm
+
+#ifdef TEXTFAST_BENCHMARK
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "textbench.h"
+#include "comm_buffer.h"
+#include "screen.h"
+#include "shadow.h"
+#include "sys.h"
+#include "text.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// F256 includes
+#include "f256.h"
+
+// F256 Kernel includes
+#include "api.h"
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define VECTOR(member) (size_t) (&((struct call*) 0xff00)->member)
+#define CALL(fn) (unsigned char) ( \
+                   asm("jsr %w", VECTOR(fn)), \
+                   asm("stz %v", error), \
+                   asm("ror %v", error), \
+                   __A__)
+
+#define TEXTBENCH_CYCLES_PER_FRAME	104896UL	// 6.29 MHz CPU, 60 Hz frames
+#define TEXTBENCH_FILL_CHAR			CH_HASH
+#define TEXTBENCH_ATTR				((COLOR_BRIGHT_WHITE << 4) | COLOR_BLUE)
+
+#define TEXTBENCH_SCROLL_UP			0
+#define TEXTBENCH_SCROLL_DOWN		1
+#define TEXTBENCH_FILL				2
+#define TEXTBENCH_INVERT			3
+#define TEXTBENCH_GLYPHS			4
+#define TEXTBENCH_NUM_TESTS			5
+
+
+/*****************************************************************************/
+/*                           File-scoped Variables                           */
+/*****************************************************************************/
+
+// runs per test: enough for 30+ frames on the faster side, so the +/- 1 frame the count can be off by is ~3%
+static const uint8_t	textbench_runs[TEXTBENCH_NUM_TESTS] = {50, 50, 100, 20, 10};
+static const char*		textbench_name[TEXTBENCH_NUM_TESTS] = {"scroll up", "scroll down", "fill", "invert", "glyphs"};
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+extern uint8_t				text_x;
+extern uint8_t				text_y;
+extern uint8_t*				text_char_addr;
+
+extern char*				global_string_buff1;
+
+extern struct call_args args; // in gadget's version of f256 lib, this is allocated and initialized with &args in crt0.
+extern char error;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// returns the kernel's frame counter (low byte)
+uint8_t TextBench_GetFrame(void);
+
+// the C version of Text_SetCharAndAttr(), as it was in text.c
+void TextBench_SetCharAndAttrC(uint8_t the_char, uint8_t the_attribute_value);
+
+// do one run of the_test, with the C code (as text.c had it before textfast.asm) or the asm
+void TextBench_RunOnce(uint8_t the_test, bool use_asm);
+
+// returns the frames it took to do the_test textbench_runs[the_test] times, with the C code or the asm
+uint16_t TextBench_Time(uint8_t the_test, bool use_asm);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// returns the kernel's frame counter (low byte)
+uint8_t TextBench_GetFrame(void)
+{
+	// including query makes the SetTimer call return the value of the current timer (in A): see Keyboard_StartTimerForKey()
+	args.timer.units = (TIMER_FRAMES | TIMER_QUERY);
+	return CALL(Clock.SetTimer);
+}
+
+
+// the C version of Text_SetCharAndAttr(), as it was in text.c
+void TextBench_SetCharAndAttrC(uint8_t the_char, uint8_t the_attribute_value)
+{
+	Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
+	*text_char_addr = the_attribute_value;
+	Sys_RestoreIOPage();
+
+	Sys_SwapIOPage(VICKY_IO_PAGE_CHAR_MEM);
+	*text_char_addr = the_char;
+	Sys_RestoreIOPage();
+
+	text_char_addr++;
+	text_x++;
+
+	Sys_SwapIOPage(VICKY_IO_PAGE_REGISTERS);
+
+	if (text_x > SCREEN_LAST_COL && text_y < SCREEN_LAST_ROW)
+	{
+		text_x = 0;
+		text_y++;
+		R8(VICKY_TEXT_Y_POS) = text_y;
+	}
+
+	R8(VICKY_TEXT_X_POS) = text_x;
+
+	Sys_RestoreIOPage();
+}
+
+
+// do one run of the_test, with the C code (as text.c had it before textfast.asm) or the asm
+void TextBench_RunOnce(uint8_t the_test, bool use_asm)
+{
+	uint8_t*	the_loc;
+	uint8_t		the_value;
+	uint8_t		x;
+	uint8_t		y;
+	uint16_t	i;
+	uint16_t	body_len = (uint16_t)SCREEN_NUM_COLS * (TERM_BODY_HEIGHT - 1);	// rows moved by a scroll
+
+	// LOGIC: every test works over the terminal body, as the terminal itself does. whole rows, so scrolls and fills are full width.
+
+	switch (the_test)
+	{
+		case TEXTBENCH_SCROLL_UP:
+			if (use_asm)
+			{
+				Text_ScrollTextAndAttrRowsUp(TERM_BODY_Y1 + 1, TERM_BODY_Y2);
+			}
+			else
+			{
+				Sys_SwapIOPage(VICKY_IO_PAGE_CHAR_MEM);
+				memmove(TEXT_ROW_ADDR(TERM_BODY_Y1), TEXT_ROW_ADDR(TERM_BODY_Y1 + 1), body_len);
+				Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
+				memmove(TEXT_ROW_ADDR(TERM_BODY_Y1), TEXT_ROW_ADDR(TERM_BODY_Y1 + 1), body_len);
+				Sys_RestoreIOPage();
+			}
+			break;
+
+		case TEXTBENCH_SCROLL_DOWN:
+			if (use_asm)
+			{
+				Text_ScrollTextAndAttrRowsDown(TERM_BODY_Y1, TERM_BODY_Y2 - 1);
+			}
+			else
+			{
+				Sys_SwapIOPage(VICKY_IO_PAGE_CHAR_MEM);
+				memmove(TEXT_ROW_ADDR(TERM_BODY_Y1 + 1), TEXT_ROW_ADDR(TERM_BODY_Y1), body_len);
+				Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
+				memmove(TEXT_ROW_ADDR(TERM_BODY_Y1 + 1), TEXT_ROW_ADDR(TERM_BODY_Y1), body_len);
+				Sys_RestoreIOPage();
+			}
+			break;
+
+		case TEXTBENCH_FILL:
+			if (use_asm)
+			{
+				Text_FillBoxCharAndAttr(0, TERM_BODY_Y1, SCREEN_LAST_COL, TERM_BODY_Y2, TEXTBENCH_FILL_CHAR, TEXTBENCH_ATTR);
+			}
+			else
+			{
+				Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
+				memset(TEXT_ROW_ADDR(TERM_BODY_Y1), TEXTBENCH_ATTR, (uint16_t)SCREEN_NUM_COLS * TERM_BODY_HEIGHT);
+				Sys_SwapIOPage(VICKY_IO_PAGE_CHAR_MEM);
+				memset(TEXT_ROW_ADDR(TERM_BODY_Y1), TEXTBENCH_FILL_CHAR, (uint16_t)SCREEN_NUM_COLS * TERM_BODY_HEIGHT);
+				Sys_RestoreIOPage();
+			}
+			break;
+
+		case TEXTBENCH_INVERT:
+			if (use_asm)
+			{
+				Text_InvertBox(0, TERM_BODY_Y1, SCREEN_LAST_COL, TERM_BODY_Y2);
+			}
+			else
+			{
+				the_loc = TEXT_ROW_ADDR(TERM_BODY_Y1);
+				Sys_SwapIOPage(VICKY_IO_PAGE_ATTR_MEM);
+
+				for (y = TERM_BODY_Y1; y <= TERM_BODY_Y2; y++)
+				{
+					for (x = 0; x < SCREEN_NUM_COLS; x++)
+					{
+						the_value = *the_loc;
+						*the_loc++ = ((the_value & 0x0F) << 4) | ((the_value & 0xF0) >> 4);
+					}
+				}
+
+				Sys_RestoreIOPage();
+			}
+			break;
+
+		case TEXTBENCH_GLYPHS:
+			Text_SetXY(0, TERM_BODY_Y1);
+
+			for (i = 0; i < (uint16_t)SCREEN_NUM_COLS * TERM_BODY_HEIGHT; i++)
+			{
+				if (use_asm)
+				{
+					Text_SetCharAndAttr(TEXTBENCH_FILL_CHAR, TEXTBENCH_ATTR);
+				}
+				else
+				{
+					TextBench_SetCharAndAttrC(TEXTBENCH_FILL_CHAR, TEXTBENCH_ATTR);
+				}
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+// returns the frames it took to do the_test textbench_runs[the_test] times, with the C code or the asm
+uint16_t TextBench_Time(uint8_t the_test, bool use_asm)
+{
+	uint8_t		i;
+	uint8_t		last_frame;
+	uint8_t		this_frame;
+	uint16_t	the_frames = 0;
+
+	// LOGIC:
+	//   the kernel only gives us the low byte of its frame counter, so it's read after every run, and the differences added up.
+	//   one run is never anywhere near 256 frames. the count starts on a frame edge, so it's only off by the partial last frame.
+
+	last_frame = TextBench_GetFrame();
+
+	while ((this_frame = TextBench_GetFrame()) == last_frame)
+	{
+	}
+
+	last_frame = this_frame;
+
+	for (i = 0; i < textbench_runs[the_test]; i++)
+	{
+		TextBench_RunOnce(the_test, use_asm);
+		this_frame = TextBench_GetFrame();
+		the_frames += (uint8_t)(this_frame - last_frame);
+		last_frame = this_frame;
+	}
+
+	return the_frames;
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// run every test in C and in asm, and print the results to the comm buffer. takes about 5 seconds, and the terminal body is put back after.
+// anything that arrives meanwhile waits in the RX ring, but the UART interrupts it takes do count against both sides.
+void TextBench_Run(void)
+{
+	uint8_t		the_test;
+	uint8_t		cursor_x;
+	uint8_t		cursor_y;
+	uint16_t	c_frames;
+	uint16_t	asm_frames;
+
+	cursor_x = Text_GetX();
+	cursor_y = Text_GetY();
+
+	Shadow_Save();
+
+	for (the_test = 0; the_test < TEXTBENCH_NUM_TESTS; the_test++)
+	{
+		c_frames = TextBench_Time(the_test, false);
+		asm_frames = TextBench_Time(the_test, true);
+
+		sprintf(global_string_buff1, "%s x%u: C %u frames (~%lu cyc), asm %u (~%lu cyc)",
+			textbench_name[the_test],
+			textbench_runs[the_test],
+			c_frames,
+			(uint32_t)c_frames * TEXTBENCH_CYCLES_PER_FRAME / textbench_runs[the_test],
+			asm_frames,
+			(uint32_t)asm_frames * TEXTBENCH_CYCLES_PER_FRAME / textbench_runs[the_test]
+		);
+		Buffer_NewMessage(global_string_buff1);
+	}
+
+	Shadow_Restore();
+	Text_SetXY(cursor_x, cursor_y);
+}
+
+
+#endif
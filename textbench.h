@@ -0,0 +1,69 @@
+/*
+ * textbench.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+#ifndef TEXTBENCH_H_
+#define TEXTBENCH_H_
+
+
+
+/* about this class: TextBench
+ *
+ * debug-build only (TEXTFAST_BENCHMARK defined, see _build_vbcc.sh): times the textfast.asm routines against the C code they
+ * replaced, on the real screen, so a change to either shows up as a number
+ *
+ *** things this class needs to be able to do
+ *
+ * count elapsed frames with the kernel's frame counter, across as many frames as a test takes
+ * run each test (scroll up, scroll down, box fill, invert, glyphs) a set number of times, in C then in asm, over the terminal body
+ * print frames and cycles per run for both to the comm buffer
+ * put the terminal body back the way it was afterwards
+ *
+ *** things objects of this class have
+ *
+ * the C versions of the replaced primitives, as they were in text.c before textfast.asm
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+#ifdef TEXTFAST_BENCHMARK
+
+// run every test in C and in asm, and print the results to the comm buffer. takes about 5 seconds, and the terminal body is put back after.
+// anything that arrives meanwhile waits in the RX ring, but the UART interrupts it takes do count against both sides.
+void TextBench_Run(void);
+
+#endif
+
+
+#endif /* TEXTBENCH_H_ */
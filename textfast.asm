@@ -0,0 +1,727 @@
+; native assembly code. see textfast.h for the C interface.
+;
+; hand-written versions of the text.c primitives that run for every received byte or every scrolled line.
+;   text.c keeps doing the parameter validation/clamping and calls in here for the actual VRAM work, so the text.h API
+;   is unchanged. Text_SetCharAndAttr() is implemented here in full, as it is called once per rendered glyph.
+;
+; all routines switch each IO page once per operation (not per row), and restore whatever IO page the caller had in.
+;
+; cycle counts. the measured ones come from Text_Benchmark() (textbench.c): build with TEXTFAST_BENCHMARK defined (see
+;   _build_vbcc.sh), press ALT-P, and it races the old C code against these routines and prints both to the comm buffer.
+;   rerun it after changing anything here. the rest are hand counts, to show where the time goes:
+;   C column: read off the cc65 -Os output (scrolls: cc65's memmove). asm column: counted from this file, page crossings included.
+;
+;   operation                                    C          asm
+;   ------------------------------------------   --------   --------
+;   Text_SetCharAndAttr, per glyph               ~400       ~125 (~105 with deferred cursor updates)
+;   box fill, per byte (+ per row overhead)      ~11 (+~120)  ~11 narrow / ~8.4 full width (+~20)
+;   scroll terminal body (24 rows) up or down    ~63,000    ~37,200
+;   scroll 59 full rows up or down, both pages   ~155,000   ~88,300
+;   Text_InvertBox, per cell                     ~70        ~28
+;
+;   scrolling was ~134,000 up / ~152,000 down through a (zp),y page copy, which can't go below 13 cycles a byte.
+;   TextFast_ScrollRowsUp/Down() unroll over the rows instead, one column at a time, with absolute,x loads and stores
+;   (~9.3 a byte). the price is ~850 bytes of code, and patching the unrolled run's entry and exit for each call.
+
+
+	.setcpu	"65C02"
+	.smart	on
+	.autoimport	on
+	.case	on
+	.debuginfo	off
+	.importzp	sp, tmp1, tmp2, ptr1, ptr2
+	.macpack	longbranch
+
+; import from text.c
+	.import		_text_x
+	.import		_text_y
+	.import		_text_char_addr
+	.import		_text_cursor_deferred
+	.import		_text_cursor_dirty
+
+; import from memory.asm
+	.importzp	_zp_to_addr
+	.importzp	_zp_from_addr
+	.importzp	_zp_copy_len
+	.importzp	_zp_x
+	.importzp	_zp_y
+	.importzp	_zp_temp_1
+	.importzp	_zp_other_byte
+
+; export to f/term .c
+	.export		_Text_SetCharAndAttr
+	.export		_TextFast_FillBox
+	.export		_TextFast_FillBoxBoth
+	.export		_TextFast_CopyRowsUp
+	.export		_TextFast_CopyRowsDown
+	.export		_TextFast_ScrollRowsUp
+	.export		_TextFast_ScrollRowsDown
+	.export		_TextFast_InvertBox
+	.export		_text_row_addr_lo
+	.export		_text_row_addr_hi
+
+
+IO_CTRL = $0001					; IO page selection
+IO_PAGE_REGISTERS = 0
+IO_PAGE_CHAR_MEM = 2
+IO_PAGE_ATTR_MEM = 3
+
+VICKY_TEXT_X_POS = $D014
+VICKY_TEXT_Y_POS = $D016
+
+OPCODE_LDA_ABS_X = $BD			; for patching the unrolled scroll loops
+OPCODE_JMP_ABS = $4C
+SCROLL_PAIR_SIZE = 6			; bytes in one row's LDA abs,x + STA abs,x
+
+; must match text.h
+SCREEN_NUM_COLS = 80
+SCREEN_NUM_ROWS = 60
+SCREEN_LAST_ROW = 59
+SCREEN_TEXT_MEMORY_LOC = $C000
+
+
+
+.segment	"RODATA"
+
+; VRAM address of the first cell of each row, split lo/hi for indexed loads. see TEXT_ROW_ADDR() in text.h
+; one extra entry (row SCREEN_NUM_ROWS) for the address just past the end of the screen
+
+_text_row_addr_lo:
+	.repeat SCREEN_NUM_ROWS + 1, row
+	.byte	<(SCREEN_TEXT_MEMORY_LOC + row * SCREEN_NUM_COLS)
+	.endrepeat
+
+_text_row_addr_hi:
+	.repeat SCREEN_NUM_ROWS + 1, row
+	.byte	>(SCREEN_TEXT_MEMORY_LOC + row * SCREEN_NUM_COLS)
+	.endrepeat
+
+
+
+; ---------------------------------------------------------------
+; bool Text_SetCharAndAttr(uint8_t the_char, uint8_t the_attribute_value)
+; ---------------------------------------------------------------
+;// Draw a char at the current X/Y position, also setting the attribute byte, and advance cursor position by 1
+;// same behavior as the C version it replaces: wraps to the next row at the right edge, unless already on the last row
+
+.segment	"CODE"
+
+.proc	_Text_SetCharAndAttr: near
+
+	STA tmp1				; attribute value (fastcall: last param in A)
+	LDA (sp)				; the_char was pushed on the C stack
+	STA tmp2
+	JSR incsp1
+
+	LDA _text_char_addr
+	STA ptr1
+	LDA _text_char_addr+1
+	STA ptr1+1
+
+	LDX IO_CTRL				; remember caller's IO page
+
+	LDA #IO_PAGE_ATTR_MEM
+	STA IO_CTRL
+	LDA tmp1
+	STA (ptr1)
+
+	DEC IO_CTRL				; attr page - 1 = char page
+	LDA tmp2
+	STA (ptr1)
+
+	STX IO_CTRL
+
+	INC _text_char_addr
+	BNE addr_done
+	INC _text_char_addr+1
+addr_done:
+
+	INC _text_x
+	LDA _text_x
+	CMP #SCREEN_NUM_COLS
+	BCC moved				; still on this row
+	LDA _text_y
+	CMP #SCREEN_LAST_ROW
+	BCS moved				; last row: x is left past the edge, same as C version
+	STZ _text_x
+	INC _text_y
+
+moved:
+	LDA _text_cursor_deferred
+	BEQ sync_now
+	STA _text_cursor_dirty	; deferred: Text_SyncCursor() will push x/y to VICKY later
+	BRA done
+
+sync_now:
+	STZ IO_CTRL				; VICKY registers, for the cursor
+	LDA _text_y
+	STA VICKY_TEXT_Y_POS
+	LDA _text_x
+	STA VICKY_TEXT_X_POS
+	STX IO_CTRL
+
+done:
+
+	LDX #0
+	LDA #1					; true
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; void __fastcall__ TextFast_FillBox(uint8_t the_io_page)
+; ---------------------------------------------------------------
+;// fills a box in char OR attr memory (per the_io_page) with zp_other_byte
+;// set zp_to_addr to VRAM address of top left cell, zp_x to width (1-80), zp_y to height (1+) before calling
+
+.segment	"CODE"
+
+.proc	_TextFast_FillBox: near
+
+	LDX IO_CTRL
+	PHX
+	STA IO_CTRL
+
+	JSR load_box_ptr
+	LDA _zp_other_byte
+	JSR fill_box
+
+	PLA
+	STA IO_CTRL
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; void __fastcall__ TextFast_FillBoxBoth(void)
+; ---------------------------------------------------------------
+;// fills a box with char zp_other_byte and attribute zp_temp_1
+;// set zp_to_addr to VRAM address of top left cell, zp_x to width (1-80), zp_y to height (1+) before calling
+
+.segment	"CODE"
+
+.proc	_TextFast_FillBoxBoth: near
+
+	LDX IO_CTRL
+	PHX
+
+	LDA #IO_PAGE_ATTR_MEM
+	STA IO_CTRL
+	JSR load_box_ptr
+	LDA _zp_temp_1
+	JSR fill_box
+
+	LDA #IO_PAGE_CHAR_MEM
+	STA IO_CTRL
+	JSR load_box_ptr
+	LDA _zp_other_byte
+	JSR fill_box
+
+	PLA
+	STA IO_CTRL
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; void __fastcall__ TextFast_CopyRowsUp(void)
+; ---------------------------------------------------------------
+;// copies zp_copy_len bytes (16 bit) from zp_from_addr to zp_to_addr, in both char and attr memory
+;// copies low to high, so it is only safe for overlapping moves where zp_to_addr < zp_from_addr (ie, scrolling up)
+
+.segment	"CODE"
+
+.proc	_TextFast_CopyRowsUp: near
+
+	LDX IO_CTRL
+	PHX
+
+	LDA #IO_PAGE_CHAR_MEM
+	STA IO_CTRL
+	JSR copy_up
+
+	LDA #IO_PAGE_ATTR_MEM
+	STA IO_CTRL
+	JSR copy_up
+
+	PLA
+	STA IO_CTRL
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; void __fastcall__ TextFast_CopyRowsDown(void)
+; ---------------------------------------------------------------
+;// copies zp_copy_len bytes (16 bit) from zp_from_addr to zp_to_addr, in both char and attr memory
+;// copies high to low, so it is safe for overlapping moves where zp_to_addr > zp_from_addr (ie, scrolling down)
+
+.segment	"CODE"
+
+.proc	_TextFast_CopyRowsDown: near
+
+	LDX IO_CTRL
+	PHX
+
+	LDA #IO_PAGE_CHAR_MEM
+	STA IO_CTRL
+	JSR copy_down
+
+	LDA #IO_PAGE_ATTR_MEM
+	STA IO_CTRL
+	JSR copy_down
+
+	PLA
+	STA IO_CTRL
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; void __fastcall__ TextFast_ScrollRowsUp(void)
+; ---------------------------------------------------------------
+;// moves whole rows zp_x to zp_y (1-59) up one row, in both char and attr memory. row zp_x - 1 is lost, row zp_y is left as is
+
+.segment	"CODE"
+
+.proc	_TextFast_ScrollRowsUp: near
+
+	; LOGIC:
+	;   pairs has a load/store for every row, top down, so one pass through them moves one column of the screen up.
+	;   entry is pointed at row zp_x's pair, and the pair after row zp_y's is turned into a JMP to next_col until we're done
+	;   (unless zp_y is the last row: its pair runs into next_col anyway). going top down, no cell is written before it is read.
+
+	LDA _zp_x
+	DEC A					; row 1's pair is the first
+	JSR pair_offset
+	CLC
+	LDA tmp1
+	ADC #<pairs
+	STA entry+1
+	LDA tmp2
+	ADC #>pairs
+	STA entry+2
+
+	STZ ptr2+1				; nothing patched, yet
+	LDA _zp_y
+	CMP #SCREEN_LAST_ROW
+	BCS copy				; row 59: no pair after it
+
+	JSR pair_offset			; zp_y is also the index of row zp_y + 1's pair
+	CLC
+	LDA tmp1
+	ADC #<pairs
+	STA ptr2
+	LDA tmp2
+	ADC #>pairs
+	STA ptr2+1
+	LDA #<next_col
+	LDX #>next_col
+	JSR patch_exit
+
+copy:
+	LDX IO_CTRL
+	PHX
+
+	LDA #IO_PAGE_CHAR_MEM
+	STA IO_CTRL
+	JSR copy_columns
+
+	LDA #IO_PAGE_ATTR_MEM
+	STA IO_CTRL
+	JSR copy_columns
+
+	PLA
+	STA IO_CTRL
+
+	LDA _zp_y				; the patched pair loaded from row zp_y + 1
+	INC A
+	JMP unpatch_exit
+
+copy_columns:
+	LDX #SCREEN_NUM_COLS - 1
+
+entry:
+	JMP pairs				; operand set above
+
+pairs:
+	.repeat SCREEN_LAST_ROW, row
+	LDA SCREEN_TEXT_MEMORY_LOC + (row + 1) * SCREEN_NUM_COLS, x
+	STA SCREEN_TEXT_MEMORY_LOC + row * SCREEN_NUM_COLS, x
+	.endrepeat
+
+next_col:
+	DEX
+	BMI done
+	JMP entry				; too far back for a branch
+
+done:
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; void __fastcall__ TextFast_ScrollRowsDown(void)
+; ---------------------------------------------------------------
+;// moves whole rows zp_x to zp_y (0-58) down one row, in both char and attr memory. row zp_y + 1 is lost, row zp_x is left as is
+
+.segment	"CODE"
+
+.proc	_TextFast_ScrollRowsDown: near
+
+	; LOGIC:
+	;   same as TextFast_ScrollRowsUp(), but pairs goes bottom up (row 58 into row 59 first), so entry is row zp_y's pair,
+	;   and the exit goes in row zp_x - 1's (unless zp_x is row 0: its pair is the last one).
+
+	LDA #SCREEN_LAST_ROW - 1
+	SEC
+	SBC _zp_y				; row 58's pair is the first
+	JSR pair_offset
+	CLC
+	LDA tmp1
+	ADC #<pairs
+	STA entry+1
+	LDA tmp2
+	ADC #>pairs
+	STA entry+2
+
+	STZ ptr2+1				; nothing patched, yet
+	LDA _zp_x
+	BEQ copy				; row 0: no pair after it
+
+	LDA #SCREEN_LAST_ROW
+	SEC
+	SBC _zp_x				; index of row zp_x - 1's pair
+	JSR pair_offset
+	CLC
+	LDA tmp1
+	ADC #<pairs
+	STA ptr2
+	LDA tmp2
+	ADC #>pairs
+	STA ptr2+1
+	LDA #<next_col
+	LDX #>next_col
+	JSR patch_exit
+
+copy:
+	LDX IO_CTRL
+	PHX
+
+	LDA #IO_PAGE_CHAR_MEM
+	STA IO_CTRL
+	JSR copy_columns
+
+	LDA #IO_PAGE_ATTR_MEM
+	STA IO_CTRL
+	JSR copy_columns
+
+	PLA
+	STA IO_CTRL
+
+	LDA _zp_x				; the patched pair loaded from row zp_x - 1
+	DEC A
+	JMP unpatch_exit
+
+copy_columns:
+	LDX #SCREEN_NUM_COLS - 1
+
+entry:
+	JMP pairs				; operand set above
+
+pairs:
+	.repeat SCREEN_LAST_ROW, i
+	LDA SCREEN_TEXT_MEMORY_LOC + (SCREEN_LAST_ROW - 1 - i) * SCREEN_NUM_COLS, x
+	STA SCREEN_TEXT_MEMORY_LOC + (SCREEN_LAST_ROW - i) * SCREEN_NUM_COLS, x
+	.endrepeat
+
+next_col:
+	DEX
+	BMI done
+	JMP entry				; too far back for a branch
+
+done:
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; void __fastcall__ TextFast_InvertBox(void)
+; ---------------------------------------------------------------
+;// swaps the fore/back color nibbles of every attribute byte in a box
+;// set zp_to_addr to VRAM address of top left cell, zp_x to width (1-80), zp_y to height (1+) before calling
+
+.segment	"CODE"
+
+.proc	_TextFast_InvertBox: near
+
+	LDX IO_CTRL
+	PHX
+	LDA #IO_PAGE_ATTR_MEM
+	STA IO_CTRL
+
+	JSR load_box_ptr
+	LDX _zp_y
+
+next_row:
+	LDY _zp_x
+	DEY
+
+next_cell:
+	LDA (ptr1),y
+	ASL A					; swap nibbles (fore <-> back)
+	ADC #$80
+	ROL A
+	ASL A
+	ADC #$80
+	ROL A
+	STA (ptr1),y
+	DEY
+	BPL next_cell
+
+	JSR next_box_row
+	DEX
+	BNE next_row
+
+	PLA
+	STA IO_CTRL
+	RTS
+
+.endproc
+
+
+
+; ---------------------------------------------------------------
+; private helpers. all expect the right IO page to already be in.
+; ---------------------------------------------------------------
+
+.segment	"CODE"
+
+;// ptr1 = zp_to_addr
+.proc	load_box_ptr: near
+
+	LDA _zp_to_addr
+	STA ptr1
+	LDA _zp_to_addr+1
+	STA ptr1+1
+	RTS
+
+.endproc
+
+
+;// ptr1 += SCREEN_NUM_COLS. preserves X
+.proc	next_box_row: near
+
+	CLC
+	LDA ptr1
+	ADC #SCREEN_NUM_COLS
+	STA ptr1
+	BCC done
+	INC ptr1+1
+done:
+	RTS
+
+.endproc
+
+
+;// fills zp_y rows of zp_x bytes with A, starting at ptr1
+.proc	fill_box: near
+
+	STA tmp1
+	LDX _zp_y
+	LDA _zp_x
+	CMP #SCREEN_NUM_COLS
+	BEQ full_row
+
+narrow_row:
+	LDY _zp_x
+	DEY
+	LDA tmp1
+narrow_byte:
+	STA (ptr1),y
+	DEY
+	BPL narrow_byte			; width is never more than 80, so Y never starts >= 128
+
+	JSR next_box_row
+	DEX
+	BNE narrow_row
+	RTS
+
+full_row:
+	LDY #SCREEN_NUM_COLS - 1
+	LDA tmp1
+full_bytes:
+	.repeat 8				; 80 = 10 x 8
+	STA (ptr1),y
+	DEY
+	.endrepeat
+	BPL full_bytes
+
+	JSR next_box_row
+	DEX
+	BNE full_row
+	RTS
+
+.endproc
+
+
+;// tmp1/tmp2 = A * SCROLL_PAIR_SIZE: the offset of pair # A (0-58) in an unrolled scroll loop
+.proc	pair_offset: near
+
+	STA tmp1
+	ASL A					; x2: A is < 64, so no carry
+	ADC tmp1				; x3
+	STZ tmp2
+	ASL A					; x6
+	ROL tmp2
+	STA tmp1
+	RTS
+
+.endproc
+
+
+;// turns the LDA abs,x at ptr2 into a JMP to X/A (hi/lo), to end a run through an unrolled scroll loop there
+.proc	patch_exit: near
+
+	LDY #1
+	STA (ptr2),y
+	INY
+	TXA
+	STA (ptr2),y
+	LDA #OPCODE_JMP_ABS
+	STA (ptr2)
+	RTS
+
+.endproc
+
+
+;// puts back what patch_exit replaced at ptr2: a load from row A. does nothing if ptr2+1 is 0 (nothing was patched)
+.proc	unpatch_exit: near
+
+	LDX ptr2+1
+	BEQ done
+	TAX
+	LDY #1
+	LDA _text_row_addr_lo,x
+	STA (ptr2),y
+	INY
+	LDA _text_row_addr_hi,x
+	STA (ptr2),y
+	LDA #OPCODE_LDA_ABS_X
+	STA (ptr2)
+done:
+	RTS
+
+.endproc
+
+
+;// copies zp_copy_len bytes from zp_from_addr to zp_to_addr, low to high
+.proc	copy_up: near
+
+	LDA _zp_from_addr
+	STA ptr1
+	LDA _zp_from_addr+1
+	STA ptr1+1
+	LDA _zp_to_addr
+	STA ptr2
+	LDA _zp_to_addr+1
+	STA ptr2+1
+
+	LDY #0
+	LDX _zp_copy_len+1		; whole pages first
+	BEQ partial
+
+whole_page:
+	.repeat 4				; 256 = 64 x 4, so Y wraps to 0 exactly at the end of the page
+	LDA (ptr1),y
+	STA (ptr2),y
+	INY
+	.endrepeat
+	BNE whole_page
+
+	INC ptr1+1
+	INC ptr2+1
+	DEX
+	BNE whole_page
+
+partial:
+	LDX _zp_copy_len
+	BEQ done
+
+partial_byte:
+	LDA (ptr1),y
+	STA (ptr2),y
+	INY
+	DEX
+	BNE partial_byte
+
+done:
+	RTS
+
+.endproc
+
+
+;// copies zp_copy_len bytes from zp_from_addr to zp_to_addr, high to low
+.proc	copy_down: near
+
+	LDA _zp_from_addr		; point past the whole pages: the partial page at the top end goes first
+	STA ptr1
+	CLC
+	LDA _zp_from_addr+1
+	ADC _zp_copy_len+1
+	STA ptr1+1
+	LDA _zp_to_addr
+	STA ptr2
+	CLC
+	LDA _zp_to_addr+1
+	ADC _zp_copy_len+1
+	STA ptr2+1
+
+	LDY _zp_copy_len
+	BEQ pages
+
+partial_byte:
+	DEY
+	LDA (ptr1),y
+	STA (ptr2),y
+	CPY #0
+	BNE partial_byte
+
+pages:
+	LDX _zp_copy_len+1
+	BEQ done
+
+whole_page:
+	DEC ptr1+1
+	DEC ptr2+1
+	LDY #$FF
+
+page_byte:
+	LDA (ptr1),y
+	STA (ptr2),y
+	DEY
+	BNE page_byte
+
+	LDA (ptr1)				; Y = 0
+	STA (ptr2)
+	DEX
+	BNE whole_page
+
+done:
+	RTS
+
+.endproc
@@ -0,0 +1,84 @@
+/*
+ * textfast.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+#ifndef TEXTFAST_H_
+#define TEXTFAST_H_
+
+
+
+
+/* about this class
+ *
+ * this header represents a set of assembly functions in textfast.asm
+ * they are the VRAM-touching inner loops of the hot text.c routines: box fills, scrolling, inverting, and per-glyph output
+ * text.c validates/clamps parameters, sets up the zero page params, and calls these. never call them from elsewhere.
+ * (Text_SetCharAndAttr() is also in textfast.asm, but its prototype stays in text.h, as it is part of the public text API)
+ * all routines restore the caller's IO page before returning
+ * these functions need to be in the MAIN segment so they are always available
+ *
+ */
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+#include <stdint.h>
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// call to a routine in textfast.asm that fills a box in char OR attr memory with zp_other_byte
+// set zp_to_addr to the VRAM address of the top left cell, zp_x to the width (1-80), zp_y to the height (1+) before calling
+// the_io_page is VICKY_IO_PAGE_CHAR_MEM or VICKY_IO_PAGE_ATTR_MEM
+void __fastcall__ TextFast_FillBox(uint8_t the_io_page);
+
+// call to a routine in textfast.asm that fills a box with char zp_other_byte and attribute zp_temp_1
+// set zp_to_addr to the VRAM address of the top left cell, zp_x to the width (1-80), zp_y to the height (1+) before calling
+void __fastcall__ TextFast_FillBoxBoth(void);
+
+// call to a routine in textfast.asm that copies zp_copy_len bytes from zp_from_addr to zp_to_addr in both char and attr memory
+// copies low to high, so only safe for overlapping moves where zp_to_addr < zp_from_addr (ie, shifting left)
+void __fastcall__ TextFast_CopyRowsUp(void);
+
+// call to a routine in textfast.asm that copies zp_copy_len bytes from zp_from_addr to zp_to_addr in both char and attr memory
+// copies high to low, so only safe for overlapping moves where zp_to_addr > zp_from_addr (ie, shifting right)
+void __fastcall__ TextFast_CopyRowsDown(void);
+
+// call to a routine in textfast.asm that moves whole rows zp_x to zp_y (1-59, zp_x <= zp_y) up one row, in both char and attr memory
+void __fastcall__ TextFast_ScrollRowsUp(void);
+
+// call to a routine in textfast.asm that moves whole rows zp_x to zp_y (0-58, zp_x <= zp_y) down one row, in both char and attr memory
+void __fastcall__ TextFast_ScrollRowsDown(void);
+
+// call to a routine in textfast.asm that swaps the fore/back color nibbles of every attribute byte in a box
+// set zp_to_addr to the VRAM address of the top left cell, zp_x to the width (1-80), zp_y to the height (1+) before calling
+void __fastcall__ TextFast_InvertBox(void);
+
+
+#endif /* TEXTFAST_H_ */
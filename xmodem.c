@@ -0,0 +1,1141 @@
+/*
+ * xmodem.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+// XMODEM (checksum / CRC / 1K) and YMODEM batch file receive and send, to and from disk through the kernel file calls
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "xmodem.h"
+#include "app.h"
+#include "comm_buffer.h"
+#include "crc16.h"
+#include "general.h"
+#include "keyboard.h"
+#include "serial.h"
+#include "staging.h"
+#include "strings.h"
+#include "sys.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+// F256 includes
+#include "f256.h"
+
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define XMODEM_START_TIMEOUT_SECS	3		// between 'C' (or NAK) requests while waiting for the sender to start
+#define XMODEM_BLOCK_TIMEOUT_SECS	10		// for the first byte of each block, once the transfer is going
+#define XMODEM_BYTE_TIMEOUT_SECS	2		// for the rest of a block, once it has started (timer restarts as data arrives)
+#define XMODEM_PURGE_SECS			2		// a bad block is followed by this much silence (well, 1-2 sec) before we NAK
+#define XMODEM_CRC_TRIES			3		// 'C' requests to send before falling back to checksum mode
+#define XMODEM_MAX_ERRORS			10		// errors/timeouts in a row before giving up
+#define XMODEM_NUM_CANCELS			8		// CANs (then as many backspaces) sent to abort the transfer from our side. ZMODEM needs 5+.
+#define XMODEM_SEND_TIMEOUT_SECS	10		// for room in the transmit queue (flow control can hold it up)
+
+#define XMODEM_PROGRESS_UNKNOWN_SPAN	100	// with no file length, the bar fills once for every this many K received
+#define XMODEM_SIZE_UNKNOWN			0xFFFFFFFF
+
+// results of XModem_ReadBlock()
+#define XMODEM_BLOCK_OK				0		// a good block is in xmodem_block
+#define XMODEM_BLOCK_BAD			1		// garbled header, bad CRC/checksum, or stray byte
+#define XMODEM_BLOCK_TIMEOUT		2
+#define XMODEM_BLOCK_EOT			3
+#define XMODEM_BLOCK_REMOTE_CANCEL	4
+#define XMODEM_BLOCK_USER_CANCEL	5
+
+
+
+/*****************************************************************************/
+/*                           File-scoped Variables                           */
+/*****************************************************************************/
+
+static uint8_t		xmodem_block[XMODEM_1K_BLOCK_SIZE + XMODEM_BLOCK_OVERHEAD];	// block #, ~block #, data, CRC or checksum
+static uint16_t		xmodem_block_size;			// data size of the block in xmodem_block: XMODEM_BLOCK_SIZE or XMODEM_1K_BLOCK_SIZE
+static bool			xmodem_use_crc;				// false = checksum mode
+static bool			xmodem_user_canceled;		// set when the user hits ESC while we are waiting on data
+
+static uint8_t		xmodem_timer_secs;			// seconds left before a wait times out
+static uint8_t		xmodem_timer_last_second;	// RTC seconds register at the last check
+
+static bool			xmodem_batch_mode;			// YMODEM: always CRC, header blocks, and the double-EOT ending
+static uint32_t		xmodem_file_size;			// from the YMODEM header, or XMODEM_SIZE_UNKNOWN
+static uint32_t		xmodem_bytes_transferred;	// bytes of the current file saved (or sent and ACKed) so far
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+extern char*			global_string_buff1;
+extern char				global_temp_path_1_buffer[FILE_MAX_PATHNAME_SIZE];
+
+extern uint8_t*			zp_from_addr;
+extern uint16_t			zp_copy_len;
+#pragma zpsym ("zp_from_addr");
+#pragma zpsym ("zp_copy_len");
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// start a timeout of the_seconds (1+). expect it to run out anywhere from the_seconds - 1 to the_seconds later.
+void XModem_StartTimer(uint8_t the_seconds);
+
+// returns true if the timer started by XModem_StartTimer() has run out, or if the user hit ESC
+// also keeps the UART FIFO swept and kernel events processed while we wait
+bool XModem_WaitIsOver(void);
+
+// read up to the_len bytes into the_buffer, waiting up to the_seconds for more data to arrive each time the flow stops
+// while waiting, the file being sent is read ahead from disk, or the file being received is written out
+// returns false if the wait ran out (or the user canceled) before all the_len bytes arrived
+bool XModem_ReadBytes(uint8_t* the_buffer, uint16_t the_len, uint8_t the_seconds);
+
+// throw away incoming data until the line has been quiet for a second or so, so the sender is ready for our NAK
+void XModem_Purge(void);
+
+// tell the sender we are giving up on the transfer
+void XModem_SendCancel(void);
+
+// wait for the next block (or EOT/CAN) from the sender, and check it
+// returns one of the XMODEM_BLOCK_x results. on XMODEM_BLOCK_OK, the block is in xmodem_block
+uint8_t XModem_ReadBlock(uint8_t the_seconds);
+
+// update the progress bar from xmodem_bytes_transferred
+void XModem_ShowProgress(void);
+
+// returns how many bytes of the data in xmodem_block belong in the file
+// all of them, unless the sender said how big the file is (YMODEM), in which case the padding at the end is dropped
+uint16_t XModem_BytesToKeep(void);
+
+// receive the data blocks (block 1 onward) of one file into the staging ring, up to and including the sender's EOT
+// the sender is asked to start with the_reply ('C' or NAK). returns one of the XMODEM_RESULT_x results.
+uint8_t XModem_ReceiveBlocks(uint8_t the_reply);
+
+// wait for a YMODEM header (block 0), asking the sender for it with 'C'
+// returns XMODEM_RESULT_RUNNING when the header is in xmodem_block, or the XMODEM_RESULT_x the session ended with
+uint8_t XModem_ReceiveHeader(void);
+
+// pull the file name and size out of the YMODEM header in xmodem_block
+// the name (without any folders the sender put on it) goes into the_name (FILE_MAX_FILENAME_SIZE); the size into xmodem_file_size
+void XModem_ParseHeader(char* the_name);
+
+// set up the serial port and screen for a transfer
+void XModem_StartTransfer(uint8_t the_message_id, bool batch_mode);
+
+// wait for the receiver's answer: ACK, NAK, 'C', or CAN (sent twice). anything else is skipped.
+// returns the answer, or 0 if none came in time (or the user hit ESC)
+uint8_t XModem_GetReply(void);
+
+// wait for the receiver to ask for the first block: 'C' for CRC mode, NAK for checksum mode
+// returns XMODEM_RESULT_RUNNING once it has, or the XMODEM_RESULT_x the session ended with
+uint8_t XModem_WaitForReceiver(void);
+
+// send the block in xmodem_block (block # and xmodem_block_size bytes of data filled in) until the receiver ACKs it
+// returns XMODEM_RESULT_RUNNING once it has, or the XMODEM_RESULT_x the session ended with
+uint8_t XModem_SendBlock(void);
+
+// send EOT until the receiver ACKs it. returns XMODEM_RESULT_DONE once it has, or the XMODEM_RESULT_x the session ended with.
+uint8_t XModem_SendEOT(void);
+
+// send the file open in the staging ring as data blocks (block 1 onward), up to and including the EOT
+// 1K blocks in CRC mode, 128 byte blocks in checksum mode. returns one of the XMODEM_RESULT_x results.
+uint8_t XModem_SendBlocks(void);
+
+// send a YMODEM header (block 0) for the_name, the_size bytes long. an empty name ends the batch.
+// waits for the receiver's 'C' first. returns XMODEM_RESULT_RUNNING once it is ACKed, or the XMODEM_RESULT_x the session ended with.
+uint8_t XModem_SendHeader(char* the_name, uint32_t the_size);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// start a timeout of the_seconds (1+). expect it to run out anywhere from the_seconds - 1 to the_seconds later.
+void XModem_StartTimer(uint8_t the_seconds)
+{
+	xmodem_timer_secs = the_seconds;
+	xmodem_timer_last_second = Sys_GetRTCSeconds();
+}
+
+
+// returns true if the timer started by XModem_StartTimer() has run out, or if the user hit ESC
+// also keeps the UART FIFO swept and kernel events processed while we wait
+bool XModem_WaitIsOver(void)
+{
+	uint8_t		this_second;
+
+	Serial_ReadUART();
+
+	if (Keyboard_GetKeyIfPressed() == CH_ESC)
+	{
+		xmodem_user_canceled = true;
+		return true;
+	}
+
+	this_second = Sys_GetRTCSeconds();
+
+	if (this_second != xmodem_timer_last_second)
+	{
+		xmodem_timer_last_second = this_second;
+		--xmodem_timer_secs;
+	}
+
+	return (xmodem_timer_secs == 0);
+}
+
+
+// read up to the_len bytes into the_buffer, waiting up to the_seconds for more data to arrive each time the flow stops
+// while waiting, the file being sent is read ahead from disk, or the file being received is written out
+// returns false if the wait ran out (or the user canceled) before all the_len bytes arrived
+bool XModem_ReadBytes(uint8_t* the_buffer, uint16_t the_len, uint8_t the_seconds)
+{
+	uint16_t	got;
+
+	// LOGIC:
+	//   the IRQ handler fills the RX ring; we take whatever is there in as few Serial_RingRead() calls as possible
+	//   at 115200, a 1K block usually comes out of the ring in 1-3 copies, not 1000+ single-byte reads
+	//   time waiting for the next block (or an ACK) is dead time: spend it moving the staged file to or from disk
+
+	XModem_StartTimer(the_seconds);
+
+	while (the_len > 0)
+	{
+		got = Serial_RingRead(the_buffer, the_len);
+
+		if (got > 0)
+		{
+			the_buffer += got;
+			the_len -= got;
+			XModem_StartTimer(the_seconds);
+		}
+		else if (Staging_Pump() == false && XModem_WaitIsOver())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// throw away incoming data until the line has been quiet for a second or so, so the sender is ready for our NAK
+void XModem_Purge(void)
+{
+	XModem_StartTimer(XMODEM_PURGE_SECS);
+
+	do
+	{
+		if (Serial_RingRead(xmodem_block, XMODEM_1K_BLOCK_SIZE) > 0)
+		{
+			XModem_StartTimer(XMODEM_PURGE_SECS);
+		}
+	} while (XModem_WaitIsOver() == false);
+}
+
+
+// tell the sender we are giving up on the transfer
+void XModem_SendCancel(void)
+{
+	uint8_t		i;
+
+	// LOGIC: the backspaces erase the CANs from the command line, for senders that drop back to a shell prompt
+
+	for (i = 0; i < XMODEM_NUM_CANCELS; i++)
+	{
+		Serial_SendByte(XMODEM_CAN);
+	}
+
+	for (i = 0; i < XMODEM_NUM_CANCELS; i++)
+	{
+		Serial_SendByte(CH_BKSP);
+	}
+}
+
+
+// wait for the next block (or EOT/CAN) from the sender, and check it
+// returns one of the XMODEM_BLOCK_x results. on XMODEM_BLOCK_OK, the block is in xmodem_block
+uint8_t XModem_ReadBlock(uint8_t the_seconds)
+{
+	uint8_t		the_header;
+	uint8_t		the_sum;
+	uint8_t*	the_data;
+	uint16_t	i;
+
+	if (xmodem_user_canceled)
+	{
+		// ESC was hit during a purge
+		return XMODEM_BLOCK_USER_CANCEL;
+	}
+
+	if (XModem_ReadBytes(&the_header, 1, the_seconds) == false)
+	{
+		return (xmodem_user_canceled ? XMODEM_BLOCK_USER_CANCEL : XMODEM_BLOCK_TIMEOUT);
+	}
+
+	if (the_header == XMODEM_SOH)
+	{
+		xmodem_block_size = XMODEM_BLOCK_SIZE;
+	}
+	else if (the_header == XMODEM_STX)
+	{
+		xmodem_block_size = XMODEM_1K_BLOCK_SIZE;
+	}
+	else if (the_header == XMODEM_EOT)
+	{
+		return XMODEM_BLOCK_EOT;
+	}
+	else if (the_header == XMODEM_CAN)
+	{
+		// a lone CAN could be line noise: it takes 2 in a row
+		if (XModem_ReadBytes(&the_header, 1, XMODEM_BYTE_TIMEOUT_SECS) && the_header == XMODEM_CAN)
+		{
+			return XMODEM_BLOCK_REMOTE_CANCEL;
+		}
+
+		return XMODEM_BLOCK_BAD;
+	}
+	else
+	{
+		return XMODEM_BLOCK_BAD;
+	}
+
+	// block #, ~block #, data, then 2 CRC bytes or 1 checksum byte
+	if (XModem_ReadBytes(xmodem_block, xmodem_block_size + (xmodem_use_crc ? 4 : 3), XMODEM_BYTE_TIMEOUT_SECS) == false)
+	{
+		return (xmodem_user_canceled ? XMODEM_BLOCK_USER_CANCEL : XMODEM_BLOCK_TIMEOUT);
+	}
+
+	if (xmodem_block[0] != (uint8_t)~xmodem_block[1])
+	{
+		return XMODEM_BLOCK_BAD;
+	}
+
+	the_data = xmodem_block + 2;
+
+	if (xmodem_use_crc)
+	{
+		// LOGIC: running the CRC on through the (big-endian) CRC bytes sent after the data gives 0 for a good block
+		zp_from_addr = the_data;
+		zp_copy_len = xmodem_block_size + 2;
+
+		if (CRC16_Update(CRC16_INITIAL_VALUE) != 0)
+		{
+			return XMODEM_BLOCK_BAD;
+		}
+	}
+	else
+	{
+		the_sum = 0;
+
+		for (i = 0; i < xmodem_block_size; i++)
+		{
+			the_sum += the_data[i];
+		}
+
+		if (the_sum != the_data[xmodem_block_size])
+		{
+			return XMODEM_BLOCK_BAD;
+		}
+	}
+
+	return XMODEM_BLOCK_OK;
+}
+
+
+// update the progress bar from xmodem_bytes_transferred
+void XModem_ShowProgress(void)
+{
+	if (xmodem_file_size == XMODEM_SIZE_UNKNOWN)
+	{
+		// LOGIC: XMODEM never says how big the file is, so the bar just fills once per XMODEM_PROGRESS_UNKNOWN_SPAN K, and starts over
+		App_UpdateProgressBar((uint8_t)((xmodem_bytes_transferred >> 10) % XMODEM_PROGRESS_UNKNOWN_SPAN));
+	}
+	else if (xmodem_file_size > 0)
+	{
+		App_UpdateProgressBar((uint8_t)((xmodem_bytes_transferred * 100) / xmodem_file_size));
+	}
+}
+
+
+// returns how many bytes of the data in xmodem_block belong in the file
+// all of them, unless the sender said how big the file is (YMODEM), in which case the padding at the end is dropped
+uint16_t XModem_BytesToKeep(void)
+{
+	uint32_t	bytes_left;
+
+	if (xmodem_file_size == XMODEM_SIZE_UNKNOWN)
+	{
+		return xmodem_block_size;
+	}
+
+	bytes_left = xmodem_file_size - xmodem_bytes_transferred;
+
+	return (bytes_left < xmodem_block_size) ? (uint16_t)bytes_left : xmodem_block_size;
+}
+
+
+// receive the data blocks (block 1 onward) of one file into the staging ring, up to and including the sender's EOT
+// the sender is asked to start with the_reply ('C' or NAK). returns one of the XMODEM_RESULT_x results.
+uint8_t XModem_ReceiveBlocks(uint8_t the_reply)
+{
+	uint8_t		the_result = XMODEM_RESULT_RUNNING;
+	uint8_t		the_wait = XMODEM_START_TIMEOUT_SECS;
+	uint8_t		next_block_num = 1;
+	uint8_t		num_errors = 0;
+	uint8_t		num_eots = 0;
+	uint16_t	the_len;
+	bool		started = false;
+
+	// LOGIC:
+	//   the receiver drives XMODEM: we send 'C' (CRC mode) until the sender starts, falling back to NAK (checksum mode)
+	//   after XMODEM_CRC_TRIES unanswered requests (not in YMODEM, which is always CRC). after that, each block gets
+	//   an ACK (good, or a repeat of the last one, if our ACK got lost) or a NAK (bad). SOH blocks are 128 bytes,
+	//   STX blocks 1K; the sender can mix them.
+	//   a block goes into the staging ring before it is ACKed: a memory copy, so the ACK goes straight back.
+	//   the ring goes out to disk while we wait for the next block (see XModem_ReadBytes()). only if the card falls
+	//   a whole ring behind does Staging_Put() wait on it, and then the sender waits on us, not the other way around.
+	//   received data keeps going into the RX ring during any write (the IRQ handler fills it, and kernel_write()
+	//   sweeps the UART while it waits on the kernel), so nothing is lost however slow the card is
+
+	xmodem_bytes_transferred = 0;
+	XModem_ShowProgress();
+
+	while (the_result == XMODEM_RESULT_RUNNING)
+	{
+		Serial_SendByte(the_reply);
+
+		switch (XModem_ReadBlock(the_wait))
+		{
+			case XMODEM_BLOCK_OK:
+				started = true;
+				num_errors = 0;
+				the_wait = XMODEM_BLOCK_TIMEOUT_SECS;
+				the_reply = XMODEM_ACK;
+
+				if (xmodem_block[0] == next_block_num)
+				{
+					the_len = XModem_BytesToKeep();
+
+					if (Staging_Put(xmodem_block + 2, the_len) == false)
+					{
+						the_result = XMODEM_RESULT_DISK_ERROR;
+						break;
+					}
+
+					++next_block_num;
+					xmodem_bytes_transferred += the_len;
+					XModem_ShowProgress();
+				}
+				else if (xmodem_block[0] != (uint8_t)(next_block_num - 1))
+				{
+					// not the next block, and not a repeat of the last one: we've lost our place
+					the_result = XMODEM_RESULT_FAILED;
+				}
+				break;
+
+			case XMODEM_BLOCK_EOT:
+				if (xmodem_batch_mode && num_eots++ == 0)
+				{
+					// YMODEM: NAK the first EOT. the sender confirms the end of the file by sending it again.
+					the_reply = XMODEM_NAK;
+					break;
+				}
+
+				Serial_SendByte(XMODEM_ACK);
+				the_result = XMODEM_RESULT_DONE;
+				break;
+
+			case XMODEM_BLOCK_REMOTE_CANCEL:
+				the_result = XMODEM_RESULT_REMOTE_CANCEL;
+				break;
+
+			case XMODEM_BLOCK_USER_CANCEL:
+				the_result = XMODEM_RESULT_CANCELED;
+				break;
+
+			default:
+				// bad block or timeout
+				if (++num_errors >= XMODEM_MAX_ERRORS)
+				{
+					the_result = XMODEM_RESULT_FAILED;
+					break;
+				}
+
+				if (started)
+				{
+					XModem_Purge();
+					the_reply = XMODEM_NAK;
+				}
+				else if (num_errors == XMODEM_CRC_TRIES && xmodem_batch_mode == false)
+				{
+					// sender isn't answering 'C': maybe it only knows checksums
+					xmodem_use_crc = false;
+					the_reply = XMODEM_NAK;
+				}
+				break;
+		}
+	}
+
+	return the_result;
+}
+
+
+// wait for a YMODEM header (block 0), asking the sender for it with 'C'
+// returns XMODEM_RESULT_RUNNING when the header is in xmodem_block, or the XMODEM_RESULT_x the session ended with
+uint8_t XModem_ReceiveHeader(void)
+{
+	uint8_t		num_errors = 0;
+
+	while (num_errors < XMODEM_MAX_ERRORS)
+	{
+		Serial_SendByte(XMODEM_CRC_REQUEST);
+
+		switch (XModem_ReadBlock(XMODEM_START_TIMEOUT_SECS))
+		{
+			case XMODEM_BLOCK_OK:
+				if (xmodem_block[0] == 0)
+				{
+					return XMODEM_RESULT_RUNNING;
+				}
+				
+				// a repeat of the last file's last block: our ACK got lost
+				Serial_SendByte(XMODEM_ACK);
+				break;
+
+			case XMODEM_BLOCK_EOT:
+				// a repeat of the last file's EOT: our ACK got lost
+				Serial_SendByte(XMODEM_ACK);
+				break;
+
+			case XMODEM_BLOCK_REMOTE_CANCEL:
+				return XMODEM_RESULT_REMOTE_CANCEL;
+
+			case XMODEM_BLOCK_USER_CANCEL:
+				return XMODEM_RESULT_CANCELED;
+
+			default:
+				++num_errors;
+				break;
+		}
+	}
+
+	return XMODEM_RESULT_FAILED;
+}
+
+
+// pull the file name and size out of the YMODEM header in xmodem_block
+// the name (without any folders the sender put on it) goes into the_name (FILE_MAX_FILENAME_SIZE); the size into xmodem_file_size
+void XModem_ParseHeader(char* the_name)
+{
+	char*		the_field = (char*)xmodem_block + 2;
+	char*		the_slash;
+
+	// LOGIC:
+	//   the header's data is: file name, NUL, then the size in decimal ASCII, usually followed by a space and more fields
+	//   (mod date, mode, etc.) that we have no use for. senders that leave the size out get their blocks saved whole.
+
+	xmodem_block[2 + xmodem_block_size - 1] = 0;	// in case the sender didn't terminate the name
+
+	the_slash = strrchr(the_field, '/');
+	General_Strlcpy(the_name, (the_slash != NULL ? the_slash + 1 : the_field), FILE_MAX_FILENAME_SIZE);
+
+	the_field += strlen(the_field) + 1;
+
+	if (*the_field < CH_ZERO || *the_field > CH_NINE)
+	{
+		xmodem_file_size = XMODEM_SIZE_UNKNOWN;
+		return;
+	}
+
+	xmodem_file_size = 0;
+
+	while (*the_field >= CH_ZERO && *the_field <= CH_NINE)
+	{
+		xmodem_file_size = (xmodem_file_size * 10) + (*the_field++ - CH_ZERO);
+	}
+}
+
+
+// set up the serial port and screen for a transfer
+void XModem_StartTransfer(uint8_t the_message_id, bool batch_mode)
+{
+	Buffer_NewMessage(General_GetString(the_message_id));
+
+	Serial_BeginBinaryTransfer();
+	App_ShowProgressBar();
+
+	xmodem_use_crc = true;
+	xmodem_batch_mode = batch_mode;
+	xmodem_user_canceled = false;
+	xmodem_file_size = XMODEM_SIZE_UNKNOWN;
+
+	// whatever was still coming in for the terminal is not part of the transfer
+	XModem_Purge();
+}
+
+
+// wait for the receiver's answer: ACK, NAK, 'C', or CAN (sent twice). anything else is skipped.
+// returns the answer, or 0 if none came in time (or the user hit ESC)
+uint8_t XModem_GetReply(void)
+{
+	uint8_t		the_byte;
+
+	while (XModem_ReadBytes(&the_byte, 1, XMODEM_BLOCK_TIMEOUT_SECS))
+	{
+		if (the_byte == XMODEM_ACK || the_byte == XMODEM_NAK || the_byte == XMODEM_CRC_REQUEST)
+		{
+			return the_byte;
+		}
+
+		// a lone CAN could be line noise: it takes 2 in a row
+		if (the_byte == XMODEM_CAN && XModem_ReadBytes(&the_byte, 1, XMODEM_BYTE_TIMEOUT_SECS) && the_byte == XMODEM_CAN)
+		{
+			return XMODEM_CAN;
+		}
+	}
+
+	return 0;
+}
+
+
+// wait for the receiver to ask for the first block: 'C' for CRC mode, NAK for checksum mode
+// returns XMODEM_RESULT_RUNNING once it has, or the XMODEM_RESULT_x the session ended with
+uint8_t XModem_WaitForReceiver(void)
+{
+	uint8_t		num_errors = 0;
+
+	while (num_errors < XMODEM_MAX_ERRORS)
+	{
+		switch (XModem_GetReply())
+		{
+			case XMODEM_CRC_REQUEST:
+				xmodem_use_crc = true;
+				return XMODEM_RESULT_RUNNING;
+
+			case XMODEM_NAK:
+				xmodem_use_crc = false;
+				return XMODEM_RESULT_RUNNING;
+
+			case XMODEM_CAN:
+				return XMODEM_RESULT_REMOTE_CANCEL;
+
+			case 0:
+				if (xmodem_user_canceled)
+				{
+					return XMODEM_RESULT_CANCELED;
+				}
+
+				++num_errors;
+				break;
+
+			default:
+				// a stray ACK: keep waiting
+				break;
+		}
+	}
+
+	return XMODEM_RESULT_FAILED;
+}
+
+
+// send the block in xmodem_block (block # and xmodem_block_size bytes of data filled in) until the receiver ACKs it
+// returns XMODEM_RESULT_RUNNING once it has, or the XMODEM_RESULT_x the session ended with
+uint8_t XModem_SendBlock(void)
+{
+	uint8_t		the_header = (xmodem_block_size == XMODEM_1K_BLOCK_SIZE ? XMODEM_STX : XMODEM_SOH);
+	uint8_t*	the_data = xmodem_block + 2;
+	uint16_t	the_len;
+	uint16_t	the_crc;
+	uint8_t		the_sum;
+	uint8_t		the_result;
+	uint8_t		num_errors;
+	uint16_t	i;
+
+	// LOGIC: same layout as a received block: block #, ~block #, data, then 2 CRC bytes (high byte first) or 1 checksum byte
+
+	xmodem_block[1] = ~xmodem_block[0];
+
+	if (xmodem_use_crc)
+	{
+		zp_from_addr = the_data;
+		zp_copy_len = xmodem_block_size;
+		the_crc = CRC16_Update(CRC16_INITIAL_VALUE);
+		the_data[xmodem_block_size] = the_crc >> 8;
+		the_data[xmodem_block_size + 1] = the_crc & 0xFF;
+		the_len = xmodem_block_size + 4;
+	}
+	else
+	{
+		the_sum = 0;
+
+		for (i = 0; i < xmodem_block_size; i++)
+		{
+			the_sum += the_data[i];
+		}
+
+		the_data[xmodem_block_size] = the_sum;
+		the_len = xmodem_block_size + 3;
+	}
+
+	for (num_errors = 0; num_errors < XMODEM_MAX_ERRORS; num_errors++)
+	{
+		the_result = XModem_SendData(&the_header, 1);
+
+		if (the_result == XMODEM_RESULT_RUNNING)
+		{
+			the_result = XModem_SendData(xmodem_block, the_len);
+		}
+
+		if (the_result != XMODEM_RESULT_RUNNING)
+		{
+			return the_result;
+		}
+
+		switch (XModem_GetReply())
+		{
+			case XMODEM_ACK:
+				return XMODEM_RESULT_RUNNING;
+
+			case XMODEM_CAN:
+				return XMODEM_RESULT_REMOTE_CANCEL;
+
+			default:
+				if (xmodem_user_canceled)
+				{
+					return XMODEM_RESULT_CANCELED;
+				}
+
+				// NAK, 'C', or no answer: send it again
+				break;
+		}
+	}
+
+	return XMODEM_RESULT_FAILED;
+}
+
+
+// send EOT until the receiver ACKs it. returns XMODEM_RESULT_DONE once it has, or the XMODEM_RESULT_x the session ended with.
+uint8_t XModem_SendEOT(void)
+{
+	uint8_t		the_eot = XMODEM_EOT;
+	uint8_t		the_result;
+	uint8_t		num_errors;
+
+	// LOGIC: YMODEM receivers NAK the first EOT, so it takes 2 there. the loop doesn't need to know which protocol it is.
+
+	for (num_errors = 0; num_errors < XMODEM_MAX_ERRORS; num_errors++)
+	{
+		the_result = XModem_SendData(&the_eot, 1);
+
+		if (the_result != XMODEM_RESULT_RUNNING)
+		{
+			return the_result;
+		}
+
+		switch (XModem_GetReply())
+		{
+			case XMODEM_ACK:
+				return XMODEM_RESULT_DONE;
+
+			case XMODEM_CAN:
+				return XMODEM_RESULT_REMOTE_CANCEL;
+
+			default:
+				if (xmodem_user_canceled)
+				{
+					return XMODEM_RESULT_CANCELED;
+				}
+				break;
+		}
+	}
+
+	return XMODEM_RESULT_FAILED;
+}
+
+
+// send the file open in the staging ring as data blocks (block 1 onward), up to and including the EOT
+// 1K blocks in CRC mode, 128 byte blocks in checksum mode. returns one of the XMODEM_RESULT_x results.
+uint8_t XModem_SendBlocks(void)
+{
+	uint8_t		next_block_num = 1;
+	uint8_t		the_result;
+	uint16_t	the_len;
+
+	// LOGIC:
+	//   1K blocks are what make XMODEM/YMODEM worth using at 115200, but checksum-only receivers are old enough
+	//   that they may not know STX blocks. a last piece of 128 bytes or less goes in a small block, with less padding.
+	//   the next block comes out of the staging ring, which is read ahead while each block waits for its ACK
+
+	xmodem_bytes_transferred = 0;
+	XModem_ShowProgress();
+
+	for (;;)
+	{
+		xmodem_block_size = (xmodem_use_crc ? XMODEM_1K_BLOCK_SIZE : XMODEM_BLOCK_SIZE);
+		the_len = Staging_Take(xmodem_block + 2, xmodem_block_size);
+
+		if (the_len == 0)
+		{
+			break;
+		}
+
+		if (the_len <= XMODEM_BLOCK_SIZE)
+		{
+			xmodem_block_size = XMODEM_BLOCK_SIZE;
+		}
+
+		memset(xmodem_block + 2 + the_len, XMODEM_PAD, xmodem_block_size - the_len);
+		xmodem_block[0] = next_block_num;
+
+		the_result = XModem_SendBlock();
+
+		if (the_result != XMODEM_RESULT_RUNNING)
+		{
+			return the_result;
+		}
+
+		++next_block_num;
+		xmodem_bytes_transferred += the_len;
+		XModem_ShowProgress();
+	}
+
+	return XModem_SendEOT();
+}
+
+
+// send a YMODEM header (block 0) for the_name, the_size bytes long. an empty name ends the batch.
+// waits for the receiver's 'C' first. returns XMODEM_RESULT_RUNNING once it is ACKed, or the XMODEM_RESULT_x the session ended with.
+uint8_t XModem_SendHeader(char* the_name, uint32_t the_size)
+{
+	uint8_t		the_result;
+	uint8_t		name_len;
+
+	the_result = XModem_WaitForReceiver();
+
+	if (the_result != XMODEM_RESULT_RUNNING)
+	{
+		return the_result;
+	}
+
+	xmodem_block_size = XMODEM_BLOCK_SIZE;
+	memset(xmodem_block, 0, XMODEM_BLOCK_SIZE + 2);
+
+	// LOGIC: name, NUL, then size in decimal; a name past FILE_MAX_FILENAME_SIZE is already out of spec for us, so cut it there
+	name_len = General_Strnlen(the_name, FILE_MAX_FILENAME_SIZE);
+
+	if (name_len > 0)
+	{
+		memcpy(xmodem_block + 2, the_name, name_len);
+		sprintf((char*)xmodem_block + 2 + name_len + 1, "%lu", the_size);
+	}
+
+	return XModem_SendBlock();
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// receive a file with XMODEM (checksum, CRC, or 1K) and save it as the_file_path (eg, "0:myfile.bin")
+// reports the outcome in the comm buffer. returns true if the whole file was received and saved.
+// note: XMODEM has no file length, so the last block's padding (XMODEM_PAD bytes) is saved as part of the file
+bool XModem_Receive(char* the_file_path)
+{
+	uint8_t		the_result;
+
+	if (Staging_OpenWrite(the_file_path, false) == false)
+	{
+		Buffer_NewMessage(General_GetString(ID_STR_ERROR_GENERIC_DISK));
+		return false;
+	}
+
+	XModem_StartTransfer(ID_STR_MSG_XMODEM_WAITING, false);
+	the_result = XModem_ReceiveBlocks(XMODEM_CRC_REQUEST);
+
+	if (Staging_Close() == false && the_result == XMODEM_RESULT_DONE)
+	{
+		the_result = XMODEM_RESULT_DISK_ERROR;
+	}
+
+	XModem_EndTransfer(the_result);
+
+	if (the_result != XMODEM_RESULT_DONE)
+	{
+		return false;
+	}
+
+	sprintf(global_string_buff1, General_GetString(ID_STR_MSG_XFER_COMPLETE), xmodem_bytes_transferred);
+	Buffer_NewMessage(global_string_buff1);
+
+	return true;
+}
+
+
+// receive a batch of files with YMODEM (or YMODEM-1K), saving each to drive 0 under the name the sender gives
+// reports progress and the outcome in the comm buffer. returns true if the whole batch was received and saved.
+bool XModem_ReceiveBatch(void)
+{
+	uint8_t		the_result = XMODEM_RESULT_RUNNING;
+	uint8_t		num_files = 0;
+	char		the_name[FILE_MAX_FILENAME_SIZE];
+
+	// LOGIC:
+	//   YMODEM is XMODEM-CRC with a header block (block 0) in front of each file, giving its name and size
+	//   the size lets us drop the padding at the end of the last block. a header with an empty name ends the batch.
+	//   each file goes to disk through the staging ring as it comes in, and the last of it once its EOT is ACKed
+
+	XModem_StartTransfer(ID_STR_MSG_YMODEM_WAITING, true);
+
+	while (the_result == XMODEM_RESULT_RUNNING)
+	{
+		the_result = XModem_ReceiveHeader();
+
+		if (the_result != XMODEM_RESULT_RUNNING)
+		{
+			break;
+		}
+
+		if (xmodem_block[2] == 0)
+		{
+			Serial_SendByte(XMODEM_ACK);
+			the_result = XMODEM_RESULT_DONE;
+			break;
+		}
+
+		XModem_ParseHeader(the_name);
+		General_CreateFilePathFromFolderAndFile(global_temp_path_1_buffer, "0:", the_name);
+		if (Staging_OpenWrite(global_temp_path_1_buffer, false) == false)
+		{
+			the_result = XMODEM_RESULT_DISK_ERROR;
+			break;
+		}
+
+		sprintf(global_string_buff1, General_GetString(ID_STR_MSG_YMODEM_FILE), the_name);
+		Buffer_NewMessage(global_string_buff1);
+
+		Serial_SendByte(XMODEM_ACK);
+		the_result = XModem_ReceiveBlocks(XMODEM_CRC_REQUEST);
+
+		if (Staging_Close() == false && the_result == XMODEM_RESULT_DONE)
+		{
+			the_result = XMODEM_RESULT_DISK_ERROR;
+		}
+
+		if (the_result == XMODEM_RESULT_DONE)
+		{
+			++num_files;
+			sprintf(global_string_buff1, General_GetString(ID_STR_MSG_XFER_COMPLETE), xmodem_bytes_transferred);
+			Buffer_NewMessage(global_string_buff1);
+
+			xmodem_file_size = XMODEM_SIZE_UNKNOWN;
+			the_result = XMODEM_RESULT_RUNNING;
+		}
+	}
+
+	XModem_EndTransfer(the_result);
+
+	if (the_result != XMODEM_RESULT_DONE)
+	{
+		return false;
+	}
+
+	sprintf(global_string_buff1, General_GetString(ID_STR_MSG_YMODEM_DONE), num_files);
+	Buffer_NewMessage(global_string_buff1);
+
+	return true;
+}
+
+
+// send a file with XMODEM (checksum, CRC, or 1K, as the receiver asks) from the_file_path (eg, "0:myfile.bin")
+// reports the outcome in the comm buffer. returns true if the whole file was sent and ACKed.
+bool XModem_Send(char* the_file_path)
+{
+	uint8_t		the_result;
+
+	// LOGIC: XMODEM never tells the receiver the size, so don't spend disk time finding it: the progress bar just cycles
+
+	if (Staging_OpenRead(the_file_path) == false)
+	{
+		Buffer_NewMessage(General_GetString(ID_STR_ERROR_GENERIC_DISK));
+		return false;
+	}
+
+	XModem_StartTransfer(ID_STR_MSG_XMODEM_SEND_WAITING, false);
+
+	sprintf(global_string_buff1, General_GetString(ID_STR_MSG_SENDING_FILE_NO_SIZE), the_file_path);
+	Buffer_NewMessage(global_string_buff1);
+
+	the_result = XModem_WaitForReceiver();
+
+	if (the_result == XMODEM_RESULT_RUNNING)
+	{
+		the_result = XModem_SendBlocks();
+	}
+
+	Staging_Close();
+	XModem_EndTransfer(the_result);
+
+	if (the_result != XMODEM_RESULT_DONE)
+	{
+		return false;
+	}
+
+	sprintf(global_string_buff1, General_GetString(ID_STR_MSG_XFER_SENT), xmodem_bytes_transferred);
+	Buffer_NewMessage(global_string_buff1);
+
+	return true;
+}
+
+
+// send a file with YMODEM (1K blocks, CRC) from the_file_path (eg, "0:myfile.bin"), as a batch of one
+// reports the outcome in the comm buffer. returns true if the whole file was sent and the batch closed.
+bool XModem_SendBatch(char* the_file_path)
+{
+	uint32_t	the_size;
+	bool		size_exact;
+	uint8_t		the_result;
+	char*		the_name;
+
+	// LOGIC:
+	//   header block (name + size), then the file's blocks and EOT exactly as for XMODEM, then an empty header to end the batch
+	//   the receiver asks with a fresh 'C' before each header and before the data, so each step starts by waiting for it
+	//   the name goes without the drive prefix: the other side has no use for "0:"
+	//   the size comes from the directory entry (see Staging_GetFileLength()), not a read through the file.
+	//   if that's only good to the block, it still goes in the header: the receiver keeps up to 255 bytes of padding, no worse than XMODEM
+
+	the_size = Staging_GetFileLength(the_file_path, &size_exact);
+
+	if (the_size == STAGING_NO_FILE || Staging_OpenRead(the_file_path) == false)
+	{
+		Buffer_NewMessage(General_GetString(ID_STR_ERROR_GENERIC_DISK));
+		return false;
+	}
+
+	the_name = strchr(the_file_path, ':');
+	the_name = (the_name == NULL) ? the_file_path : the_name + 1;
+
+	XModem_StartTransfer(ID_STR_MSG_YMODEM_SEND_WAITING, true);
+	xmodem_file_size = the_size;
+
+	sprintf(global_string_buff1, General_GetString(ID_STR_MSG_SENDING_FILE), the_name, the_size);
+	Buffer_NewMessage(global_string_buff1);
+
+	the_result = XModem_SendHeader(the_name, the_size);
+
+	if (the_result == XMODEM_RESULT_RUNNING)
+	{
+		the_result = XModem_WaitForReceiver();
+	}
+
+	if (the_result == XMODEM_RESULT_RUNNING)
+	{
+		the_result = XModem_SendBlocks();
+	}
+
+	if (the_result == XMODEM_RESULT_DONE)
+	{
+		the_result = XModem_SendHeader("", 0);
+
+		if (the_result == XMODEM_RESULT_RUNNING)
+		{
+			the_result = XMODEM_RESULT_DONE;
+		}
+	}
+
+	Staging_Close();
+	XModem_EndTransfer(the_result);
+
+	if (the_result != XMODEM_RESULT_DONE)
+	{
+		return false;
+	}
+
+	sprintf(global_string_buff1, General_GetString(ID_STR_MSG_XFER_SENT), xmodem_bytes_transferred);
+	Buffer_NewMessage(global_string_buff1);
+
+	return true;
+}
+
+
+// hand the_len bytes of the_buffer to the serial port, waiting for room in the transmit queue as needed
+// the staged file is worked on while waiting. returns XMODEM_RESULT_RUNNING once all are queued,
+// XMODEM_RESULT_CANCELED if the user hit ESC, or XMODEM_RESULT_FAILED if the queue stopped draining
+uint8_t XModem_SendData(uint8_t* the_buffer, uint16_t the_len)
+{
+	uint16_t	queued;
+
+	// LOGIC:
+	//   Serial_SendData() gives up if the queue doesn't move for 1-2 s, and does nothing else while it waits
+	//   here the wait is longer (flow control can hold a 1K block up), and (like the receive side) the time spent waiting goes to the staged file
+
+	XModem_StartTimer(XMODEM_SEND_TIMEOUT_SECS);
+
+	while (the_len > 0)
+	{
+		queued = Serial_QueueData(the_buffer, the_len);
+
+		if (queued > 0)
+		{
+			the_buffer += queued;
+			the_len -= queued;
+			XModem_StartTimer(XMODEM_SEND_TIMEOUT_SECS);
+		}
+		else if (Staging_Pump() == false && XModem_WaitIsOver())
+		{
+			return (xmodem_user_canceled ? XMODEM_RESULT_CANCELED : XMODEM_RESULT_FAILED);
+		}
+	}
+
+	return XMODEM_RESULT_RUNNING;
+}
+
+
+// put the serial port and screen back after a transfer that ended with the_result (an XMODEM_RESULT_x)
+// cancels the transfer on the other side too, if it ended early from our side. reports any failure in the comm buffer.
+void XModem_EndTransfer(uint8_t the_result)
+{
+	if (the_result != XMODEM_RESULT_DONE && the_result != XMODEM_RESULT_REMOTE_CANCEL)
+	{
+		XModem_SendCancel();
+	}
+
+	App_HideProgressBar();
+	Serial_EndBinaryTransfer();
+
+	if (the_result == XMODEM_RESULT_CANCELED)
+	{
+		Buffer_NewMessage(General_GetString(ID_STR_MSG_XFER_CANCELED));
+	}
+	else if (the_result == XMODEM_RESULT_REMOTE_CANCEL)
+	{
+		Buffer_NewMessage(General_GetString(ID_STR_MSG_XFER_REMOTE_CANCEL));
+	}
+	else if (the_result == XMODEM_RESULT_DISK_ERROR)
+	{
+		Buffer_NewMessage(General_GetString(ID_STR_ERROR_GENERIC_DISK));
+	}
+	else if (the_result == XMODEM_RESULT_FAILED)
+	{
+		Buffer_NewMessage(General_GetString(ID_STR_MSG_XFER_FAILED));
+	}
+}
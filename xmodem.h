@@ -0,0 +1,116 @@
+/*
+ * xmodem.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+#ifndef XMODEM_H_
+#define XMODEM_H_
+
+
+
+/* about this class: XModem
+ *
+ * receives files over the serial connection with the XMODEM or YMODEM protocols, and saves them to disk
+ * sends files from disk the same way, read ahead through the extended memory staging ring (see staging.h)
+ *
+ *** things this class needs to be able to do
+ *
+ * ask the sender for CRC mode, and fall back to the original checksum mode if the sender doesn't answer
+ * take both 128 byte (SOH) and 1K (STX) blocks, in any mix
+ * check each block (CRC via the lookup tables in crc16.asm), ACK good ones, NAK bad ones, ignore repeats
+ * YMODEM: read the name and size from each file's header block, take any number of files, and cut off the padding
+ * take each new block into the staging ring (see staging.h), and write it out to disk while waiting for the next
+ * send in whichever mode the receiver asks for: 1K blocks with CRCs, or 128 byte blocks with checksums
+ * resend a block the receiver NAKs, and keep reading the file ahead while waiting on the ACK
+ * show progress, and let the user cancel with ESC
+ *
+ *** things objects of this class have
+ *
+ * one block buffer, big enough for a 1K block plus its header and CRC (used for sending and receiving)
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "app.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+// protocol control bytes
+#define XMODEM_SOH				0x01	// start of a 128 byte block
+#define XMODEM_STX				0x02	// start of a 1K block
+#define XMODEM_EOT				0x04	// end of transfer
+#define XMODEM_ACK				0x06
+#define XMODEM_NAK				0x15	// also the receiver's "go, with checksums" request
+#define XMODEM_CAN				0x18	// 2 in a row cancels the transfer
+#define XMODEM_CRC_REQUEST		'C'		// receiver's "go, with CRCs" request
+#define XMODEM_PAD				0x1A	// sender fills out the last block with these (CP/M EOF)
+
+#define XMODEM_BLOCK_SIZE		128
+#define XMODEM_1K_BLOCK_SIZE	1024
+#define XMODEM_BLOCK_OVERHEAD	4		// block #, ~block #, and 2 CRC bytes (1 checksum byte in checksum mode)
+
+// results of a transfer (also used by the ZMODEM receiver)
+#define XMODEM_RESULT_RUNNING		0
+#define XMODEM_RESULT_DONE			1
+#define XMODEM_RESULT_CANCELED		2
+#define XMODEM_RESULT_REMOTE_CANCEL	3
+#define XMODEM_RESULT_FAILED		4
+#define XMODEM_RESULT_DISK_ERROR	5
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// receive a file with XMODEM (checksum, CRC, or 1K) and save it as the_file_path (eg, "0:myfile.bin")
+// reports the outcome in the comm buffer. returns true if the whole file was received and saved.
+// note: XMODEM has no file length, so the last block's padding (XMODEM_PAD bytes) is saved as part of the file
+bool XModem_Receive(char* the_file_path);
+
+// receive a batch of files with YMODEM (or YMODEM-1K), saving each to drive 0 under the name the sender gives
+// reports progress and the outcome in the comm buffer. returns true if the whole batch was received and saved.
+bool XModem_ReceiveBatch(void);
+
+// send a file with XMODEM (checksum, CRC, or 1K, as the receiver asks) from the_file_path (eg, "0:myfile.bin")
+// reports the outcome in the comm buffer. returns true if the whole file was sent and ACKed.
+bool XModem_Send(char* the_file_path);
+
+// send a file with YMODEM (1K blocks, CRC) from the_file_path (eg, "0:myfile.bin"), as a batch of one
+// reports the outcome in the comm buffer. returns true if the whole file was sent and the batch closed.
+bool XModem_SendBatch(char* the_file_path);
+
+// hand the_len bytes of the_buffer to the serial port, waiting for room in the transmit queue as needed
+// the staged file is worked on while waiting. returns XMODEM_RESULT_RUNNING once all are queued,
+// XMODEM_RESULT_CANCELED if the user hit ESC, or XMODEM_RESULT_FAILED if the queue stopped draining
+uint8_t XModem_SendData(uint8_t* the_buffer, uint16_t the_len);
+
+// put the serial port and screen back after a transfer that ended with the_result (an XMODEM_RESULT_x)
+// cancels the transfer on the other side too, if it ended early from our side. reports any failure in the comm buffer.
+void XModem_EndTransfer(uint8_t the_result);
+
+
+#endif /* XMODEM_H_ */
@@ -0,0 +1,936 @@
+/*
+ * zmodem.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+// ZMODEM file receive, with resume of interrupted downloads. this code lives in the ZMODEM overlay. sending is in zmodem_send.c.
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "zmodem.h"
+#include "app.h"
+#include "comm_buffer.h"
+#include "crc16.h"
+#include "crc32.h"
+#include "general.h"
+#include "keyboard.h"
+#include "serial.h"
+#include "staging.h"
+#include "strings.h"
+#include "sys.h"
+#include "xmodem.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+// F256 includes
+#include "f256.h"
+
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+// our ZRINIT capabilities (ZF0): full duplex, can receive while writing to disk, 32 bit CRCs. ZP0/ZP1 = 0: no buffer limit.
+#define ZMODEM_RECEIVER_CAPS	((uint32_t)(ZMODEM_CANFDX | ZMODEM_CANOVIO | ZMODEM_CANFC32) << 24)
+
+// results of ZModem_OpenFile()
+#define ZMODEM_FILE_OPENED		0
+#define ZMODEM_FILE_SKIP		1
+#define ZMODEM_FILE_ERROR		2
+
+
+/*****************************************************************************/
+/*                           File-scoped Variables                           */
+/*****************************************************************************/
+
+static bool			zmodem_use_crc32;			// the last header was ZBIN32, so its subpackets have 32 bit CRCs
+static uint32_t		zmodem_offset;				// bytes of the current file saved (on disk or in the staging ring) = where the sender should be sending from
+
+#pragma data-name ("OVERLAY_ZMODEM")
+
+static char			zmodem_hex_digits[16] = {'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'};
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+// these are in MAIN: Serial_RingRead() and the kernel can't reach into the overlay slot
+// the sender (zmodem_send.c) uses them too: only one of the two overlays is loaded at a time
+uint8_t				zmodem_in[ZMODEM_IN_CHUNK_SIZE];	// raw received data
+uint16_t			zmodem_in_pos;
+uint16_t			zmodem_in_len;
+uint8_t				zmodem_data[ZMODEM_MAX_SUBPACKET + 5];	// decoded subpacket, then the ZCRCx char and the CRC, so one CRC pass checks all
+uint16_t			zmodem_data_len;
+
+uint8_t				zmodem_hdr[4];				// data bytes of the last header: position (low byte first), or flags (ZF0 = zmodem_hdr[3])
+
+uint8_t				zmodem_timer_secs;			// seconds left before a wait times out
+uint8_t				zmodem_timer_last_second;	// RTC seconds register at the last check
+
+uint32_t			zmodem_file_size;			// from the ZFILE subpacket (or the file being sent), or ZMODEM_SIZE_UNKNOWN
+char				zmodem_name[FILE_MAX_FILENAME_SIZE];
+
+extern char*			global_string_buff1;
+extern char				global_temp_path_1_buffer[FILE_MAX_PATHNAME_SIZE];
+
+extern uint8_t*			zp_from_addr;
+extern uint16_t			zp_copy_len;
+#pragma zpsym ("zp_from_addr");
+#pragma zpsym ("zp_copy_len");
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// start a timeout of the_seconds (1+) for the next read. the timer only runs while no data is arriving.
+void ZModem_StartTimer(uint8_t the_seconds);
+
+// returns the next received byte, or ZMODEM_ERR_TIMEOUT / ZMODEM_ERR_CANCEL
+int16_t ZModem_GetRawByte(void);
+
+// returns the next received byte that isn't XON/XOFF (ZMODEM escapes real ones, so bare ones are just flow control)
+int16_t ZModem_GetByte(void);
+
+// returns the next byte of ZDLE-escaped data, ZMODEM_GOT_FRAME_END | ZCRCx at the end of a subpacket, or a ZMODEM_ERR_x
+int16_t ZModem_GetEscapedByte(void);
+
+// returns the next byte of a hex header (2 hex digits), or a ZMODEM_ERR_x
+int16_t ZModem_GetHexByte(void);
+
+// wait for the next header. returns its frame type, with its data bytes in zmodem_hdr, or a ZMODEM_ERR_x
+int16_t ZModem_ReadHeader(void);
+
+// returns the position carried in the last header read
+uint32_t ZModem_HeaderPosition(void);
+
+// read and check one data subpacket into zmodem_data/zmodem_data_len
+// returns the ZCRCx char that ended it, or a ZMODEM_ERR_x
+int16_t ZModem_ReadSubpacket(void);
+
+// send a hex header of the_type, with the_value as its 4 data bytes (a position, or flags)
+void ZModem_SendHeader(uint8_t the_type, uint32_t the_value);
+
+// drop everything received so far, so the hunt for the next header starts on fresh data
+void ZModem_Purge(void);
+
+// returns the XMODEM_RESULT_x that a ZMODEM_ERR_x ends the session with, or XMODEM_RESULT_RUNNING if it is worth retrying
+uint8_t ZModem_ErrorResult(int16_t the_error);
+
+// open the file named in the ZFILE subpacket in zmodem_data, picking up where an interrupted download of it stopped
+// returns ZMODEM_FILE_OPENED (with the file open in the staging ring, and zmodem_offset set), ZMODEM_FILE_SKIP, or ZMODEM_FILE_ERROR
+uint8_t ZModem_OpenFile(void);
+
+// receive the data of the open file, from zmodem_offset up to the sender's ZEOF
+// returns XMODEM_RESULT_DONE when the file is complete, or the XMODEM_RESULT_x the session ended with
+uint8_t ZModem_ReceiveFileData(void);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// start a timeout of the_seconds (1+) for the next read. the timer only runs while no data is arriving.
+void ZModem_StartTimer(uint8_t the_seconds)
+{
+	zmodem_timer_secs = the_seconds;
+	zmodem_timer_last_second = Sys_GetRTCSeconds();
+}
+
+
+// returns the next received byte, or ZMODEM_ERR_TIMEOUT / ZMODEM_ERR_CANCEL
+int16_t ZModem_GetRawByte(void)
+{
+	uint8_t		this_second;
+
+	if (zmodem_in_pos < zmodem_in_len)
+	{
+		return zmodem_in[zmodem_in_pos++];
+	}
+
+	for (;;)
+	{
+		zmodem_in_len = Serial_RingRead(zmodem_in, ZMODEM_IN_CHUNK_SIZE);
+
+		if (zmodem_in_len > 0)
+		{
+			zmodem_in_pos = 1;
+			return zmodem_in[0];
+		}
+
+		if (Staging_Pump())
+		{
+			// time spent waiting goes to writing the staged file out
+			continue;
+		}
+
+		Serial_ReadUART();
+
+		if (Keyboard_GetKeyIfPressed() == CH_ESC)
+		{
+			return ZMODEM_ERR_CANCEL;
+		}
+
+		this_second = Sys_GetRTCSeconds();
+
+		if (this_second != zmodem_timer_last_second)
+		{
+			zmodem_timer_last_second = this_second;
+
+			if (--zmodem_timer_secs == 0)
+			{
+				return ZMODEM_ERR_TIMEOUT;
+			}
+		}
+	}
+}
+
+
+// returns the next received byte that isn't XON/XOFF (ZMODEM escapes real ones, so bare ones are just flow control)
+int16_t ZModem_GetByte(void)
+{
+	int16_t		the_byte;
+
+	do
+	{
+		the_byte = ZModem_GetRawByte();
+	} while ((the_byte & 0x7F) == ZMODEM_XON || (the_byte & 0x7F) == ZMODEM_XOFF);
+
+	return the_byte;
+}
+
+
+// returns the next byte of ZDLE-escaped data, ZMODEM_GOT_FRAME_END | ZCRCx at the end of a subpacket, or a ZMODEM_ERR_x
+int16_t ZModem_GetEscapedByte(void)
+{
+	int16_t		the_byte;
+	uint8_t		num_cancels = 1;
+
+	the_byte = ZModem_GetByte();
+
+	if (the_byte != ZDLE)
+	{
+		return the_byte;
+	}
+
+	for (;;)
+	{
+		the_byte = ZModem_GetByte();
+
+		if (the_byte < 0)
+		{
+			return the_byte;
+		}
+
+		if (the_byte == ZDLE)
+		{
+			if (++num_cancels >= ZMODEM_MAX_CANCELS)
+			{
+				return ZMODEM_ERR_REMOTE_CANCEL;
+			}
+
+			continue;
+		}
+
+		if (the_byte >= ZCRCE && the_byte <= ZCRCW)
+		{
+			return (the_byte | ZMODEM_GOT_FRAME_END);
+		}
+
+		if (the_byte == ZRUB0)
+		{
+			return 0x7F;
+		}
+
+		if (the_byte == ZRUB1)
+		{
+			return 0xFF;
+		}
+
+		if ((the_byte & 0x60) == 0x40)
+		{
+			return (the_byte ^ 0x40);
+		}
+
+		return ZMODEM_ERR_BAD;
+	}
+}
+
+
+// returns the next byte of a hex header (2 hex digits), or a ZMODEM_ERR_x
+int16_t ZModem_GetHexByte(void)
+{
+	int16_t		the_digit;
+	uint8_t		the_value = 0;
+	uint8_t		i;
+
+	for (i = 0; i < 2; i++)
+	{
+		the_digit = ZModem_GetByte();
+
+		if (the_digit < 0)
+		{
+			return the_digit;
+		}
+
+		if (the_digit >= '0' && the_digit <= '9')
+		{
+			the_digit -= '0';
+		}
+		else if (the_digit >= 'a' && the_digit <= 'f')
+		{
+			the_digit -= ('a' - 10);
+		}
+		else
+		{
+			return ZMODEM_ERR_BAD;
+		}
+
+		the_value = (the_value << 4) | (uint8_t)the_digit;
+	}
+
+	return the_value;
+}
+
+
+// wait for the next header. returns its frame type, with its data bytes in zmodem_hdr, or a ZMODEM_ERR_x
+int16_t ZModem_ReadHeader(void)
+{
+	int16_t		the_byte;
+	uint16_t	num_skipped = 0;
+	uint8_t		num_cancels = 0;
+	uint8_t		num_bytes;
+	uint8_t		i;
+	uint8_t		the_header[9];	// type, 4 data bytes, 2 or 4 CRC bytes
+
+	// LOGIC:
+	//   a header is ZPAD (1 or more), ZDLE, then a format char: 'A' (binary, CRC-16), 'C' (binary, CRC-32), or 'B' (hex)
+	//   anything before it is skipped: line noise, the rest of a subpacket we gave up on, the sender's "rz" command, etc.
+	//   the CRC is run on through the CRC bytes, so a good header leaves 0 (CRC-16) or CRC32_GOOD_RESIDUE
+
+	ZModem_StartTimer(ZMODEM_HEADER_TIMEOUT_SECS);
+
+	for (;;)
+	{
+		the_byte = ZModem_GetByte();
+
+		if (the_byte < 0)
+		{
+			return the_byte;
+		}
+
+		if (the_byte == ZPAD)
+		{
+			do
+			{
+				the_byte = ZModem_GetByte();
+			} while (the_byte == ZPAD);
+
+			if (the_byte == ZDLE)
+			{
+				break;
+			}
+
+			if (the_byte < 0)
+			{
+				return the_byte;
+			}
+		}
+
+		if (the_byte == ZDLE)
+		{
+			if (++num_cancels >= ZMODEM_MAX_CANCELS)
+			{
+				return ZMODEM_ERR_REMOTE_CANCEL;
+			}
+		}
+		else
+		{
+			num_cancels = 0;
+		}
+
+		if (++num_skipped > ZMODEM_MAX_GARBAGE)
+		{
+			return ZMODEM_ERR_BAD;
+		}
+	}
+
+	the_byte = ZModem_GetByte();
+
+	if (the_byte == ZBIN || the_byte == ZBIN32)
+	{
+		zmodem_use_crc32 = (the_byte == ZBIN32);
+		num_bytes = (zmodem_use_crc32 ? 9 : 7);
+
+		for (i = 0; i < num_bytes; i++)
+		{
+			the_byte = ZModem_GetEscapedByte();
+
+			if (the_byte < 0)
+			{
+				return the_byte;
+			}
+
+			if (the_byte & ZMODEM_GOT_FRAME_END)
+			{
+				return ZMODEM_ERR_BAD;
+			}
+
+			the_header[i] = (uint8_t)the_byte;
+		}
+	}
+	else if (the_byte == ZHEX)
+	{
+		zmodem_use_crc32 = false;
+		num_bytes = 7;
+
+		for (i = 0; i < num_bytes; i++)
+		{
+			the_byte = ZModem_GetHexByte();
+
+			if (the_byte < 0)
+			{
+				return the_byte;
+			}
+
+			the_header[i] = (uint8_t)the_byte;
+		}
+
+		// the CR/LF (and XON) after a hex header are skipped by the hunt for the next one
+	}
+	else
+	{
+		return (the_byte < 0 ? the_byte : ZMODEM_ERR_BAD);
+	}
+
+	zp_from_addr = the_header;
+	zp_copy_len = num_bytes;
+
+	if (num_bytes == 9)
+	{
+		if (CRC32_Update(CRC32_INITIAL_VALUE) != CRC32_GOOD_RESIDUE)
+		{
+			return ZMODEM_ERR_BAD;
+		}
+	}
+	else if (CRC16_Update(CRC16_INITIAL_VALUE) != 0)
+	{
+		return ZMODEM_ERR_BAD;
+	}
+
+	memcpy(zmodem_hdr, &the_header[1], 4);
+
+	return the_header[0];
+}
+
+
+// returns the position carried in the last header read
+uint32_t ZModem_HeaderPosition(void)
+{
+	return *(uint32_t*)zmodem_hdr;	// 6502 is little-endian, same as the header
+}
+
+
+// read and check one data subpacket into zmodem_data/zmodem_data_len
+// returns the ZCRCx char that ended it, or a ZMODEM_ERR_x
+int16_t ZModem_ReadSubpacket(void)
+{
+	int16_t		the_byte;
+	uint16_t	the_len = 0;
+	uint8_t		num_crc_bytes;
+	uint8_t		the_end;
+	uint8_t		i;
+
+	// LOGIC:
+	//   most bytes of a subpacket need no unescaping, so copy runs of them straight out of the raw chunk,
+	//   and only go through ZModem_GetEscapedByte() for ZDLE (and stray XON/XOFF) and at the end of the chunk
+
+	ZModem_StartTimer(ZMODEM_DATA_TIMEOUT_SECS);
+
+	for (;;)
+	{
+		while (zmodem_in_pos < zmodem_in_len)
+		{
+			the_byte = zmodem_in[zmodem_in_pos];
+
+			if (the_byte == ZDLE || (the_byte & 0x7F) == ZMODEM_XON || (the_byte & 0x7F) == ZMODEM_XOFF)
+			{
+				break;
+			}
+
+			if (the_len >= ZMODEM_MAX_SUBPACKET)
+			{
+				return ZMODEM_ERR_BAD;
+			}
+
+			zmodem_data[the_len++] = (uint8_t)the_byte;
+			++zmodem_in_pos;
+		}
+
+		the_byte = ZModem_GetEscapedByte();
+
+		if (the_byte < 0)
+		{
+			return the_byte;
+		}
+
+		if (the_byte & ZMODEM_GOT_FRAME_END)
+		{
+			break;
+		}
+
+		if (the_len >= ZMODEM_MAX_SUBPACKET)
+		{
+			return ZMODEM_ERR_BAD;
+		}
+
+		zmodem_data[the_len++] = (uint8_t)the_byte;
+	}
+
+	// the CRC covers the data and the ZCRCx char, and follows them (escaped)
+	the_end = (uint8_t)the_byte;
+	zmodem_data[the_len] = the_end;
+	num_crc_bytes = (zmodem_use_crc32 ? 4 : 2);
+
+	for (i = 1; i <= num_crc_bytes; i++)
+	{
+		the_byte = ZModem_GetEscapedByte();
+
+		if (the_byte < 0)
+		{
+			return the_byte;
+		}
+
+		if (the_byte & ZMODEM_GOT_FRAME_END)
+		{
+			return ZMODEM_ERR_BAD;
+		}
+
+		zmodem_data[the_len + i] = (uint8_t)the_byte;
+	}
+
+	zp_from_addr = zmodem_data;
+	zp_copy_len = the_len + 1 + num_crc_bytes;
+
+	if (zmodem_use_crc32)
+	{
+		if (CRC32_Update(CRC32_INITIAL_VALUE) != CRC32_GOOD_RESIDUE)
+		{
+			return ZMODEM_ERR_BAD;
+		}
+	}
+	else if (CRC16_Update(CRC16_INITIAL_VALUE) != 0)
+	{
+		return ZMODEM_ERR_BAD;
+	}
+
+	zmodem_data_len = the_len;
+
+	return the_end;
+}
+
+
+// send a hex header of the_type, with the_value as its 4 data bytes (a position, or flags)
+void ZModem_SendHeader(uint8_t the_type, uint32_t the_value)
+{
+	uint8_t		the_bytes[7];	// type, 4 data bytes, CRC (high byte first)
+	uint8_t		the_header[ZMODEM_HEADER_MAX_LEN];
+	uint8_t		the_len;
+	uint16_t	the_crc;
+	uint8_t		i;
+
+	the_bytes[0] = the_type;
+	memcpy(&the_bytes[1], &the_value, 4);	// low byte first, as the protocol wants
+
+	zp_from_addr = the_bytes;
+	zp_copy_len = 5;
+	the_crc = CRC16_Update(CRC16_INITIAL_VALUE);
+	the_bytes[5] = the_crc >> 8;
+	the_bytes[6] = the_crc & 0xFF;
+
+	the_header[0] = ZPAD;
+	the_header[1] = ZPAD;
+	the_header[2] = ZDLE;
+	the_header[3] = ZHEX;
+	the_len = 4;
+
+	for (i = 0; i < 7; i++)
+	{
+		the_header[the_len++] = zmodem_hex_digits[the_bytes[i] >> 4];
+		the_header[the_len++] = zmodem_hex_digits[the_bytes[i] & 0x0F];
+	}
+
+	the_header[the_len++] = CH_ENTER;
+	the_header[the_len++] = CH_LF | 0x80;
+
+	if (the_type != ZFIN && the_type != ZACK)
+	{
+		the_header[the_len++] = ZMODEM_XON;
+	}
+
+	// a ZEOF right behind streamed data can find the TX queue full: wait for room rather than drop the header
+	XModem_SendData(the_header, the_len);
+}
+
+
+// drop everything received so far, so the hunt for the next header starts on fresh data
+void ZModem_Purge(void)
+{
+	zmodem_in_pos = zmodem_in_len;
+	Serial_FlushInBuffer();
+}
+
+
+// returns the XMODEM_RESULT_x that a ZMODEM_ERR_x ends the session with, or XMODEM_RESULT_RUNNING if it is worth retrying
+uint8_t ZModem_ErrorResult(int16_t the_error)
+{
+	if (the_error == ZMODEM_ERR_CANCEL)
+	{
+		return XMODEM_RESULT_CANCELED;
+	}
+
+	if (the_error == ZMODEM_ERR_REMOTE_CANCEL)
+	{
+		return XMODEM_RESULT_REMOTE_CANCEL;
+	}
+
+	return XMODEM_RESULT_RUNNING;
+}
+
+
+// open the file named in the ZFILE subpacket in zmodem_data, picking up where an interrupted download of it stopped
+// returns ZMODEM_FILE_OPENED (with the file open in the staging ring, and zmodem_offset set), ZMODEM_FILE_SKIP, or ZMODEM_FILE_ERROR
+uint8_t ZModem_OpenFile(void)
+{
+	char*		the_field = (char*)zmodem_data;
+	char*		the_slash;
+	uint32_t	on_disk;
+	bool		on_disk_exact;
+
+	// LOGIC:
+	//   the ZFILE subpacket is: file name, NUL, then the size in decimal, and optionally more fields we don't use
+	//   if the file is already on disk: same length = we already have it, so skip it. shorter = an earlier download
+	//   was cut off, so append from where it stops (the ZRPOS we send tells the sender where that is).
+	//   the length on disk comes from the directory entry plus one short read, so our ZRPOS isn't held up by a big file.
+	//   if that's only good to the block (kernel couldn't seek), neither is safe: take the whole file again.
+
+	zmodem_data[zmodem_data_len] = 0;	// in case the sender didn't terminate the fields
+
+	the_slash = strrchr(the_field, '/');
+	General_Strlcpy(zmodem_name, (the_slash != NULL ? the_slash + 1 : the_field), FILE_MAX_FILENAME_SIZE);
+
+	the_field += strlen(the_field) + 1;
+	zmodem_file_size = ZMODEM_SIZE_UNKNOWN;
+
+	if (the_field < (char*)zmodem_data + zmodem_data_len && *the_field >= CH_ZERO && *the_field <= CH_NINE)
+	{
+		zmodem_file_size = 0;
+
+		while (*the_field >= CH_ZERO && *the_field <= CH_NINE)
+		{
+			zmodem_file_size = (zmodem_file_size * 10) + (*the_field++ - CH_ZERO);
+		}
+	}
+
+	General_CreateFilePathFromFolderAndFile(global_temp_path_1_buffer, "0:", zmodem_name);
+
+	zmodem_offset = 0;
+	on_disk = Staging_GetFileLength(global_temp_path_1_buffer, &on_disk_exact);
+
+	if (on_disk != STAGING_NO_FILE && on_disk_exact && zmodem_file_size != ZMODEM_SIZE_UNKNOWN)
+	{
+		if (on_disk == zmodem_file_size)
+		{
+			sprintf(global_string_buff1, General_GetString(ID_STR_MSG_ZMODEM_SKIP), zmodem_name);
+			Buffer_NewMessage(global_string_buff1);
+			return ZMODEM_FILE_SKIP;
+		}
+
+		if (on_disk < zmodem_file_size)
+		{
+			zmodem_offset = on_disk;
+		}
+	}
+
+	if (Staging_OpenWrite(global_temp_path_1_buffer, (zmodem_offset > 0)) == false)
+	{
+		return ZMODEM_FILE_ERROR;
+	}
+
+	if (zmodem_offset > 0)
+	{
+		sprintf(global_string_buff1, General_GetString(ID_STR_MSG_ZMODEM_RESUME), zmodem_name, zmodem_offset);
+	}
+	else
+	{
+		sprintf(global_string_buff1, General_GetString(ID_STR_MSG_YMODEM_FILE), zmodem_name);
+	}
+
+	Buffer_NewMessage(global_string_buff1);
+
+	return ZMODEM_FILE_OPENED;
+}
+
+
+// receive the data of the open file, from zmodem_offset up to the sender's ZEOF
+// returns XMODEM_RESULT_DONE when the file is complete, or the XMODEM_RESULT_x the session ended with
+uint8_t ZModem_ReceiveFileData(void)
+{
+	int16_t		the_type;
+	int16_t		the_end;
+	uint8_t		num_errors = 0;
+	uint8_t		the_result;
+
+	// LOGIC:
+	//   ZMODEM streams: after our ZRPOS the sender keeps sending ZCRCG subpackets without waiting for us.
+	//   each goes into the staging ring as soon as it checks out, and out to disk whenever the line goes quiet
+	//   (see ZModem_GetRawByte()). the RX ring soaks up what arrives during a write.
+	//   on any error we drop what's buffered and send ZRPOS with the position we have saved up to: the sender goes back
+	//   to there and starts a new ZDATA frame. ZDATA frames for any other position are stale, and skipped.
+
+	ZModem_SendHeader(ZRPOS, zmodem_offset);
+
+	for (;;)
+	{
+		the_type = ZModem_ReadHeader();
+
+		if (the_type == ZDATA && ZModem_HeaderPosition() == zmodem_offset)
+		{
+			do
+			{
+				the_end = ZModem_ReadSubpacket();
+
+				if (the_end < 0)
+				{
+					break;
+				}
+
+				if (Staging_Put(zmodem_data, zmodem_data_len) == false)
+				{
+					return XMODEM_RESULT_DISK_ERROR;
+				}
+
+				zmodem_offset += zmodem_data_len;
+				num_errors = 0;
+
+				if (zmodem_file_size != ZMODEM_SIZE_UNKNOWN && zmodem_file_size > 0)
+				{
+					App_UpdateProgressBar((uint8_t)((zmodem_offset * 100) / zmodem_file_size));
+				}
+
+				if (the_end == ZCRCW || the_end == ZCRCQ)
+				{
+					ZModem_SendHeader(ZACK, zmodem_offset);
+				}
+			} while (the_end == ZCRCG || the_end == ZCRCQ);
+
+			if (the_end >= 0)
+			{
+				// ZCRCE or ZCRCW: a header comes next
+				continue;
+			}
+
+			the_type = the_end;
+		}
+		else if (the_type == ZDATA)
+		{
+			// stale data from before our last ZRPOS
+			continue;
+		}
+		else if (the_type == ZEOF)
+		{
+			if (ZModem_HeaderPosition() == zmodem_offset)
+			{
+				return XMODEM_RESULT_DONE;
+			}
+
+			// an EOF for data we don't have yet: the sender will come back round with it
+			continue;
+		}
+		else if (the_type == ZFILE)
+		{
+			// the sender didn't get our ZRPOS: take its subpacket off the line, and answer again
+			ZModem_ReadSubpacket();
+		}
+		else if (the_type == ZFIN || the_type == ZABORT || the_type == ZFERR)
+		{
+			return XMODEM_RESULT_REMOTE_CANCEL;
+		}
+
+		if (the_type < 0)
+		{
+			the_result = ZModem_ErrorResult(the_type);
+
+			if (the_result != XMODEM_RESULT_RUNNING)
+			{
+				return the_result;
+			}
+
+			if (++num_errors >= ZMODEM_MAX_ERRORS)
+			{
+				return XMODEM_RESULT_FAILED;
+			}
+
+			ZModem_Purge();
+		}
+
+		ZModem_SendHeader(ZRPOS, zmodem_offset);
+	}
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// receive a batch of files with ZMODEM, saving each to drive 0 under the name the sender gives
+// a file that is already on disk, but shorter than the sender's copy, is resumed from where it stops
+// reports progress and the outcome in the comm buffer. returns true if the whole batch was received and saved.
+// the ZMODEM overlay must be loaded
+bool ZModem_Receive(void)
+{
+	int16_t		the_type;
+	uint8_t		the_result = XMODEM_RESULT_RUNNING;
+	uint8_t		num_errors = 0;
+	uint8_t		num_files = 0;
+	uint8_t		reply_type = ZRINIT;
+	uint32_t	reply_value = ZMODEM_RECEIVER_CAPS;
+
+	// LOGIC:
+	//   the session: we say ZRINIT (what we can do), the sender offers a file with ZFILE, we answer ZRPOS (send from here)
+	//   or ZSKIP, the data streams until ZEOF, and we say ZRINIT again for the next file. ZFIN ends the session,
+	//   and the sender signs off with "OO" (over and out), which we take off the line so it doesn't show in the terminal.
+
+	Buffer_NewMessage(General_GetString(ID_STR_MSG_ZMODEM_WAITING));
+
+	Serial_BeginBinaryTransfer();
+	App_ShowProgressBar();
+	App_UpdateProgressBar(0);
+
+	zmodem_in_pos = 0;
+	zmodem_in_len = 0;
+
+	// whatever was still coming in for the terminal (including the rest of the sender's ZRQINIT) is not part of the transfer
+	ZModem_Purge();
+
+	while (the_result == XMODEM_RESULT_RUNNING)
+	{
+		ZModem_SendHeader(reply_type, reply_value);
+		reply_type = ZRINIT;
+		reply_value = ZMODEM_RECEIVER_CAPS;
+
+		the_type = ZModem_ReadHeader();
+
+		if (the_type < 0)
+		{
+			the_result = ZModem_ErrorResult(the_type);
+
+			if (the_result == XMODEM_RESULT_RUNNING && ++num_errors >= ZMODEM_MAX_ERRORS)
+			{
+				the_result = XMODEM_RESULT_FAILED;
+			}
+
+			continue;
+		}
+
+		num_errors = 0;
+
+		if (the_type == ZSINIT)
+		{
+			// sender's attention string etc. we have no use for it, but it wants an ACK
+			if (ZModem_ReadSubpacket() >= 0)
+			{
+				reply_type = ZACK;
+				reply_value = 0;
+			}
+			else
+			{
+				reply_type = ZNAK;
+				reply_value = 0;
+			}
+		}
+		else if (the_type == ZFILE)
+		{
+			if (ZModem_ReadSubpacket() < 0)
+			{
+				reply_type = ZNAK;
+				reply_value = 0;
+				continue;
+			}
+
+			switch (ZModem_OpenFile())
+			{
+				case ZMODEM_FILE_SKIP:
+					reply_type = ZSKIP;
+					reply_value = 0;
+					break;
+
+				case ZMODEM_FILE_ERROR:
+					the_result = XMODEM_RESULT_DISK_ERROR;
+					break;
+
+				default:
+					App_UpdateProgressBar(0);
+					the_result = ZModem_ReceiveFileData();
+
+					if (Staging_Close() == false && the_result == XMODEM_RESULT_DONE)
+					{
+						the_result = XMODEM_RESULT_DISK_ERROR;
+					}
+
+					if (the_result == XMODEM_RESULT_DONE)
+					{
+						++num_files;
+						sprintf(global_string_buff1, General_GetString(ID_STR_MSG_XFER_COMPLETE), zmodem_offset);
+						Buffer_NewMessage(global_string_buff1);
+						the_result = XMODEM_RESULT_RUNNING;
+					}
+					break;
+			}
+		}
+		else if (the_type == ZFIN)
+		{
+			ZModem_SendHeader(ZFIN, 0);
+
+			ZModem_StartTimer(1);
+			ZModem_GetRawByte();
+			ZModem_GetRawByte();
+
+			the_result = XMODEM_RESULT_DONE;
+		}
+		else if (the_type == ZABORT || the_type == ZFERR)
+		{
+			the_result = XMODEM_RESULT_REMOTE_CANCEL;
+		}
+
+		// anything else (ZRQINIT, a stray ZDATA/ZEOF, etc.): say ZRINIT again
+	}
+
+	Staging_Close();
+
+	XModem_EndTransfer(the_result);
+
+	if (the_result != XMODEM_RESULT_DONE)
+	{
+		return false;
+	}
+
+	sprintf(global_string_buff1, General_GetString(ID_STR_MSG_YMODEM_DONE), num_files);
+	Buffer_NewMessage(global_string_buff1);
+
+	return true;
+}
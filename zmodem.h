@@ -0,0 +1,130 @@
+/*
+ * zmodem.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+#ifndef ZMODEM_H_
+#define ZMODEM_H_
+
+
+
+/* about this class: ZModem
+ *
+ * receives files over the serial connection with the ZMODEM protocol, and saves them to disk
+ * lives in its own overlay (OVERLAY_ZMODEM): load it before calling in, and put OVERLAY_SCREEN back after
+ * sending is in ZModemSend (see zmodem_send.h), which has an overlay of its own
+ *
+ *** things this class needs to be able to do
+ *
+ * tell the sender what we can do (full duplex, overlapped I/O, 32 bit CRCs), and let it stream
+ * find headers in the incoming data (hex, binary CRC-16, binary CRC-32), and check them
+ * undo the ZDLE escaping of binary data, and check each subpacket's CRC-16 or CRC-32
+ * save each subpacket as it comes in (through the staging ring: see staging.h), and on any error, ask the sender to go back to where we are (ZRPOS)
+ * pick up an interrupted download where it left off, if part of the file is already on disk
+ * take any number of files, show progress, and let the user cancel with ESC
+ *
+ *** things objects of this class have
+ *
+ * a chunk of raw received data, pulled out of the RX ring, and one decoded subpacket
+ * (these, and the last header, are in MAIN, and ZModemSend uses them too)
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "app.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+// the protocol's framing, shared by the receiver (zmodem.c, OVERLAY_ZMODEM) and the sender (zmodem_send.c, OVERLAY_ZMODEM_SEND)
+#define ZPAD					'*'		// starts every header
+#define ZDLE					0x18	// escape character (same value as CAN: 5 in a row cancels)
+#define ZBIN					'A'		// binary header, CRC-16
+#define ZHEX					'B'		// hex header, CRC-16
+#define ZBIN32					'C'		// binary header, CRC-32
+
+// frame types
+#define ZRQINIT					0
+#define ZRINIT					1
+#define ZSINIT					2
+#define ZACK					3
+#define ZFILE					4
+#define ZSKIP					5
+#define ZNAK					6
+#define ZABORT					7
+#define ZFIN					8
+#define ZRPOS					9
+#define ZDATA					10
+#define ZEOF					11
+#define ZFERR					12
+
+// ZDLE sequences that end a subpacket, and say what comes next
+#define ZCRCE					'h'		// end of frame: a header follows
+#define ZCRCG					'i'		// more data follows, no reply wanted
+#define ZCRCQ					'j'		// more data follows, ZACK wanted
+#define ZCRCW					'k'		// end of frame, ZACK wanted
+#define ZRUB0					'l'		// escaped 0x7F
+#define ZRUB1					'm'		// escaped 0xFF
+
+// ZRINIT capabilities (ZF0)
+#define ZMODEM_CANFDX			0x01
+#define ZMODEM_CANOVIO			0x02
+#define ZMODEM_CANFC32			0x20
+
+#define ZMODEM_DLE				0x10	// sent ZDLE-escaped, along with XON, XOFF, ZDLE, and their high-bit versions
+#define ZMODEM_XON				0x11
+#define ZMODEM_XOFF				0x13
+
+// results of the byte/header/subpacket readers. 0+ is a byte, frame type, or subpacket end
+#define ZMODEM_GOT_FRAME_END	0x0100	// or'd with the ZCRCx char that ended a subpacket
+#define ZMODEM_ERR_TIMEOUT		(-1)
+#define ZMODEM_ERR_CANCEL		(-2)	// user hit ESC
+#define ZMODEM_ERR_REMOTE_CANCEL	(-3)	// 5 CANs from the sender
+#define ZMODEM_ERR_BAD			(-4)	// bad escape, bad CRC, overlong subpacket, no header found in the garbage
+
+#define ZMODEM_HEADER_TIMEOUT_SECS	10
+#define ZMODEM_DATA_TIMEOUT_SECS	5
+#define ZMODEM_MAX_ERRORS		10
+#define ZMODEM_MAX_GARBAGE		8192	// bytes to look through for a header. stale streamed data after a ZRPOS can run this long.
+#define ZMODEM_MAX_CANCELS		5
+#define ZMODEM_MAX_SUBPACKET	1024
+#define ZMODEM_IN_CHUNK_SIZE	256
+#define ZMODEM_HEADER_MAX_LEN	21		// "**", ZDLE, 'B', 14 hex digits, CR, LF, XON
+#define ZMODEM_SIZE_UNKNOWN		0xFFFFFFFF
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// receive a batch of files with ZMODEM, saving each to drive 0 under the name the sender gives
+// a file that is already on disk, but shorter than the sender's copy, is resumed from where it stops
+// reports progress and the outcome in the comm buffer. returns true if the whole batch was received and saved.
+// the ZMODEM overlay must be loaded
+bool ZModem_Receive(void);
+
+
+#endif /* ZMODEM_H_ */
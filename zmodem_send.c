@@ -0,0 +1,836 @@
+/*
+ * zmodem_send.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+// ZMODEM file send, starting partway in if the receiver has part of the file already. this code lives in the ZMODEM send overlay.
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "zmodem_send.h"
+#include "app.h"
+#include "comm_buffer.h"
+#include "crc16.h"
+#include "general.h"
+#include "keyboard.h"
+#include "serial.h"
+#include "staging.h"
+#include "strings.h"
+#include "sys.h"
+#include "xmodem.h"
+#include "zmodem.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// F256 includes
+#include "f256.h"
+
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define ZMODEM_OUT_CHUNK_SIZE	128		// escaped data is built up this much at a time before going to the TX queue
+
+
+/*****************************************************************************/
+/*                           File-scoped Variables                           */
+/*****************************************************************************/
+
+static uint8_t		zmodem_out[ZMODEM_OUT_CHUNK_SIZE];	// escaped data on its way out
+static uint8_t		zmodem_out_len;
+static bool			zmodem_stream;				// the receiver takes a whole file without stopping (else we wait for a ZACK each subpacket)
+
+#pragma data-name ("OVERLAY_ZMODEM_SEND")
+
+static char			zmodem_hex_digits[16] = {'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'};
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+// the receiver's buffers and state in MAIN (see zmodem.c)
+extern uint8_t			zmodem_in[ZMODEM_IN_CHUNK_SIZE];
+extern uint16_t			zmodem_in_pos;
+extern uint16_t			zmodem_in_len;
+extern uint8_t			zmodem_data[ZMODEM_MAX_SUBPACKET + 5];
+extern uint16_t			zmodem_data_len;
+extern uint8_t			zmodem_hdr[4];
+extern uint8_t			zmodem_timer_secs;
+extern uint8_t			zmodem_timer_last_second;
+extern uint32_t			zmodem_file_size;
+extern char				zmodem_name[FILE_MAX_FILENAME_SIZE];
+
+extern char*			global_string_buff1;
+
+extern uint8_t*			zp_from_addr;
+extern uint16_t			zp_copy_len;
+#pragma zpsym ("zp_from_addr");
+#pragma zpsym ("zp_copy_len");
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// start a timeout of the_seconds (1+) for the next read. the timer only runs while no data is arriving.
+void ZModemSend_StartTimer(uint8_t the_seconds);
+
+// returns the next received byte, or ZMODEM_ERR_TIMEOUT / ZMODEM_ERR_CANCEL. reads the file ahead while it waits.
+int16_t ZModemSend_GetRawByte(void);
+
+// returns the next received byte that isn't XON/XOFF (ZMODEM escapes real ones, so bare ones are just flow control)
+int16_t ZModemSend_GetByte(void);
+
+// returns the next byte of ZDLE-escaped data, or a ZMODEM_ERR_x (a subpacket end is ZMODEM_ERR_BAD: the receiver sends none)
+int16_t ZModemSend_GetEscapedByte(void);
+
+// returns the next byte of a hex header (2 hex digits), or a ZMODEM_ERR_x
+int16_t ZModemSend_GetHexByte(void);
+
+// wait for the receiver's next header. returns its frame type, with its data bytes in zmodem_hdr, or a ZMODEM_ERR_x
+int16_t ZModemSend_ReadHeader(void);
+
+// returns the position carried in the last header read
+uint32_t ZModemSend_HeaderPosition(void);
+
+// send a hex header of the_type, with the_value as its 4 data bytes (a position, or flags)
+void ZModemSend_SendHeader(uint8_t the_type, uint32_t the_value);
+
+// drop everything received so far, so the hunt for the next header starts on fresh data
+void ZModemSend_Purge(void);
+
+// returns the XMODEM_RESULT_x that a ZMODEM_ERR_x ends the session with, or XMODEM_RESULT_RUNNING if it is worth retrying
+uint8_t ZModemSend_ErrorResult(int16_t the_error);
+
+// send what has been built up in zmodem_out. returns XMODEM_RESULT_RUNNING, or the XMODEM_RESULT_x the session ended with
+uint8_t ZModemSend_FlushOut(void);
+
+// add the_len bytes of the_data to zmodem_out, ZDLE-escaping the ones that can't go over the line as they are
+// sends zmodem_out whenever it fills. returns XMODEM_RESULT_RUNNING, or the XMODEM_RESULT_x the session ended with
+uint8_t ZModemSend_SendEscaped(uint8_t* the_data, uint8_t the_len);
+
+// send zmodem_data/zmodem_data_len as a subpacket ended by the_end (a ZCRCx), with its CRC-16
+// returns XMODEM_RESULT_RUNNING, or the XMODEM_RESULT_x the session ended with
+uint8_t ZModemSend_SendSubpacket(uint8_t the_end);
+
+// send the staged file from the position in the receiver's ZRPOS, until the receiver has all of it (or skips it)
+// returns XMODEM_RESULT_DONE when it has, or the XMODEM_RESULT_x the session ended with
+uint8_t ZModemSend_SendFileData(void);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// start a timeout of the_seconds (1+) for the next read. the timer only runs while no data is arriving.
+void ZModemSend_StartTimer(uint8_t the_seconds)
+{
+	zmodem_timer_secs = the_seconds;
+	zmodem_timer_last_second = Sys_GetRTCSeconds();
+}
+
+
+// returns the next received byte, or ZMODEM_ERR_TIMEOUT / ZMODEM_ERR_CANCEL. reads the file ahead while it waits.
+int16_t ZModemSend_GetRawByte(void)
+{
+	uint8_t		this_second;
+
+	if (zmodem_in_pos < zmodem_in_len)
+	{
+		return zmodem_in[zmodem_in_pos++];
+	}
+
+	for (;;)
+	{
+		zmodem_in_len = Serial_RingRead(zmodem_in, ZMODEM_IN_CHUNK_SIZE);
+
+		if (zmodem_in_len > 0)
+		{
+			zmodem_in_pos = 1;
+			return zmodem_in[0];
+		}
+
+		if (Staging_Pump())
+		{
+			// time spent waiting goes to reading the file ahead into the staging ring
+			continue;
+		}
+
+		Serial_ReadUART();
+
+		if (Keyboard_GetKeyIfPressed() == CH_ESC)
+		{
+			return ZMODEM_ERR_CANCEL;
+		}
+
+		this_second = Sys_GetRTCSeconds();
+
+		if (this_second != zmodem_timer_last_second)
+		{
+			zmodem_timer_last_second = this_second;
+
+			if (--zmodem_timer_secs == 0)
+			{
+				return ZMODEM_ERR_TIMEOUT;
+			}
+		}
+	}
+}
+
+
+// returns the next received byte that isn't XON/XOFF (ZMODEM escapes real ones, so bare ones are just flow control)
+int16_t ZModemSend_GetByte(void)
+{
+	int16_t		the_byte;
+
+	do
+	{
+		the_byte = ZModemSend_GetRawByte();
+	} while ((the_byte & 0x7F) == ZMODEM_XON || (the_byte & 0x7F) == ZMODEM_XOFF);
+
+	return the_byte;
+}
+
+
+// returns the next byte of ZDLE-escaped data, or a ZMODEM_ERR_x (a subpacket end is ZMODEM_ERR_BAD: the receiver sends none)
+int16_t ZModemSend_GetEscapedByte(void)
+{
+	int16_t		the_byte;
+	uint8_t		num_cancels = 1;
+
+	the_byte = ZModemSend_GetByte();
+
+	if (the_byte != ZDLE)
+	{
+		return the_byte;
+	}
+
+	for (;;)
+	{
+		the_byte = ZModemSend_GetByte();
+
+		if (the_byte < 0)
+		{
+			return the_byte;
+		}
+
+		if (the_byte == ZDLE)
+		{
+			if (++num_cancels >= ZMODEM_MAX_CANCELS)
+			{
+				return ZMODEM_ERR_REMOTE_CANCEL;
+			}
+
+			continue;
+		}
+
+		if (the_byte == ZRUB0)
+		{
+			return 0x7F;
+		}
+
+		if (the_byte == ZRUB1)
+		{
+			return 0xFF;
+		}
+
+		if ((the_byte & 0x60) == 0x40)
+		{
+			return (the_byte ^ 0x40);
+		}
+
+		return ZMODEM_ERR_BAD;
+	}
+}
+
+
+// returns the next byte of a hex header (2 hex digits), or a ZMODEM_ERR_x
+int16_t ZModemSend_GetHexByte(void)
+{
+	int16_t		the_digit;
+	uint8_t		the_value = 0;
+	uint8_t		i;
+
+	for (i = 0; i < 2; i++)
+	{
+		the_digit = ZModemSend_GetByte();
+
+		if (the_digit < 0)
+		{
+			return the_digit;
+		}
+
+		if (the_digit >= '0' && the_digit <= '9')
+		{
+			the_digit -= '0';
+		}
+		else if (the_digit >= 'a' && the_digit <= 'f')
+		{
+			the_digit -= ('a' - 10);
+		}
+		else
+		{
+			return ZMODEM_ERR_BAD;
+		}
+
+		the_value = (the_value << 4) | (uint8_t)the_digit;
+	}
+
+	return the_value;
+}
+
+
+// wait for the receiver's next header. returns its frame type, with its data bytes in zmodem_hdr, or a ZMODEM_ERR_x
+int16_t ZModemSend_ReadHeader(void)
+{
+	int16_t		the_byte;
+	int16_t		the_format;
+	uint16_t	num_skipped = 0;
+	uint8_t		num_cancels = 0;
+	uint8_t		i;
+	uint8_t		the_header[7];	// type, 4 data bytes, 2 CRC bytes
+
+	// LOGIC:
+	//   the same hunt as the receiver's (ZPAD, ZDLE, format char), but only for the formats a receiver sends:
+	//   hex ('B'), which the protocol asks receivers to use, and binary with CRC-16 ('A')
+	//   a binary CRC-32 header ('C') would need the CRC-32 tables, which are in the receive overlay. it counts as a bad
+	//   header, like line noise: the caller sends its last header again, and receivers answer that in hex.
+
+	ZModemSend_StartTimer(ZMODEM_HEADER_TIMEOUT_SECS);
+
+	for (;;)
+	{
+		the_byte = ZModemSend_GetByte();
+
+		if (the_byte < 0)
+		{
+			return the_byte;
+		}
+
+		if (the_byte == ZPAD)
+		{
+			do
+			{
+				the_byte = ZModemSend_GetByte();
+			} while (the_byte == ZPAD);
+
+			if (the_byte == ZDLE)
+			{
+				break;
+			}
+
+			if (the_byte < 0)
+			{
+				return the_byte;
+			}
+		}
+
+		if (the_byte == ZDLE)
+		{
+			if (++num_cancels >= ZMODEM_MAX_CANCELS)
+			{
+				return ZMODEM_ERR_REMOTE_CANCEL;
+			}
+		}
+		else
+		{
+			num_cancels = 0;
+		}
+
+		if (++num_skipped > ZMODEM_MAX_GARBAGE)
+		{
+			return ZMODEM_ERR_BAD;
+		}
+	}
+
+	the_format = ZModemSend_GetByte();
+
+	if (the_format != ZHEX && the_format != ZBIN)
+	{
+		return (the_format < 0 ? the_format : ZMODEM_ERR_BAD);
+	}
+
+	for (i = 0; i < 7; i++)
+	{
+		the_byte = (the_format == ZHEX ? ZModemSend_GetHexByte() : ZModemSend_GetEscapedByte());
+
+		if (the_byte < 0)
+		{
+			return the_byte;
+		}
+
+		the_header[i] = (uint8_t)the_byte;
+	}
+
+	// the CR/LF (and XON) after a hex header are skipped by the hunt for the next one
+
+	zp_from_addr = the_header;
+	zp_copy_len = 7;
+
+	if (CRC16_Update(CRC16_INITIAL_VALUE) != 0)
+	{
+		return ZMODEM_ERR_BAD;
+	}
+
+	memcpy(zmodem_hdr, &the_header[1], 4);
+
+	return the_header[0];
+}
+
+
+// returns the position carried in the last header read
+uint32_t ZModemSend_HeaderPosition(void)
+{
+	return *(uint32_t*)zmodem_hdr;	// 6502 is little-endian, same as the header
+}
+
+
+// send a hex header of the_type, with the_value as its 4 data bytes (a position, or flags)
+void ZModemSend_SendHeader(uint8_t the_type, uint32_t the_value)
+{
+	uint8_t		the_bytes[7];	// type, 4 data bytes, CRC (high byte first)
+	uint8_t		the_header[ZMODEM_HEADER_MAX_LEN];
+	uint8_t		the_len;
+	uint16_t	the_crc;
+	uint8_t		i;
+
+	the_bytes[0] = the_type;
+	memcpy(&the_bytes[1], &the_value, 4);	// low byte first, as the protocol wants
+
+	zp_from_addr = the_bytes;
+	zp_copy_len = 5;
+	the_crc = CRC16_Update(CRC16_INITIAL_VALUE);
+	the_bytes[5] = the_crc >> 8;
+	the_bytes[6] = the_crc & 0xFF;
+
+	the_header[0] = ZPAD;
+	the_header[1] = ZPAD;
+	the_header[2] = ZDLE;
+	the_header[3] = ZHEX;
+	the_len = 4;
+
+	for (i = 0; i < 7; i++)
+	{
+		the_header[the_len++] = zmodem_hex_digits[the_bytes[i] >> 4];
+		the_header[the_len++] = zmodem_hex_digits[the_bytes[i] & 0x0F];
+	}
+
+	the_header[the_len++] = CH_ENTER;
+	the_header[the_len++] = CH_LF | 0x80;
+
+	if (the_type != ZFIN && the_type != ZACK)
+	{
+		the_header[the_len++] = ZMODEM_XON;
+	}
+
+	// a ZEOF right behind streamed data can find the TX queue full: wait for room rather than drop the header
+	XModem_SendData(the_header, the_len);
+}
+
+
+// drop everything received so far, so the hunt for the next header starts on fresh data
+void ZModemSend_Purge(void)
+{
+	zmodem_in_pos = zmodem_in_len;
+	Serial_FlushInBuffer();
+}
+
+
+// returns the XMODEM_RESULT_x that a ZMODEM_ERR_x ends the session with, or XMODEM_RESULT_RUNNING if it is worth retrying
+uint8_t ZModemSend_ErrorResult(int16_t the_error)
+{
+	if (the_error == ZMODEM_ERR_CANCEL)
+	{
+		return XMODEM_RESULT_CANCELED;
+	}
+
+	if (the_error == ZMODEM_ERR_REMOTE_CANCEL)
+	{
+		return XMODEM_RESULT_REMOTE_CANCEL;
+	}
+
+	return XMODEM_RESULT_RUNNING;
+}
+
+
+// send what has been built up in zmodem_out. returns XMODEM_RESULT_RUNNING, or the XMODEM_RESULT_x the session ended with
+uint8_t ZModemSend_FlushOut(void)
+{
+	uint8_t		the_len = zmodem_out_len;
+
+	zmodem_out_len = 0;
+
+	return XModem_SendData(zmodem_out, the_len);
+}
+
+
+// add the_len bytes of the_data to zmodem_out, ZDLE-escaping the ones that can't go over the line as they are
+// sends zmodem_out whenever it fills. returns XMODEM_RESULT_RUNNING, or the XMODEM_RESULT_x the session ended with
+uint8_t ZModemSend_SendEscaped(uint8_t* the_data, uint8_t the_len)
+{
+	uint8_t		the_byte;
+	uint8_t		the_result;
+
+	while (the_len-- > 0)
+	{
+		if (zmodem_out_len >= ZMODEM_OUT_CHUNK_SIZE - 1)
+		{
+			the_result = ZModemSend_FlushOut();
+
+			if (the_result != XMODEM_RESULT_RUNNING)
+			{
+				return the_result;
+			}
+		}
+
+		the_byte = *the_data++;
+
+		switch (the_byte & 0x7F)
+		{
+			case ZDLE:
+			case ZMODEM_DLE:
+			case ZMODEM_XON:
+			case ZMODEM_XOFF:
+				zmodem_out[zmodem_out_len++] = ZDLE;
+				the_byte ^= 0x40;
+				break;
+		}
+
+		zmodem_out[zmodem_out_len++] = the_byte;
+	}
+
+	return XMODEM_RESULT_RUNNING;
+}
+
+
+// send zmodem_data/zmodem_data_len as a subpacket ended by the_end (a ZCRCx), with its CRC-16
+// returns XMODEM_RESULT_RUNNING, or the XMODEM_RESULT_x the session ended with
+uint8_t ZModemSend_SendSubpacket(uint8_t the_end)
+{
+	uint16_t	the_crc;
+	uint16_t	the_pos;
+	uint8_t		the_result = XMODEM_RESULT_RUNNING;
+	uint8_t*	the_crc_bytes = zmodem_data + zmodem_data_len + 1;
+
+	// LOGIC:
+	//   our headers are all hex, so the receiver expects CRC-16 on the subpackets too: no need for CRC-32 here
+	//   the CRC covers the data and the ZCRCx char. it goes after them in zmodem_data, to be escaped with everything else.
+
+	zmodem_data[zmodem_data_len] = the_end;
+	zp_from_addr = zmodem_data;
+	zp_copy_len = zmodem_data_len + 1;
+	the_crc = CRC16_Update(CRC16_INITIAL_VALUE);
+	the_crc_bytes[0] = the_crc >> 8;
+	the_crc_bytes[1] = the_crc & 0xFF;
+
+	for (the_pos = 0; the_pos < zmodem_data_len && the_result == XMODEM_RESULT_RUNNING; the_pos += ZMODEM_OUT_CHUNK_SIZE)
+	{
+		the_result = ZModemSend_SendEscaped(zmodem_data + the_pos, (zmodem_data_len - the_pos > ZMODEM_OUT_CHUNK_SIZE ? ZMODEM_OUT_CHUNK_SIZE : zmodem_data_len - the_pos));
+	}
+
+	if (the_result == XMODEM_RESULT_RUNNING)
+	{
+		the_result = ZModemSend_FlushOut();
+	}
+
+	if (the_result != XMODEM_RESULT_RUNNING)
+	{
+		return the_result;
+	}
+
+	zmodem_out[0] = ZDLE;
+	zmodem_out[1] = the_end;
+	zmodem_out_len = 2;
+	the_result = ZModemSend_SendEscaped(the_crc_bytes, 2);
+
+	if (the_result != XMODEM_RESULT_RUNNING)
+	{
+		return the_result;
+	}
+
+	return ZModemSend_FlushOut();
+}
+
+
+// send the staged file from the position in the receiver's ZRPOS, until the receiver has all of it (or skips it)
+// returns XMODEM_RESULT_DONE when it has, or the XMODEM_RESULT_x the session ended with
+uint8_t ZModemSend_SendFileData(void)
+{
+	uint32_t	the_pos = ZModemSend_HeaderPosition();
+	uint32_t	frame_pos;
+	int16_t		the_type;
+	uint8_t		the_end;
+	uint8_t		the_result;
+	uint8_t		num_errors = 0;
+
+	// LOGIC:
+	//   stream ZCRCG subpackets from the staging ring, which is read ahead whenever the TX queue is full
+	//   a frame ends early (ZCRCE) if anything comes in from the receiver mid-stream: it is almost always a ZRPOS after
+	//   a bad subpacket, and it is acted on before more data goes out that would only be thrown away
+	//   a receiver that can't take a whole file in one go gets ZCRCW subpackets, and a ZACK is waited for after each
+	//   either way, once the frame ends, the next header from the receiver says what next:
+	//     ZRPOS = go (back) to there, ZACK = carry on from where we are, ZRINIT = it has the whole file
+
+	for (;;)
+	{
+		if (Staging_Seek(the_pos) == false)
+		{
+			// asked for data past the end of the file
+			return XMODEM_RESULT_FAILED;
+		}
+
+		frame_pos = the_pos;
+		ZModemSend_SendHeader(ZDATA, the_pos);
+
+		do
+		{
+			zmodem_data_len = Staging_Take(zmodem_data, ZMODEM_MAX_SUBPACKET);
+			the_pos += zmodem_data_len;
+
+			if (zmodem_data_len < ZMODEM_MAX_SUBPACKET || zmodem_in_pos < zmodem_in_len || Serial_RingBytesUsed() > 0)
+			{
+				the_end = ZCRCE;
+			}
+			else
+			{
+				the_end = (zmodem_stream ? ZCRCG : ZCRCW);
+			}
+
+			the_result = ZModemSend_SendSubpacket(the_end);
+
+			if (the_result != XMODEM_RESULT_RUNNING)
+			{
+				return the_result;
+			}
+
+			if (zmodem_file_size > 0)
+			{
+				App_UpdateProgressBar((uint8_t)((the_pos * 100) / zmodem_file_size));
+			}
+		} while (the_end == ZCRCG);
+
+		if (zmodem_data_len < ZMODEM_MAX_SUBPACKET)
+		{
+			ZModemSend_SendHeader(ZEOF, the_pos);
+		}
+
+		the_type = ZModemSend_ReadHeader();
+
+		if (the_type == ZRINIT)
+		{
+			return XMODEM_RESULT_DONE;
+		}
+		else if (the_type == ZRPOS)
+		{
+			the_pos = ZModemSend_HeaderPosition();
+			num_errors = 0;
+		}
+		else if (the_type == ZSKIP)
+		{
+			sprintf(global_string_buff1, General_GetString(ID_STR_MSG_ZMODEM_SEND_SKIPPED), zmodem_name);
+			Buffer_NewMessage(global_string_buff1);
+			return XMODEM_RESULT_DONE;
+		}
+		else if (the_type == ZFIN || the_type == ZABORT || the_type == ZFERR)
+		{
+			return XMODEM_RESULT_REMOTE_CANCEL;
+		}
+		else if (the_type < 0)
+		{
+			the_result = ZModemSend_ErrorResult(the_type);
+
+			if (the_result != XMODEM_RESULT_RUNNING)
+			{
+				return the_result;
+			}
+
+			if (++num_errors >= ZMODEM_MAX_ERRORS)
+			{
+				return XMODEM_RESULT_FAILED;
+			}
+
+			// no (good) answer: send the frame again
+			the_pos = frame_pos;
+		}
+
+		// ZACK, ZNAK of our ZEOF, etc: carry on (or send ZEOF again) from the_pos
+	}
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// send the_file_path (eg, "0:myfile.bin") with ZMODEM, picking up where the receiver's copy stops if it asks us to
+// reports progress and the outcome in the comm buffer. returns true if the receiver took the file (or skipped it) and the session closed.
+// the ZMODEM send overlay must be loaded
+bool ZModemSend_SendFile(char* the_file_path)
+{
+	int16_t		the_type;
+	uint8_t		the_result = XMODEM_RESULT_RUNNING;
+	uint8_t		num_errors = 0;
+	uint8_t		the_len;
+	char*		the_name;
+	bool		size_exact;
+
+	// LOGIC:
+	//   the session: "rz" (starts a receiver on a Unix host), ZRQINIT until the receiver answers ZRINIT with what it can do,
+	//   ZFILE with the name and size, the receiver's ZRPOS (from where: 0, or where its partial copy stops) or ZSKIP,
+	//   the data, then ZFIN both ways, and we sign off with "OO".
+	//   every header we send is hex (CRC-16): slower than binary by a few bytes a frame, but no CRC-32 encoding to carry
+	//   the size comes from the directory entry (see Staging_GetFileLength()), not a read through the file.
+	//   if that's only good to the block, ZFILE goes without it (the field is optional): a receiver deciding
+	//   whether to skip or resume needs the exact size. it's still good enough for our progress bar.
+
+	zmodem_file_size = Staging_GetFileLength(the_file_path, &size_exact);
+
+	if (zmodem_file_size == STAGING_NO_FILE || Staging_OpenRead(the_file_path) == false)
+	{
+		Buffer_NewMessage(General_GetString(ID_STR_ERROR_GENERIC_DISK));
+		return false;
+	}
+
+	the_name = strchr(the_file_path, ':');
+	General_Strlcpy(zmodem_name, (the_name == NULL ? the_file_path : the_name + 1), FILE_MAX_FILENAME_SIZE);
+
+	Buffer_NewMessage(General_GetString(ID_STR_MSG_ZMODEM_SEND_WAITING));
+
+	Serial_BeginBinaryTransfer();
+	App_ShowProgressBar();
+	App_UpdateProgressBar(0);
+
+	zmodem_in_pos = 0;
+	zmodem_in_len = 0;
+	zmodem_out_len = 0;
+	ZModemSend_Purge();
+
+	XModem_SendData((uint8_t*)"rz\r", 3);
+
+	// ZRQINIT until the receiver says ZRINIT
+	do
+	{
+		ZModemSend_SendHeader(ZRQINIT, 0);
+		the_type = ZModemSend_ReadHeader();
+
+		if (the_type < 0)
+		{
+			the_result = ZModemSend_ErrorResult(the_type);
+
+			if (the_result == XMODEM_RESULT_RUNNING && ++num_errors >= ZMODEM_MAX_ERRORS)
+			{
+				the_result = XMODEM_RESULT_FAILED;
+			}
+		}
+		else if (the_type == ZABORT || the_type == ZFERR)
+		{
+			the_result = XMODEM_RESULT_REMOTE_CANCEL;
+		}
+	} while (the_type != ZRINIT && the_result == XMODEM_RESULT_RUNNING);
+
+	// ZF0 = what it can do; ZP0/ZP1 = its buffer size, 0 if it can take a whole file in one go
+	zmodem_stream = ((zmodem_hdr[3] & ZMODEM_CANOVIO) && zmodem_hdr[0] == 0 && zmodem_hdr[1] == 0);
+
+	if (the_result == XMODEM_RESULT_RUNNING)
+	{
+		sprintf(global_string_buff1, General_GetString(ID_STR_MSG_SENDING_FILE), zmodem_name, zmodem_file_size);
+		Buffer_NewMessage(global_string_buff1);
+	}
+
+	// ZFILE until the receiver says where to send from, or to skip it
+	num_errors = 0;
+	the_len = strlen(zmodem_name);
+
+	while (the_result == XMODEM_RESULT_RUNNING)
+	{
+		memcpy(zmodem_data, zmodem_name, the_len + 1);
+		zmodem_data_len = the_len + 1;
+
+		if (size_exact)
+		{
+			zmodem_data_len += sprintf((char*)zmodem_data + the_len + 1, "%lu", zmodem_file_size) + 1;
+		}
+
+		ZModemSend_SendHeader(ZFILE, 0);
+		the_result = ZModemSend_SendSubpacket(ZCRCW);
+
+		if (the_result != XMODEM_RESULT_RUNNING)
+		{
+			break;
+		}
+
+		the_type = ZModemSend_ReadHeader();
+
+		if (the_type == ZRPOS)
+		{
+			App_UpdateProgressBar(0);
+			the_result = ZModemSend_SendFileData();
+			break;
+		}
+		else if (the_type == ZSKIP)
+		{
+			sprintf(global_string_buff1, General_GetString(ID_STR_MSG_ZMODEM_SEND_SKIPPED), zmodem_name);
+			Buffer_NewMessage(global_string_buff1);
+			the_result = XMODEM_RESULT_DONE;
+		}
+		else if (the_type == ZFIN || the_type == ZABORT || the_type == ZFERR)
+		{
+			the_result = XMODEM_RESULT_REMOTE_CANCEL;
+		}
+		else if (the_type < 0)
+		{
+			the_result = ZModemSend_ErrorResult(the_type);
+
+			if (the_result == XMODEM_RESULT_RUNNING && ++num_errors >= ZMODEM_MAX_ERRORS)
+			{
+				the_result = XMODEM_RESULT_FAILED;
+			}
+		}
+
+		// a repeat ZRINIT, ZNAK, etc: offer the file again
+	}
+
+	Staging_Close();
+
+	// close the session: ZFIN until the receiver answers with its own, then "OO"
+	if (the_result == XMODEM_RESULT_DONE)
+	{
+		for (num_errors = 0; num_errors < ZMODEM_MAX_ERRORS; num_errors++)
+		{
+			ZModemSend_SendHeader(ZFIN, 0);
+			the_type = ZModemSend_ReadHeader();
+
+			if (the_type == ZFIN || the_type == ZMODEM_ERR_CANCEL || the_type == ZMODEM_ERR_REMOTE_CANCEL)
+			{
+				break;
+			}
+		}
+
+		XModem_SendData((uint8_t*)"OO", 2);
+	}
+
+	XModem_EndTransfer(the_result);
+
+	if (the_result != XMODEM_RESULT_DONE)
+	{
+		return false;
+	}
+
+	sprintf(global_string_buff1, General_GetString(ID_STR_MSG_XFER_SENT), Staging_GetPosition());
+	Buffer_NewMessage(global_string_buff1);
+
+	return true;
+}
@@ -0,0 +1,72 @@
+/*
+ * zmodem_send.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: micahbly
+ */
+
+#ifndef ZMODEM_SEND_H_
+#define ZMODEM_SEND_H_
+
+
+
+/* about this class: ZModemSend
+ *
+ * sends files from disk over the serial connection with the ZMODEM protocol, read ahead through the extended memory staging ring (see staging.h)
+ * lives in its own overlay (OVERLAY_ZMODEM_SEND), apart from the receiver (see zmodem.h), so each has an 8K overlay to itself
+ *   load it before calling in, and put OVERLAY_SCREEN back after
+ *
+ *** things this class needs to be able to do
+ *
+ * start a receiver on the host ("rz"), and find out whether it can take a whole file without stopping
+ * read the receiver's headers (hex, or binary CRC-16), and send our own (hex, CRC-16)
+ * stream a file in 1K subpackets, ZDLE-escaped, each with its CRC-16
+ * go back to wherever the receiver asks (ZRPOS), and start partway in to resume
+ * show progress, and let the user cancel with ESC
+ *
+ *** things objects of this class have
+ *
+ * a chunk of escaped data on its way to the TX queue
+ * it borrows the receiver's buffers in MAIN (received data, one subpacket, the last header): see zmodem.c
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "app.h"
+
+// C includes
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// send the_file_path (eg, "0:myfile.bin") with ZMODEM, picking up where the receiver's copy stops if it asks us to
+// reports progress and the outcome in the comm buffer. returns true if the receiver took the file (or skipped it) and the session closed.
+// the ZMODEM send overlay must be loaded
+bool ZModemSend_SendFile(char* the_file_path);
+
+
+#endif /* ZMODEM_SEND_H_ */